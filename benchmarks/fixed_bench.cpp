@@ -0,0 +1,115 @@
+/**
+ * @file fixed_bench.cpp
+ *
+ * @brief Compares the forward pass of tiny networks with a topology fixed at compile time against
+ *        NeuralNetworkFF, on the 2-2-1 truth table, 1-8-1 trig and 2-8-1 topologies
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note
+ *      to compile:
+ *          g++ benchmarks/fixed_bench.cpp -O2 -pthread -o bin/fixed_bench
+ *      to run:
+ *          ./bin/fixed_bench
+ */
+
+#include "../include/crank.h"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief Run func repeatedly for at least min_seconds and return the number of examples per second
+ *
+ */
+template <typename Func>
+double examples_per_second(Func func, int examples_per_call, double min_seconds = 0.3)
+{
+    using clock = std::chrono::steady_clock;
+
+    func(); // warm up
+
+    long calls = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    while (elapsed < min_seconds)
+    {
+        func();
+        ++calls;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    return calls * examples_per_call / elapsed;
+}
+
+void print_row(const std::string &name, double rate, double baseline)
+{
+    std::cout << "    " << std::left << std::setw(34) << name << std::right << std::setw(12) << (long)rate
+              << " examples/s" << std::setw(9) << std::fixed << std::setprecision(1) << rate / baseline << "x" << std::endl;
+}
+
+template <int... Sizes>
+void benchmark_topology()
+{
+    // Each call runs this many forward passes, so the clock is not what is measured
+    const int passes = 1000;
+
+    std::vector<int> neuron_counts = {Sizes...};
+    NeuralNetworkFF net(neuron_counts.size(), neuron_counts, 1);
+    FixedNetwork<Sizes...> fixed(net);
+    FixedNetwork32<Sizes...> fixed32(net);
+
+    constexpr int input_size = FixedNetwork<Sizes...>::input_size;
+    std::vector<std::vector<double>> inputs(passes, std::vector<double>(input_size));
+    std::vector<std::array<double, input_size>> fixed_inputs(passes);
+    std::vector<std::array<float, input_size>> fixed32_inputs(passes);
+    for (int e = 0; e < passes; ++e)
+    {
+        for (int i = 0; i < input_size; ++i)
+        {
+            inputs[e][i] = fixed_inputs[e][i] = sin(e * 0.37 + i);
+            fixed32_inputs[e][i] = (float)inputs[e][i];
+        }
+    }
+
+    std::cout << "Topology";
+    for (int count : neuron_counts)
+        std::cout << " " << count;
+    std::cout << "\n\n";
+
+    // The outputs are summed so the passes can not be optimized away
+    double sum = 0;
+    std::vector<double> output;
+    double baseline = examples_per_second([&]() {
+        for (auto &input : inputs)
+        {
+            net.forwardPass(input, output);
+            sum += output[0];
+        }
+    }, passes);
+    print_row("NeuralNetworkFF forwardPass", baseline, baseline);
+
+    print_row("FixedNetwork forwardPass", examples_per_second([&]() {
+        for (auto &input : fixed_inputs)
+            sum += fixed.forwardPass(input)[0];
+    }, passes), baseline);
+
+    print_row("FixedNetwork32 forwardPass", examples_per_second([&]() {
+        for (auto &input : fixed32_inputs)
+            sum += fixed32.forwardPass(input)[0];
+    }, passes), baseline);
+
+    std::cout << "    (checksum " << sum << ")\n" << std::endl;
+}
+
+int main()
+{
+    benchmark_topology<2, 2, 1>();
+    benchmark_topology<1, 8, 1>();
+    benchmark_topology<2, 8, 1>();
+}
@@ -0,0 +1,210 @@
+/**
+ * @file kernels_bench.cpp
+ *
+ * @brief Compares the linear algebra kernels, in double and float precision, against the per-neuron loop
+ *        the network used to run, on the 784-100-10 and 784-300-100-10 topologies
+ * @version 0.1
+ * @date 2022-04-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note
+ *      to compile:
+ *          g++ benchmarks/kernels_bench.cpp -O2 -o bin/kernels_bench
+ *      to run:
+ *          ./bin/kernels_bench
+ */
+
+#include "../include/crank.h"
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief The neuron as it was stored before the dense layers: its own weight vector, a virtual
+ *        activation function, and the previous layer passed in by value.
+ *
+ */
+struct PerNeuron
+{
+    std::vector<double> weights;
+    double bias;
+    double activation;
+    ActivationBase *activation_function;
+
+    void computeInput(std::vector<double> previousLayer, int previousLayerSize)
+    {
+        double sum = 0;
+        for (int i = 0; i < previousLayerSize; ++i)
+            sum += previousLayer[i] * weights[i];
+        sum += bias;
+        activation = activation_function->compute(sum);
+    }
+};
+
+/**
+ * @brief The forward pass as it was written before the dense layers
+ *
+ */
+struct PerNeuronNetwork
+{
+    PerNeuronNetwork(const std::vector<int> &neuron_counts)
+    {
+        neurons.resize(neuron_counts.size());
+        for (int l = 0; l < neuron_counts.size(); ++l)
+        {
+            for (int o = 0; o < neuron_counts[l]; ++o)
+            {
+                PerNeuron neuron;
+                for (int i = 0; l && i < neuron_counts[l - 1]; ++i)
+                    neuron.weights.push_back(((double)rand() / RAND_MAX) * 2 - 1);
+                neuron.bias = 0;
+                neuron.activation = 0;
+                neuron.activation_function = &sigmoid;
+                neurons[l].push_back(neuron);
+            }
+        }
+    }
+
+    void forwardPass(const std::vector<double> &input, std::vector<double> &output)
+    {
+        std::vector<double> intermediate_result(784);
+        for (int i = 0; i < neurons[0].size(); ++i)
+            intermediate_result[i] = input[i];
+
+        for (int i = 1; i < neurons.size(); ++i)
+        {
+            for (int j = 0; j < neurons[i].size(); ++j)
+                neurons[i][j].computeInput(intermediate_result, neurons[i - 1].size());
+            for (int j = 0; j < neurons[i].size(); ++j)
+                intermediate_result[j] = neurons[i][j].activation;
+        }
+
+        output.clear();
+        for (int i = 0; i < neurons.back().size(); ++i)
+            output.push_back(intermediate_result[i]);
+    }
+
+    Sigmoid sigmoid;
+    std::vector<std::vector<PerNeuron>> neurons;
+};
+
+/**
+ * @brief Run func repeatedly for at least min_seconds and return the number of examples per second
+ *
+ */
+template <typename Func>
+double examples_per_second(Func func, int examples_per_call, double min_seconds = 0.3)
+{
+    using clock = std::chrono::steady_clock;
+
+    func(); // warm up
+
+    long calls = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    while (elapsed < min_seconds)
+    {
+        func();
+        ++calls;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    return calls * examples_per_call / elapsed;
+}
+
+void print_row(const std::string &name, double rate, double baseline)
+{
+    std::cout << "    " << std::left << std::setw(34) << name << std::right << std::setw(12) << (long)rate
+              << " examples/s" << std::setw(9) << std::fixed << std::setprecision(1) << rate / baseline << "x" << std::endl;
+}
+
+void benchmark_topology(std::vector<int> neuron_counts)
+{
+    const int batch_size = 64;
+
+    NeuralNetworkFF net(neuron_counts.size(), neuron_counts);
+    NeuralNetworkFF32 float_net(neuron_counts.size(), neuron_counts);
+    PerNeuronNetwork per_neuron(neuron_counts);
+
+    std::vector<double> input(neuron_counts.front());
+    std::vector<double> expected(neuron_counts.back(), 0);
+    expected[0] = 1;
+    for (int i = 0; i < input.size(); ++i)
+        input[i] = sin(i) * 0.5 + 0.5;
+
+    Matrix batch_inputs(batch_size, neuron_counts.front());
+    Matrix batch_expected(batch_size, neuron_counts.back());
+    Matrix batch_outputs;
+    for (int e = 0; e < batch_size; ++e)
+    {
+        std::copy(input.begin(), input.end(), batch_inputs.row(e));
+        std::copy(expected.begin(), expected.end(), batch_expected.row(e));
+    }
+
+    std::vector<float> float_input(input.begin(), input.end());
+    std::vector<float> float_expected(expected.begin(), expected.end());
+    Matrix32 float_batch_inputs(batch_size, neuron_counts.front());
+    Matrix32 float_batch_expected(batch_size, neuron_counts.back());
+    Matrix32 float_batch_outputs;
+    for (int e = 0; e < batch_size; ++e)
+    {
+        std::copy(input.begin(), input.end(), float_batch_inputs.row(e));
+        std::copy(expected.begin(), expected.end(), float_batch_expected.row(e));
+    }
+
+    std::cout << "Topology";
+    for (int count : neuron_counts)
+        std::cout << " " << count;
+    std::cout << "\n\n  Inference\n";
+
+    std::vector<double> output;
+    std::vector<float> float_output;
+    double baseline = examples_per_second([&]() { per_neuron.forwardPass(input, output); }, 1);
+    print_row("per-neuron loop (before)", baseline, baseline);
+
+    for (auto isa : {kernels::Isa::Scalar, kernels::Isa::AVX2, kernels::Isa::AVX512})
+    {
+        if (!kernels::select(isa))
+            continue;
+
+        std::string name = kernels::isa_name(isa);
+        print_row("forwardPass " + name, examples_per_second([&]() { net.forwardPass(input, output); }, 1), baseline);
+        print_row("forwardBatch(64) " + name, examples_per_second([&]() { net.forwardBatch(batch_inputs, batch_outputs); }, batch_size), baseline);
+        print_row("forwardPass float " + name, examples_per_second([&]() { float_net.forwardPass(float_input, float_output); }, 1), baseline);
+        print_row("forwardBatch(64) float " + name, examples_per_second([&]() { float_net.forwardBatch(float_batch_inputs, float_batch_outputs); }, batch_size), baseline);
+    }
+
+    std::cout << "\n  Training (forward, backprop and update_weights)\n";
+
+    kernels::select(kernels::Isa::Scalar);
+    double train_baseline = examples_per_second([&]() { net.train_on_example(input, expected); net.update_weights(0); }, 1);
+
+    for (auto isa : {kernels::Isa::Scalar, kernels::Isa::AVX2, kernels::Isa::AVX512})
+    {
+        if (!kernels::select(isa))
+            continue;
+
+        std::string name = kernels::isa_name(isa);
+        print_row("train_on_example " + name, examples_per_second([&]() { net.train_on_example(input, expected); net.update_weights(0); }, 1), train_baseline);
+        print_row("trainBatch(64) " + name, examples_per_second([&]() { net.trainBatch(batch_inputs, batch_expected); net.update_weights(0); }, batch_size), train_baseline);
+        print_row("trainBatch(64) float " + name, examples_per_second([&]() { float_net.trainBatch(float_batch_inputs, float_batch_expected); float_net.update_weights(0); }, batch_size), train_baseline);
+    }
+
+    std::cout << std::endl;
+}
+
+int main()
+{
+    std::cout << "Kernels available:";
+    for (auto isa : {kernels::Isa::Scalar, kernels::Isa::AVX2, kernels::Isa::AVX512})
+        if (kernels::supported(isa))
+            std::cout << " " << kernels::isa_name(isa);
+    std::cout << "\n\n";
+
+    benchmark_topology({784, 100, 10});
+    benchmark_topology({784, 300, 100, 10});
+}
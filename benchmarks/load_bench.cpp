@@ -0,0 +1,87 @@
+/**
+ * @file load_bench.cpp
+ *
+ * @brief Measures how fast a model file is saved and loaded, as text and in the binary format
+ * @version 0.1
+ * @date 2022-04-18
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note
+ *      to compile:
+ *          g++ benchmarks/load_bench.cpp -O2 -pthread -o bin/load_bench
+ *      to run:
+ *          ./bin/load_bench [model file, examples/MNIST/trained.net by default]
+ */
+
+#include "../include/crank.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+/**
+ * @brief The fastest time to load a file out of several tries, in seconds
+ *
+ */
+double time_load(const std::string &filename, int repetitions)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        NeuralNetworkFF net(filename);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+/**
+ * @brief The fastest time to save a network as text out of several tries, in seconds
+ *
+ */
+double time_save(const NeuralNetworkFF &net, const std::string &filename, int repetitions)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        net.save_to_file(filename);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+size_t file_size(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file.tellg();
+}
+
+int main(int argc, char **argv)
+{
+    std::string filename = argc > 1 ? argv[1] : "examples/MNIST/trained.net";
+    std::string text_filename = "load_bench_model.net";
+    std::string binary_filename = "load_bench_model.bin";
+
+    NeuralNetworkFF net(filename);
+    net.save_binary(binary_filename);
+
+    double save_time = time_save(net, text_filename, 50);
+    double text_time = time_load(filename, 50);
+    double binary_time = time_load(binary_filename, 50);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Text   " << file_size(filename) / 1e6 << " MB  " << text_time * 1e3 << " ms  "
+              << file_size(filename) / text_time / 1e6 << " MB/s" << std::endl;
+    std::cout << "Save   " << file_size(text_filename) / 1e6 << " MB  " << save_time * 1e3 << " ms  "
+              << file_size(text_filename) / save_time / 1e6 << " MB/s" << std::endl;
+    std::cout << "Binary " << file_size(binary_filename) / 1e6 << " MB  " << binary_time * 1e3 << " ms" << std::endl;
+
+    std::remove(text_filename.c_str());
+    std::remove(binary_filename.c_str());
+}
@@ -0,0 +1,80 @@
+/**
+ * @file parallel_bench.cpp
+ *
+ * @brief Measures how data-parallel training scales with the number of threads, on the
+ *        784-100-10 and 784-300-100-10 topologies
+ * @version 0.1
+ * @date 2022-04-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note
+ *      to compile:
+ *          g++ benchmarks/parallel_bench.cpp -O2 -pthread -o bin/parallel_bench
+ *      to run:
+ *          ./bin/parallel_bench [batch size]
+ */
+
+#include "../include/crank.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void benchmark_topology(std::vector<int> neuron_counts, int batch_size)
+{
+    const int num_examples = 4096;
+
+    // MNIST-sized inputs with one-hot expected outputs
+    std::vector<std::vector<double>> examples(num_examples, std::vector<double>(neuron_counts.front()));
+    std::vector<std::vector<double>> expected(num_examples, std::vector<double>(neuron_counts.back(), 0));
+    for (int e = 0; e < num_examples; ++e)
+    {
+        for (int i = 0; i < examples[e].size(); ++i)
+            examples[e][i] = sin(e * 31 + i) * 0.5 + 0.5;
+        expected[e][e % expected[e].size()] = 1;
+    }
+
+    std::cout << "Topology";
+    for (int count : neuron_counts)
+        std::cout << " " << count;
+    std::cout << ", batch size " << batch_size << "\n\n";
+
+    NeuralNetworkFF initial(neuron_counts.size(), neuron_counts);
+    double single_thread_rate = 0;
+
+    for (int num_threads : {1, 2, 4, 8, 16})
+    {
+        NeuralNetworkFF net(initial);
+
+        NeuralNetworkFF::TrainConfig config;
+        config.batch_size = batch_size;
+        config.num_threads = num_threads;
+
+        auto start = std::chrono::steady_clock::now();
+        net.train(examples.begin(), examples.end(), expected.begin(), expected.end(), &config);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double rate = num_examples / elapsed;
+        if (num_threads == 1)
+            single_thread_rate = rate;
+
+        std::cout << "    " << std::setw(2) << num_threads << " threads" << std::setw(12) << (long)rate << " examples/s"
+                  << std::setw(8) << std::fixed << std::setprecision(2) << rate / single_thread_rate << "x" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int batch_size = argc > 1 ? atoi(argv[1]) : 256;
+
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+
+    benchmark_topology({784, 100, 10}, batch_size);
+    benchmark_topology({784, 300, 100, 10}, batch_size);
+}
@@ -5,11 +5,23 @@ Build and run the test suite
 from os import system
 
 print("Building...")
-system("g++ tests/fftests/backprop.cpp -D NN_DEBUG -g3 -o bin/backprop_tests")
-system("g++ tests/fftests/fftests.cpp -g3 -o bin/fftests_test")
+system("g++ tests/fftests/backprop.cpp -D NN_DEBUG -g3 -pthread -o bin/backprop_tests")
+system("g++ tests/fftests/fftests.cpp -g3 -pthread -o bin/fftests_test")
+system("g++ tests/fftests/allocation.cpp -g3 -pthread -o bin/allocation_tests")
+system("g++ tests/fftests/kernels.cpp -g3 -pthread -o bin/kernels_tests")
+system("g++ tests/fftests/serialization.cpp -g3 -pthread -o bin/serialization_tests")
+system("g++ tests/fftests/random.cpp -g3 -pthread -o bin/random_tests")
+system("g++ tests/fftests/quantized.cpp -g3 -pthread -o bin/quantized_tests")
+system("g++ tests/fftests/idx.cpp -g3 -o bin/idx_tests")
 
 print("\n\nBuilding complete.")
 print("Running tests...\n\n")
 
 system("./bin/backprop_tests")
 system("./bin/fftests_test")
+system("./bin/allocation_tests")
+system("./bin/kernels_tests")
+system("./bin/serialization_tests")
+system("./bin/random_tests")
+system("./bin/quantized_tests")
+system("./bin/idx_tests")
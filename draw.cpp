@@ -26,7 +26,7 @@
 
 using namespace xd;
 
-MNIST_DATASET * dataset; 
+std::vector<uint8_t> drawn_image(784); // What was drawn, as an MNIST image
 
 static const int cols = 600;
 static const int rows = 600;
@@ -49,11 +49,11 @@ int make_prediction(std::vector<std::vector<bool>> & pix){
     for(int i = 0; i < 28; ++i){
         for(int j = 0; j < 28; ++j){
             input[index] = pix[i][j] ? 1 : 0;
-            dataset->test_images[0][index] = pix[i][j] ? 100 : 0;
+            drawn_image[index] = pix[i][j] ? 100 : 0;
             ++index; 
         }
     }
-    dataset->display_image(0, dataset->test_images); 
+    display_image(drawn_image); 
     auto result = net.forwardPass(input); 
 
     int max_index = 0;
@@ -97,7 +97,6 @@ void onMouseReleased(int button)
 
 void setup()
 {
-    dataset = read_dataset(); 
     mypixels = std::vector<std::vector<bool>>(28, std::vector<bool>(28, false));
     mouseReleased(onMouseReleased);
     mouseMoved(onMouseMoved);
@@ -22,10 +22,10 @@
 #include <iostream>
 
 static int example_index = 0;
-static MNIST_DATASET *dataset;
+static const MappedMnistDataset *dataset;
 
-std::vector<std::vector<uint8_t>> *images;
-std::vector<uint8_t> *labels;
+const MnistImages *images;
+Span<const uint8_t> labels;
 
 /**
  * @brief This is the ExampleIterator. It is used to provide examples for training the net
@@ -127,7 +127,7 @@ public:
     {
         for (auto &val : expect)
             val = 0;
-        expect[(*labels)[example_index]] = 1;
+        expect[labels[example_index]] = 1;
         return expect;
     }
 
@@ -166,13 +166,20 @@ public:
 
 int main()
 {
-    dataset = read_dataset(); // Read MNIST from memory
+    MappedMnistDataset mnist; // Map MNIST into memory, nothing is copied
+    dataset = &mnist;
     
     // Step 1: Create the neural network with random weights and bias'
     int num_layers = 3;
     std::vector<int> neuron_counts = {784, 100, 10};
     NeuralNetworkFF net(num_layers, neuron_counts);
 
+    // Train on softmax cross-entropy, which needs the output layer to give the logits
+    SoftmaxCrossEntropy loss;
+    Linear logits(1);
+    net.set_loss_function(&loss);
+    net.set_activation_function(num_layers - 1, &logits);
+
     // Step 2: Create the examples and expectation iterators
     ExampleIterator examples;
     ExpectIterator expect(true);
@@ -183,8 +190,8 @@ int main()
     NeuralNetworkFF::TestConfig test_config;
     test_config.max_examples = 10000;
     example_index = 0;
-    images = &dataset->test_images; 
-    labels = &dataset->test_labels; 
+    images = &dataset->test_images();
+    labels = dataset->test_labels();
     NeuralNetworkFF::TestResults results = net.test(examples, examples_end, expect, expect_end, outputcmp, &test_config);
     std::cout << "Pretraining Results" << std::endl; 
     std::cout << results << std::endl;
@@ -198,8 +205,8 @@ int main()
     train_config.num_training_examples = 60000;
 
     // Step 4: Train
-    images = &dataset->training_images;
-    labels = &dataset->training_labels; 
+    images = &dataset->training_images();
+    labels = dataset->training_labels();
     example_index = 0;  
     std::cout << "Training Run 1 | Learnings Rate 0.1" << std::endl; 
     net.train(examples, examples_end, expect, expect_end, &train_config);
@@ -211,8 +218,8 @@ int main()
 
     // Step 6: Test and print the test results
     example_index = 0;
-    images = &dataset->test_images; 
-    labels = &dataset->test_labels; 
+    images = &dataset->test_images();
+    labels = dataset->test_labels();
     results = net.test(examples, examples, expect, expect, outputcmp, &test_config);
     std::cout << "Post Training Results" << std::endl; 
     std::cout << results << std::endl;
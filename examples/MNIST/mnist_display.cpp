@@ -1,7 +1,7 @@
 /**
  * This example is how to use the MNIST dataset. 
  * 
- * To compile, use "g++ examples/MNIST/mnist_display.cpp src/mnist/mnist.cpp -o examples/MNIST/mnist_display_example"
+ * To compile, use "g++ examples/MNIST/mnist_display.cpp -o examples/MNIST/mnist_display_example"
  * To run, use "./examples/MNIST/mnist_display_example"
  * 
  */
@@ -13,15 +13,15 @@ int main(){
 
     int index = 100; 
     
-    // Load the MNIST dataset into memory
+    // Map the MNIST dataset into memory
     // It is assumed that the MNIST files are in the data directory 
-    MNIST_DATASET * dataset = read_dataset(); 
+    MappedMnistDataset dataset; 
 
     // Get and display an image from the testing set
-    dataset -> display_image(index, dataset->test_images); 
-    std::cout << (int) dataset->test_labels[index] << std::endl;
+    display_image(dataset.test_images()[index]); 
+    std::cout << (int) dataset.test_labels()[index] << std::endl;
 
     // Get and display an image from the training set
-    dataset -> display_image(index, dataset->training_images); 
-    std::cout << (int) dataset->training_labels[index] << std::endl;
+    display_image(dataset.training_images()[index]); 
+    std::cout << (int) dataset.training_labels()[index] << std::endl;
 }
\ No newline at end of file
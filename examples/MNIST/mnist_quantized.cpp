@@ -0,0 +1,85 @@
+/**
+ * @file mnist_quantized.cpp
+ *
+ * @brief Quantizes the trained MNIST network to 8 bit weights, and compares its accuracy and speed on the
+ *        test set against the double and float networks
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note
+ *      to compile:
+ *          g++ examples/MNIST/mnist_quantized.cpp -O2 -pthread -o bin/mnist_quantized_example
+ *
+ *      to run:
+ *          ./bin/mnist_quantized_example
+ */
+
+#include "../../include/crank.h"
+#include "../../include/mnist/mnist.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief The fraction of the test images a network labels correctly, and how many it labels a second
+ *
+ */
+template <typename Network, typename Input>
+void evaluate(const std::string &name, const Network &network, const std::vector<std::vector<Input>> &images,
+              Span<const uint8_t> labels)
+{
+    auto output = network.forwardPass(images[0]);
+    int correct = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        network.forwardPass(images[i], output);
+        correct += std::max_element(output.begin(), output.end()) - output.begin() == labels[i];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ": " << 100.0 * correct / images.size() << "% correct, "
+              << (long)(images.size() / seconds) << " images/s" << std::endl;
+}
+
+int main()
+{
+    std::unique_ptr<MappedMnistDataset> dataset;
+    try
+    {
+        dataset.reset(new MappedMnistDataset("./data/"));
+    }
+    catch (const std::runtime_error &error)
+    {
+        std::cout << error.what() << std::endl;
+        return 1;
+    }
+    const MnistImages &training_images = dataset->training_images();
+    const MnistImages &mnist_test_images = dataset->test_images();
+
+    NeuralNetworkFF net("examples/MNIST/trained.net");
+    NeuralNetworkFF32 float_net("examples/MNIST/trained.net");
+
+    // The network was trained on the raw pixel values
+    std::vector<std::vector<double>> test_images, calibration_images;
+    for (size_t i = 0; i < mnist_test_images.size(); ++i)
+        test_images.emplace_back(mnist_test_images[i].begin(), mnist_test_images[i].end());
+    for (int i = 0; i < 500; ++i)
+        calibration_images.emplace_back(training_images[i].begin(), training_images[i].end());
+
+    std::vector<std::vector<float>> float_test_images;
+    for (auto &image : test_images)
+        float_test_images.emplace_back(image.begin(), image.end());
+
+    QuantizedNetworkFF quantized(net, calibration_images.begin(), calibration_images.end());
+
+    evaluate("double", net, test_images, dataset->test_labels());
+    evaluate("float", float_net, float_test_images, dataset->test_labels());
+    evaluate("int8", quantized, float_test_images, dataset->test_labels());
+}
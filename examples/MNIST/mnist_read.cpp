@@ -22,10 +22,10 @@
 #include <iostream>
 
 static int example_index = 0;
-static MNIST_DATASET *dataset;
+static const MappedMnistDataset *dataset;
 
-std::vector<std::vector<uint8_t>> *images;
-std::vector<uint8_t> *labels;
+const MnistImages *images;
+Span<const uint8_t> labels;
 
 /**
  * @brief This is the ExampleIterator. It is used to provide examples for training the net
@@ -127,7 +127,7 @@ public:
     {
         for (auto &val : expect)
             val = 0;
-        expect[(*labels)[example_index]] = 1;
+        expect[labels[example_index]] = 1;
         return expect;
     }
 
@@ -166,7 +166,8 @@ public:
 
 int main()
 {
-    dataset = read_dataset(); // Read MNIST from memory
+    MappedMnistDataset mnist; // Map MNIST into memory, nothing is copied
+    dataset = &mnist;
     
     // Step 1: Create the neural network with random weights and bias'
     NeuralNetworkFF net("examples/MNIST/trained.net");
@@ -181,8 +182,8 @@ int main()
     NeuralNetworkFF::TestConfig test_config;
     test_config.max_examples = 10000;
     example_index = 0;
-    images = &dataset->test_images; 
-    labels = &dataset->test_labels; 
+    images = &dataset->test_images();
+    labels = dataset->test_labels();
     NeuralNetworkFF::TestResults results = net.test(examples, examples_end, expect, expect_end, outputcmp, &test_config); 
     std::cout << results << std::endl;
 }
\ No newline at end of file
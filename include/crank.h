@@ -1,5 +1,10 @@
 #include "ff/ff.h"
 #include "ff/activation.h"
+#include "ff/evolution_trainer.h"
+#include "ff/fixed_network.h"
+#include "ff/quantized.h"
 #include "ff/learning_functions.h"
+#include "ff/loss_functions.h"
 #include "ff/sigmoid.h"
+#include "ff/activation_functions.h"
 #include "ff/neuron.h"
\ No newline at end of file
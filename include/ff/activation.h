@@ -18,6 +18,55 @@
 #define ACTIVATION_H
 
 #include <string> 
+#include <string_view>
+#include "span.h"
+
+/**
+ * @brief A class that represents the possible activation functions one can use. Layers use this to
+ *        pick the code for the built in functions once per layer, instead of once per neuron.
+ *        The values are stored in binary model files, so they must never change.
+ *
+ */
+enum class ActivationFunctions
+{
+    Sigmoid = 0,
+    Linear = 1,    // parameter: the slope
+    ReLU = 2,
+    LeakyReLU = 3, // parameter: the slope for negative inputs
+    ELU = 4,       // parameter: alpha, the value negative inputs approach
+    GELU = 5,
+    Tanh = 6,
+    Softmax = 7,   // Applied to the whole layer at once
+    Custom = 255 // Any other class derived from ActivationBase, these can not be saved in binary files
+};
+
+/**
+ * @brief The name a built in activation function goes by in text model files ("sigmoid", "leaky_relu", ...)
+ *
+ * @return const char* - the name, or nullptr for Custom
+ */
+const char *activation_function_name(ActivationFunctions type);
+
+/**
+ * @brief Look up a built in activation function by the name it goes by in text model files
+ *
+ * @return ActivationFunctions - the function, or Custom if there is none by that name
+ */
+ActivationFunctions activation_function_from_name(std::string_view name);
+
+/**
+ * @brief Whether a built in activation function has a parameter (see ActivationBase::parameter),
+ *        which text model files write after its name
+ *
+ */
+bool activation_function_has_parameter(ActivationFunctions type);
+
+/**
+ * @brief The text model file form of a built in activation function: its name, followed by its
+ *        parameter if it has one
+ *
+ */
+std::string activation_function_repr(ActivationFunctions type, double parameter);
 
 class ActivationBase{
 
@@ -51,7 +100,51 @@ public:
     virtual double derivative(double x) = 0; 
 
     /**
-     * @brief Get the external representation of the activation function
+     * @brief Which of the activation functions this is
+     * 
+     * @return ActivationFunctions - Custom unless overriden
+     */
+    virtual ActivationFunctions type(); 
+
+    /**
+     * @brief The parameter of the function (the slope of Linear), stored along with the type in binary model files
+     * 
+     * @return double - 0 unless overriden
+     */
+    virtual double parameter(); 
+
+    /**
+     * @brief Apply the activation function to every value of input. input and output may be the same span.
+     *        The default calls compute on each value, the built in functions override it with a vectorized version.
+     * 
+     * @param input - the neuron inputs
+     * @param output - where the activations are written
+     */
+    virtual void apply(Span<const double> input, Span<double> output); 
+
+    /**
+     * @brief Compute the derivative for every neuron of a layer, given both the inputs and the activations
+     *        they produced. Functions whose derivative can be written in terms of their output (sigmoid)
+     *        use output and never recompute the function. The default calls derivative on each input.
+     * 
+     * @param input - the neuron inputs
+     * @param output - the activations computed from input
+     * @param derivative - where the derivatives are written
+     */
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative); 
+
+    /**
+     * @brief The single precision versions of apply and derivative_from_output, used by float networks.
+     *        The defaults go through compute and derivative one value at a time, the built in functions
+     *        override them with float kernels.
+     * 
+     */
+    virtual void apply(Span<const float> input, Span<float> output); 
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative); 
+
+    /**
+     * @brief Get the external representation of the activation function. For the built in functions this
+     *        is what follows "activation" in text model files.
      * 
      * @return std::string 
      */
@@ -93,12 +186,40 @@ public:
      * @param x 
      * @return double 
      */
-    inline virtual double derivative(double x){
+    inline virtual double derivative(double /*x*/){
         return slope;
     }
 
+    inline virtual ActivationFunctions type(){
+        return ActivationFunctions::Linear; 
+    }
+
+    inline virtual double parameter(){
+        return slope; 
+    }
+
+    inline virtual void apply(Span<const double> input, Span<double> output){
+        for(size_t i = 0; i < input.size(); ++i)
+            output[i] = input[i] * slope; 
+    }
+
+    inline virtual void derivative_from_output(Span<const double> input, Span<const double> /*output*/, Span<double> derivative){
+        for(size_t i = 0; i < input.size(); ++i)
+            derivative[i] = slope; 
+    }
+
+    inline virtual void apply(Span<const float> input, Span<float> output){
+        for(size_t i = 0; i < input.size(); ++i)
+            output[i] = input[i] * (float)slope; 
+    }
+
+    inline virtual void derivative_from_output(Span<const float> input, Span<const float> /*output*/, Span<float> derivative){
+        for(size_t i = 0; i < input.size(); ++i)
+            derivative[i] = slope; 
+    }
+
     inline virtual std::string to_external_repr(){
-        return "Linear";
+        return activation_function_repr(ActivationFunctions::Linear, slope);
     }
 
 private: 
@@ -0,0 +1,214 @@
+/**
+ * @file activation_functions.h
+ *
+ * @brief The built in activation functions besides the sigmoid and Linear
+ * @version 0.1
+ * @date 2022-04-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ACTIVATION_FUNCTIONS_H
+#define ACTIVATION_FUNCTIONS_H
+
+#include "activation.h"
+
+/**
+ * @brief The rectified linear unit, max(0, x)
+ *
+ */
+class ReLU : public ActivationBase
+{
+
+public:
+
+    virtual double operator()(double x);
+    virtual double compute(double x);
+    virtual double derivative(double x);
+    virtual ActivationFunctions type();
+    virtual void apply(Span<const double> input, Span<double> output);
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative);
+    virtual void apply(Span<const float> input, Span<float> output);
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative);
+    virtual std::string to_external_repr();
+
+};
+
+/**
+ * @brief x for positive x, otherwise slope * x, so that neurons with negative inputs still learn
+ *
+ */
+class LeakyReLU : public ActivationBase
+{
+
+public:
+
+    explicit LeakyReLU(double slope = 0.01) : slope(slope) {}
+
+    virtual double operator()(double x);
+    virtual double compute(double x);
+    virtual double derivative(double x);
+    virtual ActivationFunctions type();
+
+    /**
+     * @brief The slope for negative inputs
+     *
+     */
+    virtual double parameter();
+
+    virtual void apply(Span<const double> input, Span<double> output);
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative);
+    virtual void apply(Span<const float> input, Span<float> output);
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative);
+    virtual std::string to_external_repr();
+
+private:
+
+    double slope;
+
+};
+
+/**
+ * @brief The exponential linear unit: x for positive x, otherwise alpha * (e^x - 1), which approaches -alpha
+ *
+ */
+class ELU : public ActivationBase
+{
+
+public:
+
+    explicit ELU(double alpha = 1) : alpha(alpha) {}
+
+    virtual double operator()(double x);
+    virtual double compute(double x);
+    virtual double derivative(double x);
+    virtual ActivationFunctions type();
+
+    /**
+     * @brief alpha
+     *
+     */
+    virtual double parameter();
+
+    virtual void apply(Span<const double> input, Span<double> output);
+
+    /**
+     * @brief For negative inputs the derivative is alpha * e^x, which is output + alpha
+     *
+     */
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative);
+    virtual void apply(Span<const float> input, Span<float> output);
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative);
+
+    virtual std::string to_external_repr();
+
+private:
+
+    double alpha;
+
+};
+
+/**
+ * @brief The Gaussian error linear unit, x * P(X <= x) for a standard normal X, in its usual tanh approximation
+ *        0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 x^3)))
+ *
+ */
+class GELU : public ActivationBase
+{
+
+public:
+
+    virtual double operator()(double x);
+    virtual double compute(double x);
+    virtual double derivative(double x);
+    virtual ActivationFunctions type();
+    virtual void apply(Span<const double> input, Span<double> output);
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative);
+    virtual void apply(Span<const float> input, Span<float> output);
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative);
+    virtual std::string to_external_repr();
+
+};
+
+/**
+ * @brief The hyperbolic tangent
+ *
+ */
+class Tanh : public ActivationBase
+{
+
+public:
+
+    virtual double operator()(double x);
+    virtual double compute(double x);
+    virtual double derivative(double x);
+    virtual ActivationFunctions type();
+    virtual void apply(Span<const double> input, Span<double> output);
+
+    /**
+     * @brief The derivative of tanh is 1 - tanh^2, so it only needs the output
+     *
+     */
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative);
+    virtual void apply(Span<const float> input, Span<float> output);
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative);
+
+    virtual std::string to_external_repr();
+
+};
+
+/**
+ * @brief The softmax, e^x / (sum of e^x over the layer), which turns a layer into probabilities that add up
+ *        to 1. Unlike the other functions each output depends on every input of the layer, so every neuron
+ *        in a layer must use it, and layers apply it to each example separately. Backprop uses its full
+ *        Jacobian, or the fused gradient of CategoricalCrossEntropy.
+ *
+ */
+class Softmax : public ActivationBase
+{
+
+public:
+
+    /**
+     * @brief The softmax has no value for a single neuron
+     *
+     * @throws std::logic_error
+     */
+    virtual double operator()(double x);
+
+    /**
+     * @brief The softmax has no value for a single neuron
+     *
+     * @throws std::logic_error
+     */
+    virtual double compute(double x);
+
+    /**
+     * @brief The softmax has no derivative for a single neuron
+     *
+     * @throws std::logic_error
+     */
+    virtual double derivative(double x);
+
+    virtual ActivationFunctions type();
+
+    /**
+     * @brief The softmax of the whole of input, with the largest input subtracted first so that exp never overflows
+     *
+     */
+    virtual void apply(Span<const double> input, Span<double> output);
+
+    /**
+     * @brief The diagonal of the Jacobian, output * (1 - output)
+     *
+     */
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative);
+    virtual void apply(Span<const float> input, Span<float> output);
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative);
+
+    virtual std::string to_external_repr();
+
+};
+
+#endif
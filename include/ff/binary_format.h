@@ -0,0 +1,83 @@
+/**
+ * @file binary_format.h
+ *
+ * @brief The layout of the binary model files written by NeuralNetworkFF::save_binary
+ * @version 0.1
+ * @date 2022-04-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+/**
+ * @brief A binary model file is laid out as follows. All values are in the byte order of the
+ *        machine that wrote the file, which is recorded in the header.
+ *
+ *          BinaryHeader                        64 bytes
+ *          BinaryLayer     x num_layers        the neuron count and activation count of each layer
+ *          BinaryActivation x (total activation count)
+ *                                              one per layer when every neuron in the layer uses
+ *                                              the same function, otherwise one per neuron
+ *          padding to a multiple of 64 bytes
+ *          parameters                          num_parameters float64 or float32 values, in the same
+ *                                              layout as NeuralNetworkFF::parameters (for each layer,
+ *                                              the outputs x inputs weights row-major, then the bias')
+ *
+ *        The checksum covers the whole file, with the checksum field of the header taken as 0. Because the parameters are aligned, a network
+ *        of the same precision (NeuralNetworkFF for float64, NeuralNetworkFF32 for float32) uses them
+ *        where they are mapped, without copying. Networks of the other precision convert them.
+ */
+
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The precision the parameters are stored in
+ *
+ */
+enum class BinaryPrecision
+{
+    Float64, // Exact for double networks, and used in place when one loads the file
+    Float32  // Half the size, exact for float networks, and used in place when one loads the file
+};
+
+static const char BINARY_MAGIC[8] = {'C', 'R', 'A', 'N', 'K', 'N', 'N', '\0'};
+static const uint32_t BINARY_VERSION = 2;
+static const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+static const size_t BINARY_ALIGNMENT = 64;
+
+struct BinaryHeader
+{
+    char magic[8];             // BINARY_MAGIC
+    uint32_t version;          // BINARY_VERSION
+    uint32_t byte_order;       // BINARY_BYTE_ORDER as written by the machine that saved the file
+    uint32_t scalar_size;      // 8 for float64 parameters, 4 for float32
+    uint32_t num_layers;       // Including the input layer
+    uint64_t num_parameters;   // The number of weights and bias'
+    uint64_t parameter_offset; // Where the parameters start, from the start of the file
+    uint64_t file_size;        // The size of the whole file
+    uint64_t checksum;         // binary_file_checksum of the whole file
+    uint64_t reserved;         // 0
+};
+
+struct BinaryLayer
+{
+    uint32_t neurons;
+    uint32_t activation_count; // 1 if every neuron uses the same function, otherwise neurons
+};
+
+struct BinaryActivation
+{
+    uint32_t type;     // An ActivationFunctions value
+    uint32_t reserved; // 0
+    double parameter;  // ActivationBase::parameter()
+};
+
+static_assert(sizeof(BinaryHeader) == 64, "The binary header must be 64 bytes");
+static_assert(sizeof(BinaryLayer) == 8, "Binary layer records must be 8 bytes");
+static_assert(sizeof(BinaryActivation) == 16, "Binary activation records must be 16 bytes");
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * @file evolution_trainer.h
+ *
+ * @brief Trains a population of forward feed neural networks with a genetic algorithm on several threads
+ * @version 0.1
+ * @date 2022-04-23
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef EVOLUTION_TRAINER_H
+#define EVOLUTION_TRAINER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "random.h"
+#include "thread_pool.h"
+
+template <typename Scalar>
+class BasicNeuralNetworkFF;
+
+/**
+ * @brief Evolves a population of networks with the same shape, working on their flat parameter vectors.
+ *        Every generation the fitness of each organism is measured in parallel, the best elite_count
+ *        are carried over unchanged, and the rest of the next generation is bred from selected parents
+ *        by crossover and mutation, also in parallel.
+ *
+ *        The population is allocated once: the next generation is written into a second population,
+ *        and the two are swapped, so no network is created or destroyed after the constructor.
+ *
+ *        Each thread draws from its own stream of the seed, so evolution is deterministic for a given seed and number of threads (as long as the fitness is).
+ *
+ * @tparam Scalar - the scalar type of the networks, double or float
+ */
+template <typename Scalar>
+class BasicEvolutionTrainer
+{
+public:
+    using Network = BasicNeuralNetworkFF<Scalar>;
+
+    /**
+     * @brief How the parents of each child are picked
+     *
+     */
+    enum class Selection
+    {
+        Tournament, // The fittest of selection_size organisms picked at random
+        Truncation  // Any of the selection_size fittest organisms
+    };
+
+    /**
+     * @brief How the parameters of two parents are combined
+     *
+     */
+    enum class Crossover
+    {
+        Uniform,     // Each parameter comes from either parent
+        Average,     // Each parameter is the mean of the parents'
+        SinglePoint  // The parameters before a random point come from one parent, the rest from the other
+    };
+
+    /**
+     * @brief The settings of the genetic algorithm
+     *
+     */
+    struct Config
+    {
+        int population_size = 100;
+        int elite_count = 2; // The fittest organisms, copied into the next generation unchanged
+        Selection selection = Selection::Tournament;
+        int selection_size = 3;
+        Crossover crossover = Crossover::Uniform;
+        double mutation_rate = 0.1; // The chance of each parameter of a child being mutated
+        double mutation_size = 0.2; // The standard deviation of the normally distributed mutations
+        int num_threads = 1;        // Fitness and breeding are split across this many threads
+        uint64_t seed = 0;          // 0 takes a seed from thread_random()
+    };
+
+    /**
+     * @brief The fitness of an organism, higher is better. Called from several threads at once, each
+     *        time with a different network.
+     *
+     */
+    using FitnessFunction = std::function<double(const Network &)>;
+
+    /**
+     * @brief Create the population. The first organism is a copy of the prototype, every other one is
+     *        the prototype with every parameter mutated by mutation_size.
+     *
+     * @param prototype - the shape, activation functions and starting parameters of the organisms
+     * @param config - the settings of the genetic algorithm
+     * @throws std::invalid_argument if the population is empty, elite_count is not in [0, population_size]
+     *         or selection_size is not in [1, population_size]
+     */
+    BasicEvolutionTrainer(const Network &prototype, const Config &config);
+
+    ~BasicEvolutionTrainer();
+
+    BasicEvolutionTrainer(const BasicEvolutionTrainer &) = delete;
+    BasicEvolutionTrainer &operator=(const BasicEvolutionTrainer &) = delete;
+
+    /**
+     * @brief Measure the fitness of the population and replace it with the next generation
+     *
+     * @param fitness - the fitness of an organism. If it throws, the exception is rethrown here once
+     *                  every thread has finished, and the population is left as it was.
+     * @return double - the best fitness of the generation that was measured
+     */
+    double step(const FitnessFunction &fitness);
+
+    /**
+     * @brief step() generations times
+     *
+     * @param fitness - the fitness of an organism
+     * @param generations - the number of generations to breed
+     * @return double - the best fitness of the last generation that was measured
+     */
+    double evolve(const FitnessFunction &fitness, int generations);
+
+    /**
+     * @brief The fittest organism of the last generation that was measured (the prototype before the first step)
+     *
+     */
+    inline const Network &best() const { return *champion; }
+
+    /**
+     * @brief The fitness of best(), -infinity before the first step
+     *
+     */
+    inline double best_fitness() const { return champion_fitness; }
+
+    /**
+     * @brief The number of generations bred so far
+     *
+     */
+    inline int generation() const { return generations; }
+
+    /**
+     * @brief The current population
+     *
+     */
+    inline const std::vector<Network> &get_population() const { return population; }
+
+    /**
+     * @brief The number of threads the work is split across
+     *
+     */
+    inline int num_threads() const { return pool.size(); }
+
+private:
+    /**
+     * @brief Pick a parent from the population that was just measured
+     *
+     * @param random - the generator of the calling thread
+     * @return const Network&
+     */
+    const Network &select(Xoshiro256 &random) const;
+
+    /**
+     * @brief Write a child of two parents into child
+     *
+     * @param random - the generator of the calling thread
+     */
+    void breed(const Network &parent1, const Network &parent2, Network &child,
+               Xoshiro256 &random) const;
+
+    /**
+     * @brief Add a normally distributed mutation to each parameter of network with a chance of rate
+     *
+     * @param random - the generator of the calling thread
+     */
+    void mutate(Network &network, double rate, Xoshiro256 &random) const;
+
+    Config config;
+    ThreadPool pool;
+    std::vector<Xoshiro256> randoms; // One per thread
+
+    std::vector<Network> population;
+    std::vector<Network> next_population;
+    std::vector<double> fitnesses; // The fitness of each organism of the population
+    std::vector<int> ranking;      // The indices of the population, fittest first
+
+    std::unique_ptr<Network> champion; // A copy of the fittest organism
+    double champion_fitness;
+    int generations = 0;
+};
+
+using EvolutionTrainer = BasicEvolutionTrainer<double>;
+
+#endif
@@ -13,33 +13,72 @@
 #define FF_H
 
 #include "activation.h"
+#include "binary_format.h"
+#include "evolution_trainer.h"
+#include "fixed_network.h"
+#include "kernels.h"
 #include "learning_functions.h"
+#include "loss_functions.h"
+#include "layer.h"
+#include "mapped_file.h"
+#include "matrix.h"
+#include "model_file_error.h"
 #include "neuron.h"
+#include "parallel_trainer.h"
+#include "quantized.h"
+#include "random.h"
 #include "sigmoid.h"
+#include "activation_functions.h"
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <sstream>
 #include <iostream>
 /**
- * @brief A class that represents the possible activation functions one can use
+ * @brief A fully connected forward feed neural network
  *
+ * @tparam Scalar - the type of the weights, bias' and values of the network. NeuralNetworkFF uses double,
+ *                  NeuralNetworkFF32 uses float, which takes half the memory and runs about twice as fast
+ *                  (a vector register holds twice as many floats). Activation and loss functions are shared
+ *                  by both, and work in double where a float network has no float version of them.
  */
-enum class ActivationFunctions
-{
-   Sigmoid
-};
-
-class NeuralNetworkFF
+template <typename Scalar>
+class BasicNeuralNetworkFF
 {
 public:
+   using DenseLayer = BasicDenseLayer<Scalar>;
+   using Matrix = BasicMatrix<Scalar>;
+   using InferenceWorkspace = BasicInferenceWorkspace<Scalar>;
+   using BatchWorkspace = BasicBatchWorkspace<Scalar>;
+   using Neuron = BasicNeuron<Scalar>;
+   using Optimizer = BasicOptimizer<Scalar>;
+   using ParallelTrainer = BasicParallelTrainer<Scalar>;
+
+   // The precision binary model files store Scalar in
+   static constexpr BinaryPrecision native_binary_precision =
+       sizeof(Scalar) == sizeof(float) ? BinaryPrecision::Float32 : BinaryPrecision::Float64;
+
    /**
-    * @brief Create a new neural network with default randomized weights and bias'
+    * @brief Create a new neural network with default randomized weights and bias', seeded from the
+    *        generator of the calling thread (see seed_random)
     *       : The default activation function is the sigmoid
     * @param num_layers - The number of layers in the neural network
     * @param neuron_counts - The number of neurons in each layer of the neural network
     */
-   NeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts);
+   BasicNeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts);
+
+   /**
+    * @brief Create a new neural network with randomized weights and bias' drawn from seed, so that the same
+    *        seed always gives the same network. Each layer draws from its own stream of the seed.
+    *
+    * @param num_layers - The number of layers in the neural network
+    * @param neuron_counts - The number of neurons in each layer of the neural network
+    * @param seed - the seed of the weights and bias'
+    */
+   BasicNeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts, uint64_t seed);
 
    /**
     * @brief Construct the neural network using predefined weights and bias'
@@ -49,43 +88,120 @@ public:
     * @param weights - Weights of each neuron
     * @param bias - A bias term for each neuron in the neural network
     */
-   NeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts, const std::vector<std::vector<std::vector<double>>> &weights, const std::vector<std::vector<double>> &bias);
+   BasicNeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts, const std::vector<std::vector<std::vector<Scalar>>> &weights, const std::vector<std::vector<Scalar>> &bias);
 
    /**
     * @brief Construct a new Neural Network object
     *
     * @param network - Neural Network that you want copied
     */
-   NeuralNetworkFF(const NeuralNetworkFF &network);
+   BasicNeuralNetworkFF(const BasicNeuralNetworkFF &network);
+
+   /**
+    * @brief Copy another neural network into this one
+    *
+    * @param network - Neural Network that you want copied
+    * @return BasicNeuralNetworkFF&
+    */
+   BasicNeuralNetworkFF &operator=(const BasicNeuralNetworkFF &network);
+
+   /**
+    * @brief Take over the buffers of another network without copying them. The layers keep pointing at the
+    *        same parameters, so nothing has to be rebound. network is left empty, and can only be assigned
+    *        to or destroyed.
+    *
+    * @param network - Neural Network that you want moved
+    */
+   BasicNeuralNetworkFF(BasicNeuralNetworkFF &&network) noexcept;
+
+   /**
+    * @brief Move another neural network into this one, see the move constructor
+    *
+    * @param network - Neural Network that you want moved
+    * @return BasicNeuralNetworkFF&
+    */
+   BasicNeuralNetworkFF &operator=(BasicNeuralNetworkFF &&network) noexcept;
+
+   /**
+    * @brief A copy of the network's layers, activation functions, loss function and parameters, which are
+    *        copied in one block. Unlike the copy constructor the training state is not copied: the clone
+    *        starts with no gradients summed.
+    *
+    * @return BasicNeuralNetworkFF
+    */
+   BasicNeuralNetworkFF clone() const;
+
+   /**
+    * @brief Copy the weights and bias' of another network with the same shape into this one, reusing
+    *        this network's storage. The activation functions, loss function and training state are kept.
+    *
+    * @param network - a network with the same number of neurons in each layer
+    * @throws std::invalid_argument if the networks have different shapes
+    */
+   void copy_parameters_from(const BasicNeuralNetworkFF &network);
+
+   /**
+    * @brief Every weight and bias in the network, layer by layer: the outputs x inputs weights of the layer
+    *        (row-major), then its bias'. Population based training can mix and mutate networks through these.
+    *
+    */
+   inline Span<Scalar> get_parameters() { return parameters; }
+   inline Span<const Scalar> get_parameters() const { return parameters; }
+
+   /**
+    * @brief The layers of the network, starting with the input layer, which has no weights. Tools that
+    *        read the shapes and activation functions of a trained network, such as code generators, use this.
+    *
+    */
+   inline const std::vector<DenseLayer> &get_layers() const { return layers; }
 
    /**
     * @brief Create a network from an external representation using a istream (ifstream, istream)
     * 
     * @param is 
+    * @throws ModelFileError if the representation is invalid, with the line it is invalid on
     */
-   NeuralNetworkFF(std::istream & is);
+   BasicNeuralNetworkFF(std::istream & is);
 
    /**
-    * @brief Read NN from file
+    * @brief Read NN from file. Binary model files (written by save_binary) are mapped into memory, and
+    *        parameters stored as Scalar are used where they are mapped (others are converted). Any other
+    *        file is parsed as text. Either kind of file can be read by networks of either precision.
     * 
     * @param filename - file to read from
+    * @throws ModelFileError if the file can not be opened or is invalid
     */
-   inline NeuralNetworkFF(std::string filename);
+   inline BasicNeuralNetworkFF(std::string filename);
 
    /**
     * @brief Destroy the Neural Network object
     *
     */
-   ~NeuralNetworkFF();
+   ~BasicNeuralNetworkFF();
+
+   /**
+    * @brief Compute a forward pass of a neural network given the values of the input layer
+    *      - This method copies the output to a output vector, replacing its contents.
+    *        The network is not modified, the layers are evaluated in the buffers of the workspace. So any
+    *        number of threads can run forward passes on the same network, each with its own workspace.
+    *        Once the workspace and output have been used with this network, the pass does not allocate any memory.
+    *
+    * @param input - Input layer of Neural Network
+    * @param output - Last Layer of Neural Network
+    * @param workspace - The scratch space to evaluate the layers in
+    */
+   void forwardPass(const std::vector<Scalar> &input, std::vector<Scalar> &output, InferenceWorkspace &workspace) const;
 
    /**
     * @brief Compute a forward pass of a neural network given the values of the input layer
-    *      - This method copies the output to a output vector
+    *      - This method copies the output to a output vector, replacing its contents.
+    *        The layers are evaluated in a workspace that belongs to the calling thread, so this is
+    *        also safe to call from several threads at once.
     *
     * @param input - Input layer of Neural Network
     * @param output - Last Layer of Neural Network
     */
-   void forwardPass(const std::vector<double> &input, std::vector<double> &output);
+   void forwardPass(const std::vector<Scalar> &input, std::vector<Scalar> &output) const;
 
    /**
     * @brief Compute a forward pass of a neural network given the values of the input layer
@@ -93,20 +209,80 @@ public:
     * @param input Input layer of the Neural Network
     * @return std::vector<int> - Return a copy of the output vector
     */
-   std::vector<double> forwardPass(const std::vector<double> &input);
+   std::vector<Scalar> forwardPass(const std::vector<Scalar> &input) const;
+
+   /**
+    * @brief Compute the forward pass for a batch of inputs at once. Each layer is computed
+    *        as a single matrix-matrix product over the whole batch. The network is not modified.
+    *
+    * @param inputs - batch x (input layer size) matrix, one example per row
+    * @param outputs - resized to batch x (output layer size), one result per row
+    * @param workspace - The scratch space to evaluate the layers in
+    */
+   void forwardBatch(const Matrix &inputs, Matrix &outputs, BatchWorkspace &workspace) const;
+
+   /**
+    * @brief Compute the forward pass for a batch of inputs at once, in a workspace that belongs
+    *        to the calling thread
+    *
+    * @param inputs - batch x (input layer size) matrix, one example per row
+    * @param outputs - resized to batch x (output layer size), one result per row
+    */
+   void forwardBatch(const Matrix &inputs, Matrix &outputs) const;
+
+   /**
+    * @brief Compute the forward pass for a batch of inputs at once
+    *
+    * @param inputs - batch x (input layer size) matrix, one example per row
+    * @return Matrix - batch x (output layer size), one result per row
+    */
+   Matrix forwardBatch(const Matrix &inputs) const;
 
    // Training Functions defined below
 
+   /**
+    * @brief Set the loss function the network is trained on
+    *
+    * @param loss_function - the loss (not owned by the network), or nullptr for the default, MeanSquaredError
+    */
+   void set_loss_function(const LossFunction *loss_function);
+
+   /**
+    * @brief The loss function the network is trained on
+    *
+    */
+   inline const LossFunction &get_loss_function() const { return *loss_function; }
+
+   /**
+    * @brief Set the activation function of every neuron in a layer
+    *
+    * @param layer - the layer (1 for the first hidden layer, get_num_layers() - 1 for the output layer)
+    * @param activation_function - the function. Built in functions are copied (as the instance every network
+    *                              shares), custom functions are not owned and must outlive the network.
+    */
+   void set_activation_function(int layer, ActivationBase *activation_function);
+
    /**
     * @brief This takes an input example and the expected output,
     *        and then comptues the derivative of weights and bias'.
-    *        After that, the partial derivative is added to the average partial derivative
-    *        for each weight and bias.
+    *        After that, the partial derivative is added to the sum of the partial derivatives
+    *        for each weight and bias, which update_weights divides by the number of examples.
     *
     * @param input
     * @param expected_output
     */
-   void train_on_example(const std::vector<double> &input, const std::vector<double> &expected_output);
+   void train_on_example(const std::vector<Scalar> &input, const std::vector<Scalar> &expected_output);
+
+   /**
+    * @brief The batched version of train_on_example. The whole batch goes through the forward pass
+    *        and backprop together, and the gradients of every example are added to the sums
+    *        in a single backward sweep. This gives the same sums as calling train_on_example
+    *        on each row.
+    *
+    * @param inputs - batch x (input layer size) matrix, one example per row
+    * @param expected_outputs - batch x (output layer size) matrix, one expected output per row
+    */
+   void trainBatch(const Matrix &inputs, const Matrix &expected_outputs);
 
    /**
     * @brief Update the weights and bias' based on the gradients computed in backprop
@@ -115,30 +291,60 @@ public:
     */
    void update_weights(double learning_rate, bool reset = true);
 
-   // TODO Add Move Constructor
-   // TODO Implement move semantics for the network
+   /**
+    * @brief Update the weights and bias' with an optimizer, based on the gradients computed in backprop
+    *
+    * @param optimizer - decides how the gradients move the weights and bias'
+    * @param learning_rate - the learning rate to use to update the weights
+    */
+   void update_weights(Optimizer &optimizer, double learning_rate, bool reset = true);
 
    /**
     * @brief Block the default construction of a Neural Network
     *
     */
-   NeuralNetworkFF() = delete; // No default constructed neural network
+   BasicNeuralNetworkFF() = delete; // No default constructed neural network
 
 
    /**
     * @brief Get the external representation of a neural network. This is a representation that
-    *       can be used to reconstruct the neural network exactly
+    *       can be used to reconstruct the neural network exactly: every weight and bias is written
+    *       as the shortest text that reads back as the same Scalar.
     * 
     * @param os 
+    * @param chunk_size - 0 to format the whole network in memory and write it to os at once, otherwise
+    *                     write it in pieces of about this many bytes, so huge networks need little memory
+    * @throws ModelFileError if a neuron uses a custom activation function, before anything is written
     */
-   void to_external_repr(std::ostream & os);
+   void to_external_repr(std::ostream & os, size_t chunk_size = 0) const;
 
    /**
     * @brief Save the neural network to an output file
     * 
     * @param filename 
+    * @param chunk_size - as for to_external_repr
+    * @throws ModelFileError if the file can not be opened or written, or a neuron uses a custom activation
+    *         function (checked before the file is created)
+    */
+   void save_to_file(std::string filename, size_t chunk_size = 0) const; 
+
+   /**
+    * @brief Save the neural network in the binary model format (see binary_format.h). The file can be
+    *        loaded with the filename constructor, which maps it into memory instead of parsing it.
+    *        Networks using custom activation functions can not be saved in this format.
+    * 
+    * @param filename - the file to write
+    * @param precision - whether to store the weights and bias' as float64 or float32, by default the
+    *                    precision of the network, which keeps them exact
+    * @throws ModelFileError if the network uses a custom activation function or the file can not be written
     */
-   void save_to_file(std::string filename); 
+   void save_binary(std::string filename, BinaryPrecision precision = native_binary_precision) const; 
+
+   /**
+    * @brief Whether the parameters are used directly from a mapped binary model file
+    * 
+    */
+   inline bool parameters_are_mapped() const { return parameter_file != nullptr; }
    
    /**
     * @brief Extra configuration settings for the train function
@@ -148,11 +354,21 @@ public:
    {
       int batch_size = 1;
       int skip_rate = 0;
-      int num_training_examples = -1;
+      int num_training_examples = -1; // The most examples to train on in each epoch, -1 for all of them
+      int epochs = 1;                 // The number of passes over the examples
       bool verbose = false;
       int verbose_count = 100;
+      int num_threads = 1; // Split each batch across this many threads (only used when batch_size > 1)
 
       LearningRateFunctionBase *learning_function = nullptr;
+      Optimizer *optimizer = nullptr; // Plain SGD when nullptr
+
+      // Measured at the end of every epoch and given to the learning rate function (optional)
+      std::function<double(const BasicNeuralNetworkFF &)> validation_loss;
+
+      // Where training is up to. Training carries on from here, so a learning rate schedule
+      // continues across calls to train that use the same config.
+      LearningRateContext progress;
    };
 
    /**
@@ -167,13 +383,14 @@ public:
     * @param config - The training configuration struct.
     */
    template <typename ExamplesIterator, typename ExpectIterator>
-   inline void train(ExamplesIterator examples_iter, ExamplesIterator examples_end,
-                     ExpectIterator expect_iter, ExpectIterator expect_end,
+   inline void train(ExamplesIterator examples_begin, ExamplesIterator examples_end,
+                     ExpectIterator expect_begin, ExpectIterator expect_end,
                      TrainConfig *config = nullptr)
    {
       // If a nullptr is passed for the config, then train with the default parameters on the network
+      TrainConfig default_config;
       if (!config)
-         config = new TrainConfig();
+         config = &default_config;
 
       int max_examples = config->num_training_examples;
 
@@ -188,25 +405,93 @@ public:
       if (!learning_rate_function)
          learning_rate_function = &ConstantRateFunction;
 
-      // The current number of examples that we have seen
-      int example_index = 0;
+      LearningRateContext &progress = config->progress;
       int batch_size = config->batch_size;
 
-      while (examples_iter != examples_end && expect_iter != expect_end && example_index < max_examples)
+      // Batches are collected into these and trained on together
+      Matrix batch_inputs, batch_expected;
+      if (batch_size > 1)
       {
+         batch_inputs.resize(batch_size, layers.front().outputs);
+         batch_expected.resize(batch_size, layers.back().outputs);
+      }
 
-         ++example_index;
-
-         train_on_example(*examples_iter, *expect_iter);
-         examples_iter += 1;
-         expect_iter += 1;
+      // The threads are started once and reused for every batch
+      ParallelTrainer parallel_trainer(batch_size > 1 ? config->num_threads : 1);
 
-         // Update the weights and bias' in the neural network
-         if (example_index % batch_size == 0)
-            update_weights(learning_rate_function->get_learning_rate(), true);
+      // Examples that are not vectors of Scalar are converted into these
+      std::vector<Scalar> example_buffer, expected_buffer;
 
-         if (config->verbose && example_index % config->verbose_count == 0)
-            std::cout << "Trained on " << example_index << " examples. " << std::endl;
+      for (int epoch = 0; epoch < config->epochs; ++epoch)
+      {
+         ExamplesIterator examples_iter = examples_begin;
+         ExpectIterator expect_iter = expect_begin;
+
+         // The current number of examples that we have seen
+         int example_index = 0;
+         int batch_index = 0;
+
+         while (examples_iter != examples_end && expect_iter != expect_end && example_index < max_examples)
+         {
+
+            ++example_index;
+
+            if (batch_size > 1)
+            {
+               const auto &example = *examples_iter;
+               const auto &expected = *expect_iter;
+               std::copy(example.begin(), example.begin() + batch_inputs.cols, batch_inputs.row(batch_index));
+               std::copy(expected.begin(), expected.begin() + batch_expected.cols, batch_expected.row(batch_index));
+               ++batch_index;
+
+               if (batch_index == batch_size)
+               {
+                  train_batch_helper(batch_inputs, batch_expected, parallel_trainer);
+                  batch_index = 0;
+               }
+            }
+            else
+            {
+               train_on_example(as_scalars(*examples_iter, example_buffer), as_scalars(*expect_iter, expected_buffer));
+            }
+
+            examples_iter += 1;
+            expect_iter += 1;
+
+            // Update the weights and bias' in the neural network
+            if (example_index % batch_size == 0)
+            {
+               // Without an optimizer the weights take plain SGD steps in the fused update
+               double learning_rate = learning_rate_function->get_learning_rate(progress);
+               if (config->optimizer)
+                  update_weights(*config->optimizer, learning_rate, true);
+               else
+                  update_weights(learning_rate, true);
+               ++progress.step;
+            }
+
+            if (config->verbose && example_index % config->verbose_count == 0)
+               std::cout << "Trained on " << example_index << " examples. " << std::endl;
+         }
+
+         // Examples from an unfinished batch are added to the sums, but (as with batch size 1)
+         // the weights are only updated at the end of a full batch
+         if (batch_index)
+         {
+            batch_inputs.resize(batch_index, batch_inputs.cols);
+            batch_expected.resize(batch_index, batch_expected.cols);
+            train_batch_helper(batch_inputs, batch_expected, parallel_trainer);
+            batch_inputs.resize(batch_size, batch_inputs.cols);
+            batch_expected.resize(batch_size, batch_expected.cols);
+         }
+
+         ++progress.epoch;
+         if (config->validation_loss)
+         {
+            progress.loss = config->validation_loss(*this);
+            if (config->verbose)
+               std::cout << "Epoch " << progress.epoch << ", validation loss " << progress.loss << std::endl;
+         }
       }
    }
 
@@ -231,7 +516,15 @@ public:
 
       size_t num_examples;
 
-      friend std::ostream &operator<<(std::ostream &os, const TestResults &results);
+      friend inline std::ostream &operator<<(std::ostream &os, const TestResults &results)
+      {
+         os << "Test Results:\n\n";
+         os << "    Total Correct: " << results.correct << "\n";
+         os << "    Total Incorrect: " << results.incorrect << "\n";
+         os << "    Total Examples: " << results.num_examples << "\n";
+         os << "    Correct Rate: " << results.correct_rate << "\n";
+         return os;
+      }
    };
 
    /**
@@ -240,7 +533,7 @@ public:
     *
     * @tparam ExamplesIterator - An iterator type for the examples.
     * @tparam ExpectIterator - an iterator type for the expected output of the network.
-    * @tparam OutputCmp - class type with operator()() defined which takes two std::vector<double>'s and then compares if they are "equivalent" (What the network was supposed to output)
+    * @tparam OutputCmp - class type with operator()() defined which takes two std::vector<Scalar>'s and then compares if they are "equivalent" (What the network was supposed to output)
     * @param examples_iter - The examples iterator object.
     * @param examples_end - end examples iterator object.
     * @param expect_iter - The expect iterator object.
@@ -252,11 +545,11 @@ public:
    template <typename ExamplesIterator, typename ExpectIterator, typename OutputCmp>
    inline TestResults test(ExamplesIterator examples_iter, ExamplesIterator examples_end,
                            ExpectIterator expect_iter, ExpectIterator expect_end, OutputCmp output_cmp,
-                           TestConfig *config = nullptr)
+                           TestConfig *config = nullptr) const
    {
-      // TODO: Fix memory leak
+      TestConfig default_config;
       if (!config)
-         config = new TestConfig();
+         config = &default_config;
 
       int max_examples = config->max_examples;
       if (config->max_examples == -1)
@@ -269,12 +562,14 @@ public:
       int example_index = 0;
 
       // Setup for the training
-      std::vector<double> output = std::vector<double>(neurons.back().size());
+      std::vector<Scalar> output = std::vector<Scalar>(layers.back().outputs);
+      std::vector<Scalar> example_buffer;
 
       while (examples_iter != examples_end && expect_iter != expect_end && example_index < max_examples)
       {
          ++example_index;
-         if (output_cmp(forwardPass(*examples_iter), *expect_iter))
+         forwardPass(as_scalars(*examples_iter, example_buffer), output);
+         if (output_cmp(output, *expect_iter))
             ++num_correct;
          else
             ++num_incorrect;
@@ -306,35 +601,122 @@ private:
 #endif
 
    /**
-    * @brief Run backprop on the network starting at layer layer
+    * @brief Copy a network, with or without its training state (the gradient sums and their example count)
+    *
+    */
+   BasicNeuralNetworkFF(const BasicNeuralNetworkFF &network, bool copy_training_state);
+
+   /**
+    * @brief An example as a vector of Scalar, so that train and test take examples of any element type
+    *
+    * @param values - the example, a std::vector<Scalar> or any other container of numbers
+    * @param buffer - where values is copied to if it is not a std::vector<Scalar>
+    * @return values itself, or buffer
+    */
+   template <typename Values>
+   static inline const std::vector<Scalar> &as_scalars(const Values &values, std::vector<Scalar> &buffer)
+   {
+      if constexpr (std::is_same_v<Values, std::vector<Scalar>>)
+         return values;
+      else
+      {
+         buffer.assign(std::begin(values), std::end(values));
+         return buffer;
+      }
+   }
+
+   /**
+    * @brief Size the layers for the given neuron counts, allocate the contiguous parameter and
+    *        gradient buffers, and point each layer at its slice of them
+    *
+    * @param neuron_counts - The number of neurons in each layer of the neural network
+    * @param allocate_parameters - false to leave parameters empty, for the caller to point at existing values
+    *                              (the layers are bound to them by calling bind_layers afterwards)
+    */
+   void allocate_layers(const std::vector<int> &neuron_counts, bool allocate_parameters = true);
+
+   /**
+    * @brief Build the network from the text representation written by to_external_repr, in a single
+    *        pass over the text that writes each weight and bias straight into the parameter buffer
+    *
+    * @param begin - the start of the text
+    * @param end - one past the end of the text
+    * @throws ModelFileError if the text is invalid, with the line it is invalid on
+    */
+   void read_text(const char *begin, const char *end);
+
+   /**
+    * @brief Build the network from a binary model file
     *
-    * @param layer - the starting layer for back prop
+    * @param file - the mapped file, which the network keeps if it uses the parameters in place
     */
-   void back_propagation(int layer);
+   void read_binary(const std::shared_ptr<MappedFile> &file);
 
    /**
-    * @brief Compute the loss with respect to the activation for a given neuron
+    * @brief Point every layer at its slice of the parameter and gradient buffers and rebuild the
+    *        neuron views. Must be called whenever the buffers are reallocated or copied.
     *
-    * @param neuron - the neuron to compute the function on
-    * @param layer - the layer which the neuron resides
     */
-   void calculate_dLoss_dActivation(Neuron &neuron, int layer, int index);
+   void bind_layers();
 
    /**
-    * @brief
+    * @brief Compute a forward pass that leaves the input and activation of every neuron in the layers,
+    *        which is the state that backprop works from
     *
-    * @param neuron - neuron to compute the function on
-    * @param layer - the layer which the neuron resides
+    * @param input - Input layer of Neural Network
     */
-   void calculate_dActivation_dInput(Neuron &neuron, int layer);
+   void record_forward_pass(const std::vector<Scalar> &input);
 
    /**
-    * @brief
+    * @brief Compute dLoss/dInput of the output neurons for one example from the loss function. Fused with
+    *        the activation of the output layer when the loss allows it, otherwise the derivative of the loss
+    *        is written to dLoss_dActivation and passed back through the activation (DenseLayer::input_gradient).
     *
-    * @param neuron - neuron to compute the function on
-    * @param layer - the layer which the neuron resides
+    * @param input - the inputs of the output neurons
+    * @param activation - the output of the network
+    * @param expected - the expected output
+    * @param dLoss_dActivation - where the derivative of the loss with respect to the outputs is written.
+    *                            May be the same span as dLoss_dInput.
+    * @param dActivation_dInput - where the derivative of the activations is written
+    * @param dLoss_dInput - where the derivative of the loss with respect to the neuron inputs is written
     */
-   void calculate_dLoss_dWeight_and_dLoss_dBias(Neuron &neuron, int layer);
+   void output_gradient(Span<const Scalar> input, Span<const Scalar> activation, Span<const Scalar> expected,
+                        Span<Scalar> dLoss_dActivation, Span<Scalar> dActivation_dInput, Span<Scalar> dLoss_dInput) const;
+
+   /**
+    * @brief Run backprop from the output layer down, once dLoss_dInput of the output layer is set,
+    *        adding the gradients to the gradient sums. Each layer is a handful of whole-layer kernels:
+    *        an outer product for the weight gradients, and a transposed matrix-vector product for
+    *        dLoss_dActivation of the layer before it, which gives the deltas of that layer.
+    *
+    */
+   void back_propagation();
+
+   /**
+    * @brief Train on a batch with the parallel trainer, or with trainBatch if there is only one thread
+    *
+    */
+   void train_batch_helper(const Matrix &inputs, const Matrix &expected_outputs, ParallelTrainer &parallel_trainer);
+
+   /**
+    * @brief Compute the forward pass for a batch, leaving the input and activation of every layer in a workspace
+    *
+    * @param inputs - batch x (input layer size) matrix, one example per row
+    * @param workspace - where the state of each layer is stored
+    */
+   void forward_batch(const Matrix &inputs, BatchWorkspace &workspace) const;
+
+   /**
+    * @brief Run backprop for the batch that was last passed through forward_batch with this workspace,
+    *        and add the gradients of every example in the batch to gradient_sums
+    *
+    * @param inputs - the inputs of the batch
+    * @param expected_outputs - the expected outputs of the batch
+    * @param workspace - the workspace the forward pass was run in
+    * @param gradient_sums - where the gradients are added up, same layout as parameters
+    */
+   void back_propagation_batch(const Matrix &inputs, const Matrix &expected_outputs, BatchWorkspace &workspace,
+                               Scalar *gradient_sums) const;
 
    /**
     * @brief Return the number of layers in the network
@@ -345,16 +727,53 @@ private:
 
    // TODO add other members to access the network metadata
 
-   std::vector<std::vector<Neuron>> neurons; // Where all the neurons are stored internally in the network
+   std::vector<DenseLayer> layers; // The dense layers of the network, layer 0 is the input layer
+
+   // Every weight and bias in the network, layer by layer (weights then bias'). They live in parameter_storage,
+   // or in parameter_file when the network was loaded from a binary model file.
+   std::vector<Scalar> parameter_storage;
+   std::shared_ptr<MappedFile> parameter_file;
+   Span<Scalar> parameters;
+
+   std::vector<Scalar> gradient_sums; // The partial derivatives summed over the examples since the last update, same layout as parameters
+   int num_examples = 0;              // The number of examples in the sums
+
+   std::vector<std::vector<Neuron>> neurons; // Views of the neurons stored in the layers
 
    int maxLayerSize = -1; // The layer in the network with the most neurons
+
+   BatchWorkspace batch_workspace; // The state of the layers for trainBatch
+
+   const LossFunction *loss_function = default_loss_function(); // Not owned by the network
+
+   friend class BasicParallelTrainer<Scalar>;
+   friend class QuantizedNetworkFF;
+   template <typename, int...>
+   friend class BasicFixedNetwork;
 };
 
+using NeuralNetworkFF = BasicNeuralNetworkFF<double>;
+using NeuralNetworkFF32 = BasicNeuralNetworkFF<float>;
+
 #include "../../src/ff/ff.cpp"
+#include "../../src/ff/kernels.cpp"
 #include "../../src/ff/activation.cpp"
+#include "../../src/ff/layer.cpp"
+#include "../../src/ff/thread_pool.cpp"
+#include "../../src/ff/parallel_trainer.cpp"
+#include "../../src/ff/evolution_trainer.cpp"
 #include "../../src/ff/neuron.cpp"
+#include "../../src/ff/learning_functions.cpp"
+#include "../../src/ff/optimizer.cpp"
+#include "../../src/ff/loss_functions.cpp"
 #include "../../src/ff/sigmoid.cpp"
+#include "../../src/ff/activation_functions.cpp"
 #include "../../src/ff/output_ff.cpp"
 #include "../../src/ff/read_ff.cpp"
+#include "../../src/ff/mapped_file.cpp"
+#include "../../src/ff/binary_ff.cpp"
+#include "../../src/ff/quantized.cpp"
+#include "../../src/ff/random.cpp"
+#include "../../src/ff/fixed_network.cpp"
 
 #endif
\ No newline at end of file
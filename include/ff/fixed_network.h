@@ -0,0 +1,191 @@
+/**
+ * @file fixed_network.h
+ *
+ * @brief Forward feed neural networks with a topology fixed at compile time, for running tiny trained
+ *        networks as fast as possible
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef FIXED_NETWORK_H
+#define FIXED_NETWORK_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include "activation.h"
+#include "span.h"
+
+template <typename Scalar>
+class BasicNeuralNetworkFF;
+
+/**
+ * @brief Where the parameters of a layer start in the parameters of a fixed network, or the number of
+ *        parameters of the whole network when layer is the number of layers
+ *
+ * @tparam Sizes - the number of neurons in each layer, starting with the input layer
+ * @param layer - the layer (1 for the first hidden layer)
+ */
+template <int... Sizes>
+constexpr size_t fixed_network_offset(int layer)
+{
+    constexpr int sizes[] = {Sizes...};
+    size_t offset = 0;
+    for (int l = 1; l < layer; ++l)
+        offset += (size_t)sizes[l] * (sizes[l - 1] + 1);
+    return offset;
+}
+
+/**
+ * @brief A forward feed network whose layer sizes are template parameters, so that a forward pass is a
+ *        handful of fully unrolled loops over std::arrays, with no allocation and no virtual calls. Meant
+ *        for tiny networks that are evaluated millions of times, such as a 2-2-1 XOR network, where the
+ *        bookkeeping of NeuralNetworkFF costs more than the arithmetic.
+ *
+ *        A fixed network only does inference. It is trained as a NeuralNetworkFF and converted, or read
+ *        from any model file a NeuralNetworkFF can read. The parameters are laid out the same way as the
+ *        parameters of NeuralNetworkFF, and every neuron in a layer uses the same built in activation
+ *        function.
+ *
+ * @tparam Scalar - the type of the parameters and values, double or float
+ * @tparam Sizes - the number of neurons in each layer, starting with the input layer
+ */
+template <typename Scalar, int... Sizes>
+class BasicFixedNetwork
+{
+    static_assert(sizeof...(Sizes) >= 2, "A network needs an input layer and an output layer");
+    static_assert(((Sizes > 0) && ...), "Every layer needs at least one neuron");
+
+public:
+    static constexpr int num_layers = sizeof...(Sizes);
+    static constexpr std::array<int, num_layers> layer_sizes = {Sizes...};
+    static constexpr int input_size = layer_sizes.front();
+    static constexpr int output_size = layer_sizes.back();
+    static constexpr size_t num_parameters = fixed_network_offset<Sizes...>(num_layers);
+
+    using Input = std::array<Scalar, input_size>;
+    using Output = std::array<Scalar, output_size>;
+
+    /**
+     * @brief A network with every parameter 0 and sigmoid activations
+     *
+     */
+    BasicFixedNetwork();
+
+    /**
+     * @brief Copy the parameters and activation functions of a network with the same layer sizes
+     *
+     * @param network - the network, of either precision
+     * @throws std::invalid_argument if the layer sizes differ, or a layer has a custom activation function
+     *         or neurons with different activation functions
+     */
+    template <typename NetworkScalar>
+    explicit BasicFixedNetwork(const BasicNeuralNetworkFF<NetworkScalar> &network);
+
+    /**
+     * @brief Read a network from a text or binary model file
+     *
+     * @param filename - the model file
+     * @throws ModelFileError if the file can not be read, std::invalid_argument as for the network constructor
+     */
+    explicit BasicFixedNetwork(const std::string &filename);
+
+    /**
+     * @brief The equivalent NeuralNetworkFF, to train further or to save
+     *
+     * @tparam NetworkScalar - the precision of the network
+     */
+    template <typename NetworkScalar = Scalar>
+    BasicNeuralNetworkFF<NetworkScalar> to_network() const;
+
+    /**
+     * @brief Save the network in the text format, as NeuralNetworkFF::save_to_file
+     *
+     */
+    void save_to_file(const std::string &filename) const;
+
+    /**
+     * @brief Save the network in the binary format, as NeuralNetworkFF::save_binary
+     *
+     */
+    void save_binary(const std::string &filename) const;
+
+    /**
+     * @brief Compute a forward pass. The network is not modified, so any number of threads can run
+     *        forward passes on it at once.
+     *
+     * @param input - the values of the input layer
+     * @return Output - the activations of the output layer
+     */
+    inline Output forwardPass(const Input &input) const;
+
+    /**
+     * @brief Compute a forward pass
+     *
+     * @param input - input_size values
+     * @param output - where the output_size activations of the output layer are written
+     */
+    inline void forwardPass(const Scalar *input, Scalar *output) const;
+
+    /**
+     * @brief Set the activation function of every neuron in a layer
+     *
+     * @param layer - the layer (1 for the first hidden layer, num_layers - 1 for the output layer)
+     * @param activation_function - a built in function, only its type and parameter are kept
+     * @throws std::invalid_argument for custom activation functions
+     */
+    void set_activation_function(int layer, ActivationBase *activation_function);
+
+    /**
+     * @brief The activation function of a layer
+     *
+     * @return ActivationBase* - the shared instance, see shared_activation_function
+     */
+    ActivationBase *get_activation_function(int layer) const;
+
+    /**
+     * @brief Every weight and bias of the network, in the same layout as NeuralNetworkFF::get_parameters
+     *
+     */
+    inline Span<Scalar> get_parameters() { return Span<Scalar>(parameters.data(), parameters.size()); }
+    inline Span<const Scalar> get_parameters() const { return Span<const Scalar>(parameters.data(), parameters.size()); }
+
+private:
+    /**
+     * @brief Compute the activations of a layer from the activations of the previous layer
+     *
+     */
+    template <int Layer>
+    inline void forward_layer(const Scalar *input, Scalar *activation) const;
+
+    /**
+     * @brief Compute the layers from Layer to the output layer
+     *
+     */
+    template <int Layer>
+    inline void forward_from(const Scalar *input, Scalar *output) const;
+
+    /**
+     * @brief Apply a built in activation function to the inputs of a layer in place
+     *
+     */
+    template <int Size>
+    static inline void activate(ActivationFunctions type, double parameter, Scalar *values);
+
+    std::array<Scalar, num_parameters> parameters;
+
+    // The activation function of each layer, the entry of the input layer is not used. The parameters are
+    // kept as double, like ActivationBase::parameter, so float networks convert back to the same functions.
+    std::array<ActivationFunctions, num_layers> activation_types;
+    std::array<double, num_layers> activation_parameters;
+};
+
+template <int... Sizes>
+using FixedNetwork = BasicFixedNetwork<double, Sizes...>;
+template <int... Sizes>
+using FixedNetwork32 = BasicFixedNetwork<float, Sizes...>;
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * @file kernels.h
+ *
+ * @brief The dense linear algebra kernels used by the layers of the network
+ * @version 0.1
+ * @date 2022-04-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+/**
+ * @brief All matrices are row-major. Every kernel has a portable scalar version and, when built with GCC for
+ *        x86, AVX2 and AVX-512 versions, each in double and float precision. The fastest version the CPU
+ *        supports is picked the first time a kernel is called, and can be overridden with kernels::select
+ *        (mostly for tests and benchmarks).
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstdint>
+
+namespace kernels
+{
+
+/**
+ * @brief The instruction sets the kernels are implemented for
+ *
+ */
+enum class Isa
+{
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief Whether the current CPU can run the kernels for isa
+ *
+ */
+bool supported(Isa isa);
+
+/**
+ * @brief Use the kernels for isa from now on
+ *
+ * @return false (and nothing changes) if the CPU does not support isa
+ */
+bool select(Isa isa);
+
+/**
+ * @brief The instruction set of the kernels currently in use
+ *
+ */
+Isa selected();
+
+/**
+ * @brief The name of an instruction set ("scalar", "avx2", "avx512")
+ *
+ */
+const char *isa_name(Isa isa);
+
+/**
+ * @brief C = A * B^T + bias
+ *
+ * @param m - rows of A and C
+ * @param n - rows of B, columns of C
+ * @param k - columns of A and B
+ * @param A - m x k matrix with row stride lda
+ * @param B - n x k matrix with row stride ldb
+ * @param bias - n values added to every row of C (may be nullptr)
+ * @param C - m x n matrix with row stride ldc
+ */
+void gemm_nt(int m, int n, int k, const double *A, int lda, const double *B, int ldb,
+             const double *bias, double *C, int ldc);
+
+/**
+ * @brief C = alpha * A * B (+ C when accumulate is set). A is accessed through two strides,
+ *        so passing a_row_stride = 1 and a_col_stride = lda multiplies by A^T instead.
+ *
+ * @param m - rows of A and C
+ * @param n - columns of B and C
+ * @param k - columns of A, rows of B
+ * @param alpha - scale applied to A * B
+ * @param A - element (i, p) is A[i * a_row_stride + p * a_col_stride]
+ * @param B - k x n matrix with row stride ldb
+ * @param C - m x n matrix with row stride ldc
+ * @param accumulate - add to C instead of overwriting it
+ */
+void gemm_nn(int m, int n, int k, double alpha, const double *A, int a_row_stride, int a_col_stride,
+             const double *B, int ldb, double *C, int ldc, bool accumulate);
+
+/**
+ * @brief y = A * x + bias
+ *
+ * @param rows - rows of A, size of y
+ * @param cols - columns of A, size of x
+ * @param A - rows x cols matrix (row stride cols)
+ * @param bias - rows values (may be nullptr)
+ */
+void gemv(int rows, int cols, const double *A, const double *x, const double *bias, double *y);
+
+/**
+ * @brief y = alpha * A^T * x (+ y when accumulate is set)
+ *
+ * @param rows - rows of A, size of x
+ * @param cols - columns of A, size of y
+ * @param A - rows x cols matrix (row stride cols)
+ */
+void gemv_t(int rows, int cols, double alpha, const double *A, const double *x, double *y, bool accumulate);
+
+/**
+ * @brief A += alpha * x * y^T
+ *
+ * @param rows - rows of A, size of x
+ * @param cols - columns of A, size of y
+ * @param A - rows x cols matrix (row stride cols)
+ */
+void ger(int rows, int cols, double alpha, const double *x, const double *y, double *A);
+
+/**
+ * @brief y = alpha * x + beta * y
+ *
+ */
+void axpby(long n, double alpha, const double *x, double beta, double *y);
+
+/**
+ * @brief y += alpha * x
+ *
+ */
+void axpy(long n, double alpha, const double *x, double *y);
+
+/**
+ * @brief x *= alpha
+ *
+ */
+void scale(long n, double alpha, double *x);
+
+/**
+ * @brief y = e^x for each of the n values, accurate to a couple of ulps. x and y may be the same array.
+ *
+ */
+void exp(long n, const double *x, double *y);
+
+/**
+ * @brief y = 1 / (1 + e^-x) for each of the n values. x and y may be the same array.
+ *
+ */
+void sigmoid(long n, const double *x, double *y);
+
+/**
+ * @brief y = x if x > 0, otherwise slope * x, for each of the n values (ReLU when slope is 0).
+ *        x and y may be the same array.
+ *
+ */
+void leaky_relu(long n, double slope, const double *x, double *y);
+
+/**
+ * @brief y = x if x > 0, otherwise alpha * (e^x - 1), for each of the n values. x and y may be the same array.
+ *
+ */
+void elu(long n, double alpha, const double *x, double *y);
+
+/**
+ * @brief y = tanh(x) for each of the n values, computed as 1 - 2 / (e^2x + 1), so it is accurate to about
+ *        1e-16 absolute rather than relative near 0. x and y may be the same array.
+ *
+ */
+void tanh(long n, const double *x, double *y);
+
+/**
+ * @brief y = x * sigmoid(2u) with u = sqrt(2 / pi) * (x + 0.044715 x^3) for each of the n values, the tanh
+ *        approximation of GELU (x * P(X <= x) for a standard normal X). x and y may be the same array.
+ *
+ */
+void gelu(long n, const double *x, double *y);
+
+/**
+ * @brief One step of SGD with momentum over n parameters. Each gradient is gradient_scale * gradients[i], so
+ *        the optimizer steps can be given gradient sums with gradient_scale = 1 / (the number of examples).
+ *          velocity = momentum * velocity + gradient
+ *          parameter -= learning_rate * velocity                                   (classical)
+ *          parameter -= learning_rate * (gradient + momentum * velocity)          (nesterov)
+ *
+ */
+void momentum_update(long n, double learning_rate, double momentum, bool nesterov, double gradient_scale,
+                     const double *gradients, double *velocity, double *parameters);
+
+/**
+ * @brief One step of Adam over n parameters, with the bias correction folded into step_size and epsilon,
+ *        and each gradient gradient_scale * gradients[i]:
+ *          first_moment = beta1 * first_moment + (1 - beta1) * gradient
+ *          second_moment = beta2 * second_moment + (1 - beta2) * gradient^2
+ *          parameter -= step_size * first_moment / (sqrt(second_moment) + epsilon)
+ *
+ */
+void adam_update(long n, double step_size, double beta1, double beta2, double epsilon, double gradient_scale,
+                 const double *gradients, double *first_moment, double *second_moment, double *parameters);
+
+/**
+ * @brief One step of RMSProp over n parameters, each gradient gradient_scale * gradients[i]:
+ *          mean_square = decay * mean_square + (1 - decay) * gradient^2
+ *          parameter -= learning_rate * gradient / (sqrt(mean_square) + epsilon)
+ *
+ */
+void rmsprop_update(long n, double learning_rate, double decay, double epsilon, double gradient_scale,
+                    const double *gradients, double *mean_square, double *parameters);
+
+/**
+ * @brief The same kernels in single precision. A vector holds twice as many floats as doubles, so these are
+ *        about twice as fast for the same n. exp, sigmoid, tanh and gelu are accurate to a couple of float
+ *        ulps (tanh to about 1e-7 absolute near 0).
+ *
+ */
+void gemm_nt(int m, int n, int k, const float *A, int lda, const float *B, int ldb,
+             const float *bias, float *C, int ldc);
+void gemm_nn(int m, int n, int k, float alpha, const float *A, int a_row_stride, int a_col_stride,
+             const float *B, int ldb, float *C, int ldc, bool accumulate);
+void gemv(int rows, int cols, const float *A, const float *x, const float *bias, float *y);
+void gemv_t(int rows, int cols, float alpha, const float *A, const float *x, float *y, bool accumulate);
+void ger(int rows, int cols, float alpha, const float *x, const float *y, float *A);
+void axpby(long n, float alpha, const float *x, float beta, float *y);
+void axpy(long n, float alpha, const float *x, float *y);
+void scale(long n, float alpha, float *x);
+void exp(long n, const float *x, float *y);
+void sigmoid(long n, const float *x, float *y);
+void leaky_relu(long n, float slope, const float *x, float *y);
+void elu(long n, float alpha, const float *x, float *y);
+void tanh(long n, const float *x, float *y);
+void gelu(long n, const float *x, float *y);
+void momentum_update(long n, float learning_rate, float momentum, bool nesterov, float gradient_scale,
+                     const float *gradients, float *velocity, float *parameters);
+void adam_update(long n, float step_size, float beta1, float beta2, float epsilon, float gradient_scale,
+                 const float *gradients, float *first_moment, float *second_moment, float *parameters);
+void rmsprop_update(long n, float learning_rate, float decay, float epsilon, float gradient_scale,
+                    const float *gradients, float *mean_square, float *parameters);
+
+/**
+ * @brief y = A * x in 8 bit integers, summed in 32 bits, for quantized inference. The values of x must be
+ *        below 128: the AVX2 version adds pairs of products in 16 bits (vpmaddubsw), which can not saturate
+ *        then, so every version gives exactly the same sums. CPUs with AVX-512 VNNI use vpdpbusd.
+ *
+ * @param rows - rows of A, size of y
+ * @param cols - columns of A, size of x. Must be a multiple of 64, pad the rows of A and x with zeros.
+ * @param A - rows x cols matrix (row stride cols)
+ * @param x - cols values in [0, 127]
+ */
+void gemv_u8s8(int rows, int cols, const int8_t *A, const uint8_t *x, int32_t *y);
+
+} // namespace kernels
+
+#endif
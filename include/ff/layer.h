@@ -0,0 +1,263 @@
+/**
+ * @file layer.h
+ *
+ * @brief Dense layer storage used internally by the forward feed neural network
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <vector>
+#include "activation.h"
+#include "matrix.h"
+#include "span.h"
+
+/**
+ * @brief The activation function every neuron gets by default (a sigmoid shared by every layer)
+ *
+ */
+ActivationBase *default_activation_function();
+
+/**
+ * @brief Get one of the built in activation functions. The built in functions have no state besides their
+ *        parameter, so every layer and network that uses the same type and parameter shares one immutable
+ *        instance, which lives as long as the program and must not be deleted. Safe to call from any thread.
+ *
+ * @param type - which function (not Custom)
+ * @param parameter - the parameter of the function, see ActivationBase::parameter
+ * @return ActivationBase* - the function, or nullptr if type is not a built in function
+ */
+ActivationBase *shared_activation_function(ActivationFunctions type, double parameter);
+
+/**
+ * @brief The function a layer keeps for activation_function: the shared instance with the same type and
+ *        parameter for built in functions, so the object passed in can go away, or activation_function
+ *        itself for custom functions, which must outlive every layer that uses them
+ *
+ */
+ActivationBase *layer_activation_function(ActivationBase *activation_function);
+
+/**
+ * @brief Whether some, but not all, of a layer's activation functions are the softmax. The softmax applies to
+ *        a whole layer, so such a layer can not be computed.
+ *
+ */
+bool mixes_softmax(const std::vector<ActivationBase *> &activation_functions);
+
+/**
+ * @brief A fully connected layer. The weights and bias' are not owned by the layer, they
+ *        point into the contiguous parameter buffer of the network that owns the layer.
+ *
+ *        The weights are stored row-major, meaning that the weights going into neuron o
+ *        are weights[o * inputs] ... weights[o * inputs + inputs - 1].
+ *
+ * @tparam Scalar - the type of the parameters and values, double or float
+ */
+template <typename Scalar>
+struct BasicDenseLayer
+{
+    using Matrix = BasicMatrix<Scalar>;
+
+    /**
+     * @brief Resize the per-neuron state of the layer
+     *
+     * @param inputs - The number of neurons in the previous layer
+     * @param outputs - The number of neurons in this layer
+     */
+    void resize(int inputs, int outputs);
+
+    /**
+     * @brief Compute the input (weighted sum plus bias) of every neuron in the layer
+     *
+     * @param previous_activation - the activations of the previous layer (inputs values)
+     * @param input - where the input of each neuron is written
+     */
+    void compute_input(Span<const Scalar> previous_activation, Span<Scalar> input) const;
+
+    /**
+     * @brief Apply the activation function of every neuron in the layer. input and activation may be the same span.
+     *
+     * @param input - the neuron inputs computed by compute_input
+     * @param activation - where the activation of each neuron is written
+     */
+    void activate(Span<const Scalar> input, Span<Scalar> activation) const;
+
+    /**
+     * @brief Compute dActivation/dInput for every neuron in the layer from the inputs and the activations they
+     *        produced. None of the spans may overlap.
+     *
+     * @param input - the neuron inputs
+     * @param activation - the activations computed from input
+     * @param derivative - where the derivative of each neuron is written
+     */
+    void activation_derivative(Span<const Scalar> input, Span<const Scalar> activation, Span<Scalar> derivative) const;
+
+    /**
+     * @brief Compute dLoss/dInput of every neuron in the layer from dLoss/dActivation. For most functions this
+     *        is dLoss_dActivation * dActivation_dInput, but each output of the softmax depends on every input,
+     *        so for the softmax it is the product with its Jacobian. The spans may hold several examples back
+     *        to back (outputs values each). dLoss_dActivation and dLoss_dInput may be the same span.
+     *
+     * @param input - the neuron inputs
+     * @param activation - the activations computed from input
+     * @param dLoss_dActivation - the derivative of the loss with respect to each activation
+     * @param dActivation_dInput - where the derivative of each activation is written
+     * @param dLoss_dInput - where the derivative of the loss with respect to each input is written
+     */
+    void input_gradient(Span<const Scalar> input, Span<const Scalar> activation, Span<const Scalar> dLoss_dActivation,
+                        Span<Scalar> dActivation_dInput, Span<Scalar> dLoss_dInput) const;
+
+    /**
+     * @brief Set the activation function of a single neuron and work out the activation type of the layer again
+     *
+     * @param index - the neuron
+     * @param activation_function - the new activation function, kept as layer_activation_function(activation_function)
+     * @throws std::invalid_argument if only some of the neurons would use the softmax, the layer is left unchanged
+     */
+    void set_activation_function(int index, ActivationBase *activation_function);
+
+    /**
+     * @brief Work out activation_type and layer_activation from activation_functions. Must be called
+     *        whenever activation_functions is changed directly.
+     *
+     * @throws std::invalid_argument if only some of the neurons use the softmax
+     */
+    void update_activation_type();
+
+    /**
+     * @brief Compute the input and activation of every neuron in the layer, storing both in the
+     *        layer so that backprop can use them
+     *
+     * @param previous_activation - the activations of the previous layer (inputs values)
+     */
+    void forward(Span<const Scalar> previous_activation);
+
+    /**
+     * @brief Compute the input of every neuron for a batch of examples (one example per row)
+     *
+     * @param previous_activation - batch x inputs activations of the previous layer
+     * @param input - resized to batch x outputs and filled with the neuron inputs
+     */
+    void compute_input_batch(const Matrix &previous_activation, Matrix &input) const;
+
+    /**
+     * @brief Apply the activation functions to a batch of neuron inputs
+     *
+     * @param input - batch x outputs neuron inputs
+     * @param activation - resized to batch x outputs and filled with the activations
+     */
+    void activate_batch(const Matrix &input, Matrix &activation) const;
+
+    /**
+     * @brief The batched version of activation_derivative
+     *
+     * @param input - batch x outputs neuron inputs
+     * @param activation - batch x outputs activations computed from input
+     * @param derivative - resized to batch x outputs and filled with the derivatives
+     */
+    void activation_derivative_batch(const Matrix &input, const Matrix &activation, Matrix &derivative) const;
+
+    /**
+     * @brief Compute the inputs and activations for a batch of examples
+     *
+     * @param previous_activation - batch x inputs activations of the previous layer
+     * @param input - resized to batch x outputs and filled with the neuron inputs
+     * @param activation - resized to batch x outputs and filled with the activations
+     */
+    void forward_batch(const Matrix &previous_activation, Matrix &input, Matrix &activation) const;
+
+    /**
+     * @brief The number of weights and bias' in the layer
+     *
+     * @return size_t
+     */
+    size_t parameter_count() const;
+
+    int inputs = 0;  // The number of neurons in the previous layer
+    int outputs = 0; // The number of neurons in this layer
+
+    Scalar *weights = nullptr; // outputs x inputs weight matrix (row-major)
+    Scalar *bias = nullptr;    // one bias per neuron
+
+    Scalar *dLoss_dWeight_sum = nullptr; // outputs x inputs, same layout as the weights
+    Scalar *dLoss_dBias_sum = nullptr;   // one per neuron
+
+    std::vector<Scalar> input;      // The value of the input to each neuron
+    std::vector<Scalar> activation; // The value after the activation function has been applied
+
+    // Backpropagation variables
+    std::vector<Scalar> dLoss_dActivation;
+    std::vector<Scalar> dActivation_dInput;
+    std::vector<Scalar> dLoss_dInput; // The delta of each neuron, dLoss_dActivation * dActivation_dInput unless fused by the loss
+
+    std::vector<ActivationBase *> activation_functions; // The activation function of each neuron, shared or custom, never owned
+
+    // When every neuron in the layer uses the same activation function it is applied to the whole layer
+    // at once. layer_activation is that function, or nullptr if the neurons use different functions.
+    ActivationFunctions activation_type = ActivationFunctions::Sigmoid;
+    ActivationBase *layer_activation = nullptr;
+};
+
+/**
+ * @brief The scratch space for a single example going through the network. The forward pass alternates
+ *        between the two buffers, reading the previous layer from one and writing the current layer to
+ *        the other. Giving each thread its own workspace lets several threads share one network.
+ *
+ */
+template <typename Scalar>
+struct BasicInferenceWorkspace
+{
+    /**
+     * @brief Make sure both buffers can hold size values. Only allocates if they are smaller.
+     *
+     */
+    inline void reserve(size_t size)
+    {
+        if (ping.size() < size)
+            ping.resize(size);
+        if (pong.size() < size)
+            pong.resize(size);
+    }
+
+    std::vector<Scalar> ping;
+    std::vector<Scalar> pong;
+};
+
+/**
+ * @brief The state of every layer for a batch of examples going through the network, one row per example.
+ *        It is kept apart from the layers so that several batches (one per thread) can go through the
+ *        same network at once.
+ *
+ */
+template <typename Scalar>
+struct BasicBatchWorkspace
+{
+    /**
+     * @brief Make room for the given number of layers. The matrices are sized by the layers as they are used.
+     *
+     */
+    inline void resize(size_t num_layers)
+    {
+        input.resize(num_layers);
+        activation.resize(num_layers);
+        dLoss_dInput.resize(num_layers);
+        dActivation_dInput.resize(num_layers);
+    }
+
+    // One matrix per layer, batch x (neurons in the layer)
+    std::vector<BasicMatrix<Scalar>> input;
+    std::vector<BasicMatrix<Scalar>> activation;
+    std::vector<BasicMatrix<Scalar>> dLoss_dInput;
+    std::vector<BasicMatrix<Scalar>> dActivation_dInput;
+};
+
+using DenseLayer = BasicDenseLayer<double>;
+using InferenceWorkspace = BasicInferenceWorkspace<double>;
+using BatchWorkspace = BasicBatchWorkspace<double>;
+
+#endif
@@ -17,15 +17,33 @@
 #ifndef LEARNING_FUNCTIONS_H
 #define LEARNING_FUNCTIONS_H
 
+#include "span.h"
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Where training is up to, given to the learning rate function at every weight update
+ *
+ */
+struct LearningRateContext
+{
+    long step = 0;  // The number of weight updates made so far
+    int epoch = 0;  // The number of complete passes over the training examples so far
+    double loss = std::numeric_limits<double>::quiet_NaN(); // The validation loss after the last epoch, NaN until one is measured
+};
+
 class LearningRateFunctionBase
 {
 public:
+    virtual ~LearningRateFunctionBase() = default;
+
     /**
      * @brief Get the learning rate object
      * 
+     * @param context - where training is up to
      * @return double 
      */
-    virtual double get_learning_rate() = 0;
+    virtual double get_learning_rate(const LearningRateContext &context) = 0;
 };
 
 /**
@@ -49,7 +67,7 @@ public:
      * 
      * @return double 
      */
-    inline double get_learning_rate() override{
+    inline double get_learning_rate(const LearningRateContext &) override{
         return rate; 
     }
 
@@ -57,4 +75,234 @@ private:
 double rate; 
 };
 
-#endif
\ No newline at end of file
+/**
+ * @brief Drops the learning rate by a factor every few epochs: initial_rate * factor^(epoch / epochs_per_drop)
+ *
+ */
+class StepDecayLearningFunction : public LearningRateFunctionBase
+{
+public:
+    /**
+     * @throws std::invalid_argument if epochs_per_drop is not positive
+     */
+    StepDecayLearningFunction(double initial_rate, double factor, int epochs_per_drop);
+
+    double get_learning_rate(const LearningRateContext &context) override;
+
+private:
+    double initial_rate, factor;
+    int epochs_per_drop;
+};
+
+/**
+ * @brief Shrinks the learning rate smoothly with every step: initial_rate * decay^(step / decay_steps)
+ *
+ */
+class ExponentialDecayLearningFunction : public LearningRateFunctionBase
+{
+public:
+    /**
+     * @throws std::invalid_argument if decay_steps is not positive
+     */
+    ExponentialDecayLearningFunction(double initial_rate, double decay, long decay_steps = 1);
+
+    double get_learning_rate(const LearningRateContext &context) override;
+
+private:
+    double initial_rate, decay;
+    long decay_steps;
+};
+
+/**
+ * @brief Cosine annealing with warm restarts (SGDR, Loshchilov and Hutter). The rate follows half a
+ *        cosine from max_rate down to min_rate over period steps, then jumps back to max_rate. Each
+ *        period is period_multiplier times longer than the one before it.
+ *
+ */
+class CosineAnnealingLearningFunction : public LearningRateFunctionBase
+{
+public:
+    /**
+     * @throws std::invalid_argument if period is not positive, or period_multiplier is less than 1
+     */
+    CosineAnnealingLearningFunction(double max_rate, double min_rate, long period, double period_multiplier = 1);
+
+    double get_learning_rate(const LearningRateContext &context) override;
+
+private:
+    double max_rate, min_rate;
+    long period;
+    double period_multiplier;
+};
+
+/**
+ * @brief Ramps the learning rate up linearly over the first warmup_steps steps, and follows another
+ *        learning rate function after that
+ *
+ */
+class WarmupLearningFunction : public LearningRateFunctionBase
+{
+public:
+    /**
+     * @param after - the learning rate function to warm up to, which must outlive this one
+     * @param warmup_steps - the number of steps to reach the full rate in
+     */
+    WarmupLearningFunction(LearningRateFunctionBase &after, long warmup_steps) : after(&after), warmup_steps(warmup_steps) {}
+
+    double get_learning_rate(const LearningRateContext &context) override;
+
+private:
+    LearningRateFunctionBase *after;
+    long warmup_steps;
+};
+
+/**
+ * @brief Multiplies the learning rate by factor whenever the validation loss has not improved (by
+ *        more than threshold, relative to the best loss) for patience epochs in a row. Needs a loss,
+ *        so set TrainConfig::validation_loss when training with it.
+ *
+ */
+class ReduceOnPlateauLearningFunction : public LearningRateFunctionBase
+{
+public:
+    ReduceOnPlateauLearningFunction(double initial_rate, double factor = 0.1, int patience = 10, double threshold = 1e-4, double min_rate = 0)
+        : rate(initial_rate), factor(factor), patience(patience), threshold(threshold), min_rate(min_rate) {}
+
+    double get_learning_rate(const LearningRateContext &context) override;
+
+private:
+    double rate, factor;
+    int patience;
+    double threshold, min_rate;
+
+    double best_loss = std::numeric_limits<double>::infinity();
+    int epochs_without_improvement = 0;
+    int last_epoch = -1; // The epoch whose loss was looked at last
+};
+
+/**
+ * @brief An optimizer decides how the gradients move the parameters. The learning rate for each step
+ *        still comes from a LearningRateFunctionBase, the optimizer decides what to do with it.
+ *
+ *        Optimizers that keep state (velocities, moments) store it in one contiguous buffer with the
+ *        same layout as the network's parameters, so the state of each layer is a contiguous slice,
+ *        and every step is a single fused pass over the parameters, gradients and state.
+ *        The state belongs to one network: use a separate optimizer for each network being trained.
+ *
+ * @tparam Scalar - the scalar type of the network, which the state is kept in. Optimizer, SGD, Adam, ...
+ *                  are the double versions, float networks use BasicAdam<float> and so on.
+ */
+template <typename Scalar>
+class BasicOptimizer
+{
+public:
+    virtual ~BasicOptimizer() = default;
+
+    /**
+     * @brief Move every parameter against its gradient
+     *
+     * @param parameters - every weight and bias in the network
+     * @param gradients - the gradient of the loss with respect to each parameter, in the same layout
+     * @param learning_rate - the learning rate for this step
+     * @param gradient_scale - what every gradient is multiplied by first, so the network can pass the sums
+     *                         of its gradients over a batch with 1 / (the batch size) instead of averaging them
+     */
+    virtual void step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale = 1) = 0;
+
+    /**
+     * @brief Forget the state built up by earlier steps
+     *
+     */
+    virtual void reset() {}
+};
+
+/**
+ * @brief Plain stochastic gradient descent: parameter -= learning_rate * gradient
+ *
+ */
+template <typename Scalar>
+class BasicSGD : public BasicOptimizer<Scalar>
+{
+public:
+    void step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale = 1) override;
+};
+
+/**
+ * @brief Gradient descent with momentum: a velocity that decays by momentum each step and gathers
+ *        the gradients, which the parameters move along. With nesterov the parameters move along the
+ *        velocity after the next step instead (Nesterov's accelerated gradient).
+ *
+ */
+template <typename Scalar>
+class BasicMomentum : public BasicOptimizer<Scalar>
+{
+public:
+    explicit BasicMomentum(double momentum = 0.9, bool nesterov = false) : momentum(momentum), nesterov(nesterov) {}
+
+    void step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale = 1) override;
+    void reset() override;
+
+private:
+    double momentum;
+    bool nesterov;
+    std::vector<Scalar> velocity;
+};
+
+/**
+ * @brief Momentum with Nesterov's look ahead
+ *
+ */
+template <typename Scalar>
+class BasicNesterov : public BasicMomentum<Scalar>
+{
+public:
+    explicit BasicNesterov(double momentum = 0.9) : BasicMomentum<Scalar>(momentum, true) {}
+};
+
+/**
+ * @brief Adam (Kingma and Ba): running averages of the gradients and their squares, with bias
+ *        correction, so every parameter gets a step size scaled to its own gradients
+ *
+ */
+template <typename Scalar>
+class BasicAdam : public BasicOptimizer<Scalar>
+{
+public:
+    explicit BasicAdam(double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8) : beta1(beta1), beta2(beta2), epsilon(epsilon) {}
+
+    void step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale = 1) override;
+    void reset() override;
+
+private:
+    double beta1, beta2, epsilon;
+    long steps = 0;
+    std::vector<Scalar> first_moment;
+    std::vector<Scalar> second_moment;
+};
+
+/**
+ * @brief RMSProp: each gradient is divided by the root of a running average of its squares
+ *
+ */
+template <typename Scalar>
+class BasicRMSProp : public BasicOptimizer<Scalar>
+{
+public:
+    explicit BasicRMSProp(double decay = 0.9, double epsilon = 1e-8) : decay(decay), epsilon(epsilon) {}
+
+    void step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale = 1) override;
+    void reset() override;
+
+private:
+    double decay, epsilon;
+    std::vector<Scalar> mean_square;
+};
+
+using Optimizer = BasicOptimizer<double>;
+using SGD = BasicSGD<double>;
+using Momentum = BasicMomentum<double>;
+using Nesterov = BasicNesterov<double>;
+using Adam = BasicAdam<double>;
+using RMSProp = BasicRMSProp<double>;
+
+#endif
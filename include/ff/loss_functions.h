@@ -0,0 +1,152 @@
+/**
+ * @file loss_functions.h
+ *
+ * @brief The loss functions a network can be trained on
+ * @version 0.1
+ * @date 2022-04-21
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LOSS_FUNCTIONS_H
+#define LOSS_FUNCTIONS_H
+
+#include "activation.h"
+#include "span.h"
+
+/**
+ * @brief A loss function measures how far the output of the network is from the expected output of one
+ *        example, and gives backprop its starting point: the derivative of the loss with respect to each
+ *        output. Loss functions keep no state, so one can be shared by any number of networks and threads.
+ *
+ */
+class LossFunction
+{
+public:
+    virtual ~LossFunction() = default;
+
+    /**
+     * @brief The loss of one example
+     *
+     * @param output - the output of the network
+     * @param expected - the expected output
+     * @return double
+     */
+    virtual double loss(Span<const double> output, Span<const double> expected) const = 0;
+
+    /**
+     * @brief The derivative of the loss with respect to each output (dLoss/dActivation of the output layer)
+     *
+     * @param output - the output of the network
+     * @param expected - the expected output
+     * @param dLoss_dOutput - where the derivatives are written. May be the same span as output.
+     */
+    virtual void gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const = 0;
+
+    /**
+     * @brief Some losses and output activations cancel each other out when their derivatives are multiplied,
+     *        leaving a simpler and numerically stable derivative of the loss with respect to the neuron inputs
+     *        (cross-entropy after a sigmoid is just output - expected). If that is the case for the activation
+     *        of the output layer, write it and return true, otherwise backprop multiplies gradient by the
+     *        derivative of the activation. The default never fuses.
+     *
+     * @param output_activation - the activation function of every neuron in the output layer (Custom if
+     *                            the neurons use different functions)
+     * @param output - the output of the network
+     * @param expected - the expected output
+     * @param dLoss_dInput - where the derivatives with respect to the neuron inputs are written
+     * @return true if dLoss_dInput was written
+     */
+    virtual bool fused_gradient(ActivationFunctions /*output_activation*/, Span<const double> /*output*/, Span<const double> /*expected*/,
+                                Span<double> /*dLoss_dInput*/) const
+    {
+        return false;
+    }
+
+    /**
+     * @brief The single precision versions of loss, gradient and fused_gradient, used by float networks.
+     *        The values are converted to double and passed to the functions above, so every loss
+     *        function works with float networks without being written twice. Call them through a
+     *        LossFunction, as the overrides in the derived classes hide them.
+     *
+     */
+    double loss(Span<const float> output, Span<const float> expected) const;
+    void gradient(Span<const float> output, Span<const float> expected, Span<float> dLoss_dOutput) const;
+    bool fused_gradient(ActivationFunctions output_activation, Span<const float> output, Span<const float> expected,
+                        Span<float> dLoss_dInput) const;
+};
+
+/**
+ * @brief The squared error summed over the outputs, (output - expected)^2. Averaged over the examples by
+ *        the update, this is the mean squared error. It is the loss networks train on by default.
+ *
+ */
+class MeanSquaredError : public LossFunction
+{
+public:
+    double loss(Span<const double> output, Span<const double> expected) const override;
+    void gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const override;
+};
+
+/**
+ * @brief Binary cross-entropy, -(expected * log(output) + (1 - expected) * log(1 - output)) summed over the
+ *        outputs, for outputs that are independent probabilities (one or more labels per example).
+ *        The outputs must be in (0, 1), so the output layer should use the sigmoid, which it fuses with.
+ *
+ */
+class BinaryCrossEntropy : public LossFunction
+{
+public:
+    double loss(Span<const double> output, Span<const double> expected) const override;
+    void gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const override;
+    bool fused_gradient(ActivationFunctions output_activation, Span<const double> output, Span<const double> expected,
+                        Span<double> dLoss_dInput) const override;
+};
+
+/**
+ * @brief Categorical cross-entropy, -sum(expected * log(output)), for outputs that are the probabilities of
+ *        one of several classes. The output layer should use the Softmax activation, which it fuses with:
+ *        dLoss/dInput is output * sum(expected) - expected, without the Jacobian of the softmax.
+ *
+ */
+class CategoricalCrossEntropy : public LossFunction
+{
+public:
+    double loss(Span<const double> output, Span<const double> expected) const override;
+    void gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const override;
+    bool fused_gradient(ActivationFunctions output_activation, Span<const double> output, Span<const double> expected,
+                        Span<double> dLoss_dInput) const override;
+};
+
+/**
+ * @brief Softmax followed by categorical cross-entropy, for picking one of several classes. The outputs of
+ *        the network are the logits, which this turns into probabilities with the softmax, so the output
+ *        layer should be Linear(1) (or use CategoricalCrossEntropy with a Softmax output layer). The softmax and the cross-entropy are computed together, which leaves
+ *        loss = sum(expected) * log(sum(exp(output))) - sum(expected * output) and
+ *        dLoss/dOutput = softmax(output) * sum(expected) - expected, with the largest output subtracted
+ *        first so that exp never overflows and log never sees 0.
+ *
+ */
+class SoftmaxCrossEntropy : public LossFunction
+{
+public:
+    double loss(Span<const double> output, Span<const double> expected) const override;
+    void gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const override;
+
+    /**
+     * @brief The probabilities the logits of the network stand for
+     *
+     * @param logits - the output of the network
+     * @param probabilities - where the softmax of the logits is written. May be the same span as logits.
+     */
+    static void softmax(Span<const double> logits, Span<double> probabilities);
+};
+
+/**
+ * @brief The loss every network trains on unless it is given another one (MeanSquaredError)
+ *
+ */
+const LossFunction *default_loss_function();
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file mapped_file.h
+ *
+ * @brief A file mapped into memory
+ * @version 0.1
+ * @date 2022-04-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The contents of a file, mapped copy-on-write. Reading the contents comes straight from the
+ *        page cache (shared with every other process that maps the file), and writing to them
+ *        copies only the pages written to. The file itself is never modified.
+ *
+ *        On systems without mmap the file is read into memory instead.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Map a file
+     *
+     * @param filename - the file to map. is_open() is false if it could not be opened.
+     */
+    explicit MappedFile(const std::string &filename);
+
+    /**
+     * @brief Unmap the file
+     *
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Whether the file was opened and mapped
+     *
+     */
+    inline bool is_open() const { return opened; }
+
+    /**
+     * @brief The contents of the file, aligned to at least 16 bytes
+     *
+     */
+    inline char *data() const { return contents; }
+
+    /**
+     * @brief The size of the file in bytes
+     *
+     */
+    inline size_t size() const { return length; }
+
+private:
+    bool opened = false;
+    bool mapped = false;
+    char *contents = nullptr;
+    size_t length = 0;
+    std::vector<char> buffer; // The contents when the file could not be mapped
+};
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file matrix.h
+ *
+ * @brief A dense row-major matrix used to pass batches of examples through the network
+ * @version 0.1
+ * @date 2022-04-05
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <vector>
+#include "span.h"
+
+/**
+ * @brief A rows x cols matrix stored row-major. For batches, each row is one example.
+ *
+ * @tparam T - the element type, the scalar type of the network the matrix is used with
+ */
+template <typename T>
+struct BasicMatrix
+{
+    inline BasicMatrix() : rows(0), cols(0) {}
+
+    /**
+     * @brief Construct a rows x cols matrix filled with value
+     *
+     */
+    inline BasicMatrix(int rows, int cols, T value = 0) : rows(rows), cols(cols), data((size_t)rows * cols, value) {}
+
+    /**
+     * @brief Change the shape of the matrix. The contents are unspecified afterwards, and
+     *        no memory is allocated unless the matrix grows past its largest size so far.
+     *
+     */
+    inline void resize(int rows, int cols)
+    {
+        this->rows = rows;
+        this->cols = cols;
+        data.resize((size_t)rows * cols);
+    }
+
+    inline T *row(int r) { return data.data() + (size_t)r * cols; }
+    inline const T *row(int r) const { return data.data() + (size_t)r * cols; }
+
+    inline Span<T> row_span(int r) { return Span<T>(row(r), cols); }
+    inline Span<const T> row_span(int r) const { return Span<const T>(row(r), cols); }
+
+    inline T &operator()(int r, int c) { return data[(size_t)r * cols + c]; }
+    inline T operator()(int r, int c) const { return data[(size_t)r * cols + c]; }
+
+    int rows;
+    int cols;
+    std::vector<T> data;
+};
+
+using Matrix = BasicMatrix<double>;
+using Matrix32 = BasicMatrix<float>;
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @file model_file_error.h
+ *
+ * @brief The exception thrown when a model file can not be read or written
+ * @version 0.1
+ * @date 2022-04-18
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MODEL_FILE_ERROR_H
+#define MODEL_FILE_ERROR_H
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Thrown when a model file can not be opened, parsed or saved. For text files, what() starts
+ *        with the line the problem is on, and line() returns it.
+ *
+ */
+class ModelFileError : public std::runtime_error
+{
+public:
+    /**
+     * @brief Construct a new Model File Error
+     *
+     * @param message - what went wrong
+     * @param line - the line of a text file it went wrong on, or 0 if it is not about a line
+     */
+    explicit ModelFileError(const std::string &message, int line = 0)
+        : std::runtime_error(line ? "Line " + std::to_string(line) + ": " + message : message), line_number(line) {}
+
+    /**
+     * @brief The line of the text file the error is on, or 0 if it is not about a line
+     *
+     */
+    inline int line() const { return line_number; }
+
+private:
+    int line_number;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file parallel_trainer.h
+ *
+ * @brief Data-parallel training of a forward feed neural network on several threads
+ * @version 0.1
+ * @date 2022-04-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef PARALLEL_TRAINER_H
+#define PARALLEL_TRAINER_H
+
+#include <vector>
+#include "layer.h"
+#include "matrix.h"
+#include "thread_pool.h"
+
+template <typename Scalar>
+class BasicNeuralNetworkFF;
+
+/**
+ * @brief Trains a network on mini-batches split across threads. Each thread takes a contiguous shard of
+ *        the batch and runs the forward pass and backprop on it with its own workspace and gradient
+ *        sums. The sums are then added together in a fixed binary tree (shard 0 + shard 1, shard 2 + shard 3,
+ *        then the pairs, ...) before being added to the sums of the network.
+ *
+ *        The shards and the order of every addition depend only on the batch size and the number of
+ *        threads, so training is deterministic for a given number of threads. Different thread counts
+ *        add the gradients in a different order, and so can differ in the last few bits.
+ *
+ * @tparam Scalar - the scalar type of the networks it trains, double or float
+ */
+template <typename Scalar>
+class BasicParallelTrainer
+{
+public:
+    using Matrix = BasicMatrix<Scalar>;
+
+    /**
+     * @brief Start the threads
+     *
+     * @param num_threads - the number of threads to train on, including the calling thread
+     */
+    explicit BasicParallelTrainer(int num_threads);
+
+    /**
+     * @brief The data-parallel version of NeuralNetworkFF::trainBatch. The network ends up with the same
+     *        gradient sums (up to rounding) as if trainBatch had been called on it.
+     *
+     * @param net - the network to train
+     * @param inputs - batch x (input layer size) matrix, one example per row
+     * @param expected_outputs - batch x (output layer size) matrix, one expected output per row
+     */
+    void trainBatch(BasicNeuralNetworkFF<Scalar> &net, const Matrix &inputs, const Matrix &expected_outputs);
+
+    /**
+     * @brief The number of threads training is split across
+     *
+     */
+    inline int num_threads() const { return pool.size(); }
+
+private:
+    /**
+     * @brief The state of one thread
+     *
+     */
+    struct Worker
+    {
+        Matrix inputs;           // The shard of the batch
+        Matrix expected_outputs; // The shard of the expected outputs
+        BasicBatchWorkspace<Scalar> workspace;
+        std::vector<Scalar> gradients; // The sum of the gradients over the shard, same layout as the parameters
+    };
+
+    ThreadPool pool;
+    std::vector<Worker> workers;
+};
+
+using ParallelTrainer = BasicParallelTrainer<double>;
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * @file quantized.h
+ *
+ * @brief Inference with 8 bit weights, for deploying trained forward feed neural networks
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef QUANTIZED_H
+#define QUANTIZED_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "activation.h"
+#include "span.h"
+
+template <typename Scalar>
+class BasicNeuralNetworkFF;
+
+/**
+ * @brief A layer of a QuantizedNetworkFF. Each row of weights has its own scale, and the inputs of the
+ *        layer share one scale and zero point, so the input of neuron o is
+ *
+ *          row_scales[o] * (sum of q_weight * q_input - input_zero_point * row_sums[o]) + bias[o]
+ *
+ *        where the sum is done in integers by kernels::gemv_u8s8.
+ */
+struct QuantizedLayer
+{
+    /**
+     * @brief Work out row_sums, row_scales and layer_activation from the other members
+     *
+     */
+    void prepare();
+
+    /**
+     * @brief Quantize the inputs of the layer. The values past inputs, up to stride, are set to 0.
+     *
+     * @param values - inputs values
+     * @param quantized - stride values in [0, 127]
+     */
+    template <typename T>
+    void quantize_input(const T *values, uint8_t *quantized) const;
+
+    /**
+     * @brief Compute the activation of every neuron in the layer
+     *
+     * @param quantized - the quantized inputs from quantize_input
+     * @param sums - scratch space for outputs integers
+     * @param activation - where the outputs activations are written
+     */
+    void forward(const uint8_t *quantized, int32_t *sums, float *activation) const;
+
+    int inputs = 0;
+    int outputs = 0;
+    int stride = 0; // inputs rounded up to a multiple of 64, the row stride of weights
+
+    float input_scale = 1;      // An input x is quantized to round(x / input_scale) + input_zero_point
+    int32_t input_zero_point = 0;
+
+    std::vector<int8_t> weights;      // outputs x stride, row-major, the padding is 0
+    std::vector<float> weight_scales; // The weights of row o are weight_scales[o] times their int8 values
+    std::vector<float> bias;
+
+    std::vector<int32_t> row_sums; // The sum of the int8 weights of each row
+    std::vector<float> row_scales; // input_scale * weight_scales
+
+    std::vector<ActivationBase *> activation_functions; // Shared or custom, never owned
+    ActivationBase *layer_activation = nullptr;         // When every neuron uses the same function
+};
+
+/**
+ * @brief The scratch space for a single example going through a QuantizedNetworkFF. Giving each thread
+ *        its own workspace lets several threads share one network.
+ *
+ */
+struct QuantizedWorkspace
+{
+    std::vector<uint8_t> quantized; // The quantized inputs of the layer being computed
+    std::vector<int32_t> sums;      // The integer products of the layer being computed
+    std::vector<float> activation;  // The activations of the last layer computed
+};
+
+/**
+ * @brief A trained network with its weights quantized to 8 bits, for inference only. Each row of a weight
+ *        matrix is scaled to [-127, 127] on its own. The values going into each layer are quantized to
+ *        [0, 127] with a scale and zero point per layer, which are calibrated by running the network on
+ *        some example inputs and taking the range of the values each layer sees. The products are
+ *        summed in 32 bit integers by kernels::gemv_u8s8, the bias' and activation functions are applied
+ *        in float.
+ *
+ *        Quantized networks are a quarter the size of float networks and an eighth the size of double
+ *        networks, and have their own file format (quantized_format.h).
+ */
+class QuantizedNetworkFF
+{
+public:
+    /**
+     * @brief Quantize a trained network
+     *
+     * @param network - the network, of either precision. Custom activation functions must outlive the
+     *                  quantized network.
+     * @param calibration_begin - the first example input to calibrate on. The inputs should cover the
+     *                            range of the inputs the network will be used on, a few hundred typical
+     *                            examples are usually enough.
+     * @param calibration_end - the end of the example inputs
+     * @throws std::invalid_argument if there are no examples to calibrate on
+     */
+    template <typename Scalar, typename ExamplesIterator>
+    QuantizedNetworkFF(const BasicNeuralNetworkFF<Scalar> &network, ExamplesIterator calibration_begin,
+                       ExamplesIterator calibration_end);
+
+    /**
+     * @brief Read a network saved by save
+     *
+     * @param filename - the quantized model file
+     * @throws ModelFileError if the file can not be opened or is not a valid quantized model file
+     */
+    explicit QuantizedNetworkFF(const std::string &filename);
+
+    /**
+     * @brief Save the network in the quantized model format
+     *
+     * @param filename - the file to write
+     * @throws ModelFileError if the network has custom activation functions or the file can not be written
+     */
+    void save(const std::string &filename) const;
+
+    /**
+     * @brief Compute a forward pass. The network is not modified, so any number of threads can run
+     *        forward passes on it at once, each with its own workspace. Once the workspace and output
+     *        have been used with this network, the pass does not allocate any memory.
+     *
+     * @param input - the values of the input layer, of any arithmetic type
+     * @param output - replaced with the activations of the output layer
+     * @param workspace - the scratch space to evaluate the layers in
+     */
+    template <typename T>
+    void forwardPass(const std::vector<T> &input, std::vector<float> &output, QuantizedWorkspace &workspace) const;
+
+    /**
+     * @brief Compute a forward pass in a workspace that belongs to the calling thread
+     *
+     */
+    template <typename T>
+    void forwardPass(const std::vector<T> &input, std::vector<float> &output) const;
+
+    /**
+     * @brief Compute a forward pass
+     *
+     * @return std::vector<float> - the activations of the output layer
+     */
+    template <typename T>
+    std::vector<float> forwardPass(const std::vector<T> &input) const;
+
+    /**
+     * @brief The size of the input layer
+     *
+     */
+    inline int input_size() const { return layers.front().inputs; }
+
+    /**
+     * @brief The size of the output layer
+     *
+     */
+    inline int output_size() const { return layers.back().outputs; }
+
+    /**
+     * @brief The layers with weights, the first one takes the input layer
+     *
+     */
+    inline const std::vector<QuantizedLayer> &get_layers() const { return layers; }
+
+private:
+    /**
+     * @brief Prepare every layer and work out max_stride and max_outputs
+     *
+     */
+    void prepare_layers();
+
+    std::vector<QuantizedLayer> layers;
+    int max_stride = 0;  // The largest stride of any layer
+    int max_outputs = 0; // The most neurons in any layer
+};
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file quantized_format.h
+ *
+ * @brief The layout of the quantized model files written by QuantizedNetworkFF::save
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+/**
+ * @brief A quantized model file is laid out as follows. Like the binary model files, all values are in
+ *        the byte order of the machine that wrote the file, which is recorded in the header.
+ *
+ *          QuantizedHeader                     64 bytes
+ *          QuantizedLayerRecord x num_layers   the shape and input quantization of each layer with weights
+ *          BinaryActivation x (total activation count)
+ *                                              one per layer when every neuron in the layer uses
+ *                                              the same function, otherwise one per neuron
+ *          padding to a multiple of 64 bytes
+ *          for each layer:
+ *              weights                         neurons x stride int8 values, row-major, where stride is the
+ *                                              number of inputs rounded up to a multiple of 64 and the
+ *                                              padding is 0
+ *              weight scales                   neurons float32 values, weight = scale * int8 value
+ *              bias'                           neurons float32 values
+ *              padding to a multiple of 64 bytes
+ *
+ *        The checksum covers every byte after the header, the same way as for binary model files.
+ */
+
+#ifndef QUANTIZED_FORMAT_H
+#define QUANTIZED_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+static const char QUANTIZED_MAGIC[8] = {'C', 'R', 'A', 'N', 'K', 'Q', '8', '\0'};
+static const uint32_t QUANTIZED_VERSION = 1;
+
+struct QuantizedHeader
+{
+    char magic[8];         // QUANTIZED_MAGIC
+    uint32_t version;      // QUANTIZED_VERSION
+    uint32_t byte_order;   // BINARY_BYTE_ORDER as written by the machine that saved the file
+    uint32_t num_inputs;   // The size of the input layer
+    uint32_t num_layers;   // The layers with weights, not counting the input layer
+    uint64_t file_size;    // The size of the whole file
+    uint64_t checksum;     // binary_checksum of everything after the header
+    uint64_t reserved[3];  // 0
+};
+
+struct QuantizedLayerRecord
+{
+    uint32_t neurons;
+    uint32_t activation_count; // 1 if every neuron uses the same function, otherwise neurons
+    float input_scale;         // The inputs of the layer are input_scale * (q - input_zero_point)
+    int32_t input_zero_point;
+};
+
+static_assert(sizeof(QuantizedHeader) == 64, "The quantized header must be 64 bytes");
+static_assert(sizeof(QuantizedLayerRecord) == 16, "Quantized layer records must be 16 bytes");
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * @file random.h
+ *
+ * @brief A fast, seedable random number generator with independent streams for each thread
+ * @version 0.1
+ * @date 2022-04-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <limits>
+#include "span.h"
+
+/**
+ * @brief xoshiro256**, a small and fast generator with a period of 2^256 - 1. A generator is made from a
+ *        seed and a stream number, and the same seed and stream always give the same sequence, so each
+ *        thread (or each layer, or each block of parameters) can draw from its own stream and still be
+ *        reproducible. It meets the requirements of a UniformRandomBitGenerator, so it works with the
+ *        distributions in <random>.
+ *
+ */
+class Xoshiro256
+{
+public:
+    using result_type = uint64_t;
+
+    /**
+     * @brief Create a generator
+     *
+     * @param seed - any value, the same seed gives the same sequences
+     * @param stream - which of the seed's sequences to draw from
+     */
+    explicit Xoshiro256(uint64_t seed = 0, uint64_t stream = 0);
+
+    /**
+     * @brief The next 64 random bits
+     *
+     */
+    inline uint64_t operator()()
+    {
+        uint64_t result = rotate_left(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotate_left(state[3], 45);
+
+        return result;
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+
+    /**
+     * @brief A uniformly distributed double in [0, 1), from the top 53 bits
+     *
+     */
+    inline double uniform() { return (operator()() >> 11) * 0x1.0p-53; }
+
+    /**
+     * @brief A uniformly distributed double in [a, b)
+     *
+     */
+    inline double uniform(double a, double b) { return a + uniform() * (b - a); }
+
+    /**
+     * @brief A normally distributed double
+     *
+     */
+    double normal(double mean = 0, double stddev = 1);
+
+    /**
+     * @brief Fill values with uniformly distributed doubles in [a, b)
+     *
+     */
+    void fill_uniform(Span<double> values, double a, double b);
+
+    /**
+     * @brief Fill values with normally distributed doubles, two at a time (Box-Muller)
+     *
+     */
+    void fill_normal(Span<double> values, double mean = 0, double stddev = 1);
+
+    /**
+     * @brief Add normally distributed noise to every value
+     *
+     */
+    void add_normal(Span<double> values, double stddev);
+
+    /**
+     * @brief The same for float values, which are drawn in double and rounded
+     *
+     */
+    void fill_uniform(Span<float> values, double a, double b);
+    void fill_normal(Span<float> values, double mean = 0, double stddev = 1);
+    void add_normal(Span<float> values, double stddev);
+
+private:
+    static inline uint64_t rotate_left(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state[4];
+};
+
+/**
+ * @brief Seed the generators of every thread. Each thread draws from its own stream of the seed: the first
+ *        thread to draw after this gets stream 0, the next stream 1, and so on, so a program that draws
+ *        from one thread is reproducible. Until this is called the seed comes from std::random_device.
+ *
+ * @param seed - the seed
+ */
+void seed_random(uint64_t seed);
+
+/**
+ * @brief The generator of the calling thread. Threads never share a generator, so no locking is needed.
+ *
+ */
+Xoshiro256 &thread_random();
+
+#endif
@@ -46,6 +46,26 @@ public:
      */
     virtual double derivative(double x);
 
+    /**
+     * @brief ActivationFunctions::Sigmoid
+     * 
+     */
+    virtual ActivationFunctions type(); 
+
+    /**
+     * @brief Apply the sigmoid to every value of input using the vectorized kernel
+     * 
+     */
+    virtual void apply(Span<const double> input, Span<double> output); 
+
+    /**
+     * @brief The derivative of the sigmoid is S(x) * (1 - S(x)), so it only needs the output
+     * 
+     */
+    virtual void derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative); 
+    virtual void apply(Span<const float> input, Span<float> output); 
+    virtual void derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative); 
+
     /**
      * @brief the external repr of the Sigmoid
      * 
@@ -0,0 +1,72 @@
+/**
+ * @file span.h
+ *
+ * @brief A minimal non-owning view of a contiguous array
+ * @version 0.1
+ * @date 2022-04-03
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A pointer and a length. Used to hand a layer's values to a function without copying them.
+ *
+ * @tparam T - the element type (const T for a read-only view)
+ */
+template <typename T>
+class Span
+{
+public:
+    Span() : ptr(nullptr), len(0) {}
+
+    Span(T *ptr, size_t len) : ptr(ptr), len(len) {}
+
+    /**
+     * @brief View the whole contents of a vector
+     *
+     */
+    template <typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+    Span(std::vector<U> &vec) : ptr(vec.data()), len(vec.size()) {}
+
+    /**
+     * @brief View the whole contents of a const vector (only for read-only spans)
+     *
+     */
+    template <typename U, typename = typename std::enable_if<std::is_convertible<const U *, T *>::value>::type>
+    Span(const std::vector<U> &vec) : ptr(vec.data()), len(vec.size()) {}
+
+    /**
+     * @brief A mutable span converts to a read-only one
+     *
+     */
+    template <typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+    Span(const Span<U> &other) : ptr(other.data()), len(other.size()) {}
+
+    inline T *data() const { return ptr; }
+    inline size_t size() const { return len; }
+
+    inline T &operator[](size_t i) const { return ptr[i]; }
+
+    inline T *begin() const { return ptr; }
+    inline T *end() const { return ptr + len; }
+
+    /**
+     * @brief A view of the first count elements
+     *
+     */
+    inline Span first(size_t count) const { return Span(ptr, count); }
+
+private:
+    T *ptr;
+    size_t len;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file thread_pool.h
+ *
+ * @brief A fixed set of threads that run numbered tasks
+ * @version 0.1
+ * @date 2022-04-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A pool of size() threads, one of which is the thread that calls run. The threads are started
+ *        once and wait between calls, so run can be called for every mini-batch.
+ *
+ *        Tasks are handed out statically: thread t runs tasks t, t + size(), t + 2 * size(), ...
+ *        so the same task always runs on the same thread.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start the threads
+     *
+     * @param num_threads - the number of threads including the calling one (at least 1)
+     */
+    explicit ThreadPool(int num_threads);
+
+    /**
+     * @brief Stop and join the threads
+     *
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Run task(0) ... task(num_tasks - 1) across the threads and wait for all of them to finish.
+     *        Tasks must not throw.
+     *
+     * @param num_tasks - the number of tasks
+     * @param task - called with the index of each task
+     */
+    void run(int num_tasks, const std::function<void(int)> &task);
+
+    /**
+     * @brief The number of threads, including the one that calls run
+     *
+     */
+    inline int size() const { return threads.size() + 1; }
+
+private:
+    /**
+     * @brief The loop each background thread runs
+     *
+     * @param index - the index of the thread (1 ... size() - 1, the calling thread is 0)
+     */
+    void worker(int index);
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake; // Signals the threads that there is a new generation of tasks, or to stop
+    std::condition_variable done; // Signals run that every thread has finished
+
+    const std::function<void(int)> *task = nullptr;
+    int num_tasks = 0;
+    int running = 0;       // The number of background threads still working on the current generation
+    size_t generation = 0; // Incremented by every call to run
+    bool stop = false;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file idx.h
+ *
+ * @brief Reads the IDX files the MNIST dataset is distributed in by mapping them into memory, so the
+ *        images are used straight from the page cache without being copied or allocated one by one
+ * @version 0.1
+ * @date 2022-04-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+/**
+ * @brief An IDX file is laid out as follows, with every integer big-endian:
+ *
+ *          0x00 0x00                   magic
+ *          type                        0x08 for unsigned bytes, the only type MNIST uses
+ *          number of dimensions        1 for labels, 3 for images (count, rows, columns)
+ *          uint32 x dimensions         the size of each dimension
+ *          values                      the product of the sizes, the last dimension varying fastest
+ */
+
+#ifndef IDX_H
+#define IDX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../ff/mapped_file.h"
+#include "../ff/span.h"
+
+/**
+ * @brief An IDX file of unsigned bytes, mapped into memory
+ *
+ */
+class IdxFile
+{
+public:
+    /**
+     * @brief Map an IDX file and read its header
+     *
+     * @param filename - the file
+     * @throws std::runtime_error if the file can not be opened, is not an IDX file of unsigned bytes, or is
+     *         shorter than its header says
+     */
+    explicit IdxFile(const std::string &filename);
+
+    /**
+     * @brief The size of each dimension, the first one is the number of items
+     *
+     */
+    inline const std::vector<size_t> &dimensions() const { return sizes; }
+
+    /**
+     * @brief Every value in the file, in the order they are stored
+     *
+     */
+    inline Span<const uint8_t> values() const { return Span<const uint8_t>(first_value, count); }
+
+private:
+    std::unique_ptr<MappedFile> file;
+    std::vector<size_t> sizes;
+    const uint8_t *first_value = nullptr;
+    size_t count = 0;
+};
+
+/**
+ * @brief A view of a set of images stored one after another, as a contiguous size() x image_size() matrix
+ *        with one image per row. Each image is image_rows() x image_columns() pixels, row by row.
+ *
+ */
+class MnistImages
+{
+public:
+    MnistImages() = default;
+
+    /**
+     * @brief View the images in an IDX file with 3 dimensions
+     *
+     * @throws std::runtime_error if the file does not have 3 dimensions
+     */
+    explicit MnistImages(const IdxFile &file);
+
+    /**
+     * @brief The pixels of an image
+     *
+     */
+    inline Span<const uint8_t> operator[](size_t index) const
+    {
+        return Span<const uint8_t>(pixels + index * image_size(), image_size());
+    }
+
+    /**
+     * @brief The pixels of every image, image after image
+     *
+     */
+    inline const uint8_t *data() const { return pixels; }
+
+    inline size_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+    inline size_t image_rows() const { return rows; }
+    inline size_t image_columns() const { return columns; }
+    inline size_t image_size() const { return rows * columns; }
+
+private:
+    const uint8_t *pixels = nullptr;
+    size_t count = 0;
+    size_t rows = 0;
+    size_t columns = 0;
+};
+
+/**
+ * @brief The MNIST dataset, mapped from the four IDX files it is distributed in. Nothing is copied, the
+ *        images and labels are views into the mapped files and live as long as the dataset.
+ *
+ */
+class MappedMnistDataset
+{
+public:
+    /**
+     * @brief Map the dataset
+     *
+     * @param directory - the directory holding train-images-idx3-ubyte, train-labels-idx1-ubyte,
+     *                    t10k-images-idx3-ubyte and t10k-labels-idx1-ubyte
+     * @throws std::runtime_error if a file is missing or invalid, or a set has a different number of
+     *         images and labels
+     */
+    explicit MappedMnistDataset(const std::string &directory = "./data/");
+
+    inline const MnistImages &training_images() const { return training_image_view; }
+    inline Span<const uint8_t> training_labels() const { return training_label_file.values(); }
+    inline const MnistImages &test_images() const { return test_image_view; }
+    inline Span<const uint8_t> test_labels() const { return test_label_file.values(); }
+
+private:
+    IdxFile training_image_file;
+    IdxFile training_label_file;
+    IdxFile test_image_file;
+    IdxFile test_label_file;
+
+    MnistImages training_image_view;
+    MnistImages test_image_view;
+};
+
+/**
+ * @brief Print an image as text, a * for every pixel that is not 0
+ *
+ * @param image - the pixels, row by row
+ * @param columns - the width of the image
+ */
+void display_image(Span<const uint8_t> image, size_t columns = 28);
+
+#include "../../src/mnist/idx.cpp"
+
+#endif
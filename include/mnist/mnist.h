@@ -10,6 +10,7 @@
  */
 
 #include "mnist/include/mnist/mnist_reader.hpp"
+#include "idx.h"
 
 #define MNIST_DATASET_LOCATION "/home/fvolcic/NeuralNetworks/data"
 
@@ -19,7 +20,8 @@ using MNIST_DATASET = mnist::MNIST_dataset<std::vector, std::vector<uint8_t>, ui
  * @brief Read the MNIST dataset into memory for network training
  * 
  * @return mnist::MNIST_dataset<std::vector, std::vector<uint8_t>, uint8_t> *
- * @note The returned MNIST_DATASET is dynamically allocated
+ * @note The returned MNIST_DATASET is dynamically allocated. MappedMnistDataset (idx.h) reads the same
+ *       files without allocating or copying the images.
  * 
  */
 MNIST_DATASET * read_dataset();
@@ -8,7 +8,7 @@
  * 
  */
 
-#include <random>
+#include "ff/random.h"
 #include <sstream>
 #include <vector> 
 #include <iterator> 
@@ -18,10 +18,7 @@
 
 inline double random_nn()
 {
-    static std::uniform_real_distribution<> distr(0, 1);
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    return distr(gen);
+    return thread_random().uniform();
 }
 
 inline double random_range(double a, double b)
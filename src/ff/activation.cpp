@@ -13,8 +13,87 @@
 #define ACTIVATION_CPP
 
 #include "../../include/ff/activation.h"
+#include <charconv>
+
+/**
+ * @brief The names of the built in functions in text model files, indexed by ActivationFunctions
+ *
+ */
+static const struct
+{
+    const char *name;
+    bool has_parameter;
+} builtin_activation_functions[] = {
+    {"sigmoid", false},
+    {"linear", true},
+    {"relu", false},
+    {"leaky_relu", true},
+    {"elu", true},
+    {"gelu", false},
+    {"tanh", false},
+    {"softmax", false},
+};
+
+static const int builtin_activation_function_count = sizeof(builtin_activation_functions) / sizeof(builtin_activation_functions[0]);
+
+const char *activation_function_name(ActivationFunctions type){
+    int index = (int)type;
+    return index < builtin_activation_function_count ? builtin_activation_functions[index].name : nullptr; 
+}
+
+ActivationFunctions activation_function_from_name(std::string_view name){
+    for(int i = 0; i < builtin_activation_function_count; ++i){
+        if(name == builtin_activation_functions[i].name)
+            return (ActivationFunctions)i; 
+    }
+    return ActivationFunctions::Custom; 
+}
+
+bool activation_function_has_parameter(ActivationFunctions type){
+    int index = (int)type;
+    return index < builtin_activation_function_count && builtin_activation_functions[index].has_parameter; 
+}
+
+std::string activation_function_repr(ActivationFunctions type, double parameter){
+    std::string repr = activation_function_name(type); 
+    if(activation_function_has_parameter(type)){
+        // The shortest text that reads back as the same double
+        char buffer[32]; 
+        repr += ' '; 
+        repr.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), parameter).ptr); 
+    }
+    return repr; 
+}
 
 ActivationBase::ActivationBase(){}
 ActivationBase::~ActivationBase(){}
 
+ActivationFunctions ActivationBase::type(){
+    return ActivationFunctions::Custom; 
+}
+
+double ActivationBase::parameter(){
+    return 0; 
+}
+
+void ActivationBase::apply(Span<const double> input, Span<double> output){
+    for(size_t i = 0; i < input.size(); ++i)
+        output[i] = compute(input[i]); 
+}
+
+void ActivationBase::derivative_from_output(Span<const double> input, Span<const double> /*output*/, Span<double> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = this->derivative(input[i]); 
+}
+
+void ActivationBase::apply(Span<const float> input, Span<float> output){
+    for(size_t i = 0; i < input.size(); ++i)
+        output[i] = compute(input[i]); 
+}
+
+void ActivationBase::derivative_from_output(Span<const float> input, Span<const float> /*output*/, Span<float> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = this->derivative(input[i]); 
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,316 @@
+/**
+ * @file activation_functions.cpp
+ *
+ * @brief The activation functions declared in activation_functions.h
+ * @version 0.1
+ * @date 2022-04-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ACTIVATION_FUNCTIONS_CPP
+#define ACTIVATION_FUNCTIONS_CPP
+
+#include "../../include/ff/activation_functions.h"
+#include "../../include/ff/kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// ReLU
+
+double ReLU::compute(double x){
+    return x > 0 ? x : 0;
+}
+
+double ReLU::operator()(double x){
+    return compute(x);
+}
+
+double ReLU::derivative(double x){
+    return x > 0 ? 1 : 0;
+}
+
+ActivationFunctions ReLU::type(){
+    return ActivationFunctions::ReLU;
+}
+
+void ReLU::apply(Span<const double> input, Span<double> output){
+    kernels::leaky_relu(input.size(), 0, input.data(), output.data());
+}
+
+void ReLU::derivative_from_output(Span<const double> input, Span<const double> /*output*/, Span<double> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = input[i] > 0 ? 1 : 0;
+}
+
+void ReLU::apply(Span<const float> input, Span<float> output){
+    kernels::leaky_relu(input.size(), 0, input.data(), output.data());
+}
+
+void ReLU::derivative_from_output(Span<const float> input, Span<const float> /*output*/, Span<float> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = input[i] > 0 ? 1 : 0;
+}
+
+std::string ReLU::to_external_repr(){
+    return activation_function_repr(type(), 0);
+}
+
+// LeakyReLU
+
+double LeakyReLU::compute(double x){
+    return x > 0 ? x : slope * x;
+}
+
+double LeakyReLU::operator()(double x){
+    return compute(x);
+}
+
+double LeakyReLU::derivative(double x){
+    return x > 0 ? 1 : slope;
+}
+
+ActivationFunctions LeakyReLU::type(){
+    return ActivationFunctions::LeakyReLU;
+}
+
+double LeakyReLU::parameter(){
+    return slope;
+}
+
+void LeakyReLU::apply(Span<const double> input, Span<double> output){
+    kernels::leaky_relu(input.size(), slope, input.data(), output.data());
+}
+
+void LeakyReLU::derivative_from_output(Span<const double> input, Span<const double> /*output*/, Span<double> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = input[i] > 0 ? 1 : slope;
+}
+
+void LeakyReLU::apply(Span<const float> input, Span<float> output){
+    kernels::leaky_relu(input.size(), slope, input.data(), output.data());
+}
+
+void LeakyReLU::derivative_from_output(Span<const float> input, Span<const float> /*output*/, Span<float> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = input[i] > 0 ? 1 : slope;
+}
+
+std::string LeakyReLU::to_external_repr(){
+    return activation_function_repr(type(), slope);
+}
+
+// ELU
+
+double ELU::compute(double x){
+    return x > 0 ? x : alpha * std::expm1(x);
+}
+
+double ELU::operator()(double x){
+    return compute(x);
+}
+
+double ELU::derivative(double x){
+    return x > 0 ? 1 : alpha * std::exp(x);
+}
+
+ActivationFunctions ELU::type(){
+    return ActivationFunctions::ELU;
+}
+
+double ELU::parameter(){
+    return alpha;
+}
+
+void ELU::apply(Span<const double> input, Span<double> output){
+    kernels::elu(input.size(), alpha, input.data(), output.data());
+}
+
+void ELU::derivative_from_output(Span<const double> input, Span<const double> output, Span<double> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = input[i] > 0 ? 1 : output[i] + alpha;
+}
+
+void ELU::apply(Span<const float> input, Span<float> output){
+    kernels::elu(input.size(), alpha, input.data(), output.data());
+}
+
+void ELU::derivative_from_output(Span<const float> input, Span<const float> output, Span<float> derivative){
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = input[i] > 0 ? 1 : output[i] + (float)alpha;
+}
+
+std::string ELU::to_external_repr(){
+    return activation_function_repr(type(), alpha);
+}
+
+// GELU
+
+static const double GELU_SQRT_2_OVER_PI = 0.7978845608028654;
+static const double GELU_CUBIC = 0.044715;
+
+double GELU::compute(double x){
+    return 0.5 * x * (1 + std::tanh(GELU_SQRT_2_OVER_PI * (x + GELU_CUBIC * x * x * x)));
+}
+
+double GELU::operator()(double x){
+    return compute(x);
+}
+
+double GELU::derivative(double x){
+    // GELU(x) = x * s with s = sigmoid(2u), and ds/dx = 2 * s * (1 - s) * du/dx
+    double s = 1 / (1 + std::exp(-2 * GELU_SQRT_2_OVER_PI * (x + GELU_CUBIC * x * x * x)));
+    double du_dx = GELU_SQRT_2_OVER_PI * (1 + 3 * GELU_CUBIC * x * x);
+    return s + x * 2 * s * (1 - s) * du_dx;
+}
+
+ActivationFunctions GELU::type(){
+    return ActivationFunctions::GELU;
+}
+
+void GELU::apply(Span<const double> input, Span<double> output){
+    kernels::gelu(input.size(), input.data(), output.data());
+}
+
+/**
+ * @brief GELU::derivative_from_output in either precision
+ *
+ */
+template <typename T>
+static void gelu_derivative(Span<const T> input, Span<T> derivative){
+    const T sqrt_2_over_pi = GELU_SQRT_2_OVER_PI, cubic = GELU_CUBIC;
+
+    // s can not be recovered from output / x at x = 0, so it is computed again with the sigmoid kernel
+    for(size_t i = 0; i < input.size(); ++i)
+        derivative[i] = 2 * sqrt_2_over_pi * (input[i] + cubic * input[i] * input[i] * input[i]);
+
+    kernels::sigmoid(derivative.size(), derivative.data(), derivative.data());
+
+    for(size_t i = 0; i < input.size(); ++i){
+        T s = derivative[i];
+        T du_dx = sqrt_2_over_pi * (1 + 3 * cubic * input[i] * input[i]);
+        derivative[i] = s + input[i] * 2 * s * (1 - s) * du_dx;
+    }
+}
+
+void GELU::derivative_from_output(Span<const double> input, Span<const double> /*output*/, Span<double> derivative){
+    gelu_derivative(input, derivative);
+}
+
+void GELU::apply(Span<const float> input, Span<float> output){
+    kernels::gelu(input.size(), input.data(), output.data());
+}
+
+void GELU::derivative_from_output(Span<const float> input, Span<const float> /*output*/, Span<float> derivative){
+    gelu_derivative(input, derivative);
+}
+
+std::string GELU::to_external_repr(){
+    return activation_function_repr(type(), 0);
+}
+
+// Tanh
+
+double Tanh::compute(double x){
+    return std::tanh(x);
+}
+
+double Tanh::operator()(double x){
+    return compute(x);
+}
+
+double Tanh::derivative(double x){
+    double t = std::tanh(x);
+    return 1 - t * t;
+}
+
+ActivationFunctions Tanh::type(){
+    return ActivationFunctions::Tanh;
+}
+
+void Tanh::apply(Span<const double> input, Span<double> output){
+    kernels::tanh(input.size(), input.data(), output.data());
+}
+
+void Tanh::derivative_from_output(Span<const double> /*input*/, Span<const double> output, Span<double> derivative){
+    for(size_t i = 0; i < output.size(); ++i)
+        derivative[i] = 1 - output[i] * output[i];
+}
+
+void Tanh::apply(Span<const float> input, Span<float> output){
+    kernels::tanh(input.size(), input.data(), output.data());
+}
+
+void Tanh::derivative_from_output(Span<const float> /*input*/, Span<const float> output, Span<float> derivative){
+    for(size_t i = 0; i < output.size(); ++i)
+        derivative[i] = 1 - output[i] * output[i];
+}
+
+std::string Tanh::to_external_repr(){
+    return activation_function_repr(type(), 0);
+}
+
+// Softmax
+
+double Softmax::compute(double /*x*/){
+    throw std::logic_error("The softmax applies to a whole layer, every neuron in the layer must use it");
+}
+
+double Softmax::operator()(double x){
+    return compute(x);
+}
+
+double Softmax::derivative(double /*x*/){
+    throw std::logic_error("The softmax applies to a whole layer, every neuron in the layer must use it");
+}
+
+ActivationFunctions Softmax::type(){
+    return ActivationFunctions::Softmax;
+}
+
+/**
+ * @brief Softmax::apply in either precision
+ *
+ */
+template <typename T>
+static void softmax(Span<const T> input, Span<T> output){
+    T largest = *std::max_element(input.begin(), input.end());
+
+    for(size_t i = 0; i < input.size(); ++i)
+        output[i] = input[i] - largest;
+
+    kernels::exp(output.size(), output.data(), output.data());
+
+    // Summed in double, a float sum of many outputs would lose the small ones
+    double sum = 0;
+    for(T value : output)
+        sum += value;
+
+    kernels::scale(output.size(), (T)(1 / sum), output.data());
+}
+
+void Softmax::apply(Span<const double> input, Span<double> output){
+    softmax(input, output);
+}
+
+void Softmax::derivative_from_output(Span<const double> /*input*/, Span<const double> output, Span<double> derivative){
+    for(size_t i = 0; i < output.size(); ++i)
+        derivative[i] = output[i] * (1 - output[i]);
+}
+
+void Softmax::apply(Span<const float> input, Span<float> output){
+    softmax(input, output);
+}
+
+void Softmax::derivative_from_output(Span<const float> /*input*/, Span<const float> output, Span<float> derivative){
+    for(size_t i = 0; i < output.size(); ++i)
+        derivative[i] = output[i] * (1 - output[i]);
+}
+
+std::string Softmax::to_external_repr(){
+    return activation_function_repr(type(), 0);
+}
+
+#endif
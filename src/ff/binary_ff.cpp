@@ -0,0 +1,279 @@
+/**
+ * @file binary_ff.cpp
+ *
+ * @brief Saving and loading the binary model format described in binary_format.h
+ * @version 0.1
+ * @date 2022-04-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BINARY_FF_CPP
+#define BINARY_FF_CPP
+
+#include "../../include/ff/ff.h"
+#include "../../include/ff/binary_format.h"
+#include "../../include/ff/mapped_file.h"
+#include "../../include/ff/model_file_error.h"
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+/**
+ * @brief A 64 bit FNV-1a style hash taken 8 bytes at a time, so that checking large files stays cheap
+ *
+ */
+static uint64_t binary_checksum(const char *data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    const uint64_t prime = 1099511628211ull;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 32; // Carry the high bits of the product back down
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ (unsigned char)data[i]) * prime;
+
+    return hash;
+}
+
+/**
+ * @brief The checksum of a whole binary model file, taken with the checksum field of its header zeroed
+ *        so a corrupted header fails the check as well as corrupted records or parameters
+ *
+ */
+static uint64_t binary_file_checksum(const char *contents, size_t size)
+{
+    BinaryHeader header;
+    memcpy(&header, contents, sizeof(BinaryHeader));
+    header.checksum = 0;
+
+    uint64_t hash = binary_checksum(reinterpret_cast<const char *>(&header), sizeof(BinaryHeader));
+    return binary_checksum(contents + sizeof(BinaryHeader), size - sizeof(BinaryHeader), hash);
+}
+
+/**
+ * @brief Append the bytes of a value to a buffer
+ *
+ */
+template <typename T>
+static void append_bytes(std::vector<char> &buffer, const T &value)
+{
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * @brief Write parameters to a binary model file as T, converting them if they are stored as another type
+ *
+ */
+template <typename T, typename Scalar>
+static void store_parameters(Span<const Scalar> parameters, char *out)
+{
+    if constexpr (std::is_same_v<T, Scalar>)
+    {
+        memcpy(out, parameters.data(), parameters.size() * sizeof(T));
+    }
+    else
+    {
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            T value = parameters[i];
+            memcpy(out + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+}
+
+/**
+ * @brief Read parameters stored as T in a binary model file, converting them if the network uses another type
+ *
+ */
+template <typename T, typename Scalar>
+static void load_parameters(const char *values, std::vector<Scalar> &parameters)
+{
+    if constexpr (std::is_same_v<T, Scalar>)
+    {
+        memcpy(parameters.data(), values, parameters.size() * sizeof(T));
+    }
+    else
+    {
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            T value;
+            memcpy(&value, values + i * sizeof(T), sizeof(T));
+            parameters[i] = value;
+        }
+    }
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::save_binary(std::string filename, BinaryPrecision precision) const
+{
+    size_t scalar_size = precision == BinaryPrecision::Float32 ? sizeof(float) : sizeof(double);
+
+    // The whole file is put together in memory and written at once
+    std::vector<char> contents(sizeof(BinaryHeader));
+
+    for (const DenseLayer &layer : layers)
+    {
+        BinaryLayer record = {(uint32_t)layer.outputs, (uint32_t)(layer.layer_activation ? 1 : layer.outputs)};
+        append_bytes(contents, record);
+    }
+
+    for (const DenseLayer &layer : layers)
+    {
+        int count = layer.layer_activation ? 1 : layer.outputs;
+        for (int i = 0; i < count; ++i)
+        {
+            ActivationBase *activation_function = layer.layer_activation ? layer.layer_activation : layer.activation_functions[i];
+            if (activation_function->type() == ActivationFunctions::Custom)
+                throw ModelFileError("Custom activation functions can not be saved in a binary model file");
+
+            BinaryActivation record = {(uint32_t)activation_function->type(), 0, activation_function->parameter()};
+            append_bytes(contents, record);
+        }
+    }
+
+    contents.resize((contents.size() + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT, 0);
+    size_t parameter_offset = contents.size();
+
+    contents.resize(parameter_offset + parameters.size() * scalar_size);
+    if (precision == BinaryPrecision::Float32)
+        store_parameters<float, Scalar>(parameters, contents.data() + parameter_offset);
+    else
+        store_parameters<double, Scalar>(parameters, contents.data() + parameter_offset);
+
+    BinaryHeader header = {};
+    memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.byte_order = BINARY_BYTE_ORDER;
+    header.scalar_size = scalar_size;
+    header.num_layers = layers.size();
+    header.num_parameters = parameters.size();
+    header.parameter_offset = parameter_offset;
+    header.file_size = contents.size();
+    memcpy(contents.data(), &header, sizeof(BinaryHeader));
+    header.checksum = binary_file_checksum(contents.data(), contents.size());
+    memcpy(contents.data(), &header, sizeof(BinaryHeader));
+
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile.write(contents.data(), contents.size()))
+        throw ModelFileError("Could not write " + filename);
+}
+
+/**
+ * @brief Report a problem with a binary model file
+ *
+ */
+[[noreturn]] static void binary_format_error(const std::string &message)
+{
+    throw ModelFileError("Invalid binary model file. " + message);
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::read_binary(const std::shared_ptr<MappedFile> &file)
+{
+    const char *data = file->data();
+    size_t size = file->size();
+
+    BinaryHeader header;
+    if (size < sizeof(BinaryHeader))
+        binary_format_error("The file is too small for the header.");
+    memcpy(&header, data, sizeof(BinaryHeader));
+
+    if (header.byte_order != BINARY_BYTE_ORDER)
+        binary_format_error("It was saved on a machine with a different byte order.");
+    if (header.version != BINARY_VERSION)
+        binary_format_error("Unsupported version " + std::to_string(header.version) + ".");
+    if (header.file_size != size)
+        binary_format_error("The file is " + std::to_string(size) + " bytes, the header says " + std::to_string(header.file_size) + ".");
+    if (header.scalar_size != sizeof(double) && header.scalar_size != sizeof(float))
+        binary_format_error("Unsupported parameter size " + std::to_string(header.scalar_size) + ".");
+    if (header.checksum != binary_file_checksum(data, size))
+        binary_format_error("The checksum does not match, the file is corrupt.");
+
+    // The layer shapes, followed by the activation functions
+    size_t offset = sizeof(BinaryHeader);
+    if (header.num_layers == 0 || header.num_layers > (size - offset) / sizeof(BinaryLayer))
+        binary_format_error("Invalid number of layers.");
+
+    std::vector<BinaryLayer> layer_records(header.num_layers);
+    memcpy(layer_records.data(), data + offset, header.num_layers * sizeof(BinaryLayer));
+    offset += header.num_layers * sizeof(BinaryLayer);
+
+    std::vector<int> neuron_counts;
+    size_t num_parameters = 0;
+    for (int i = 0; i < layer_records.size(); ++i)
+    {
+        const BinaryLayer &record = layer_records[i];
+        if (record.neurons == 0 || record.neurons > std::numeric_limits<int>::max() ||
+            (record.activation_count != 1 && record.activation_count != record.neurons))
+            binary_format_error("Invalid shape for layer " + std::to_string(i) + ".");
+
+        neuron_counts.push_back(record.neurons);
+        if (i)
+            num_parameters += (size_t)record.neurons * layer_records[i - 1].neurons + record.neurons;
+    }
+
+    if (num_parameters != header.num_parameters)
+        binary_format_error("The layer shapes do not match the number of parameters.");
+    if (header.parameter_offset % BINARY_ALIGNMENT || header.parameter_offset < offset || header.parameter_offset > size ||
+        header.num_parameters > (size - header.parameter_offset) / header.scalar_size)
+        binary_format_error("Invalid parameter offset.");
+
+    allocate_layers(neuron_counts, false);
+
+    for (int i = 0; i < layers.size(); ++i)
+    {
+        DenseLayer &layer = layers[i];
+        for (int j = 0; j < layer_records[i].activation_count; ++j)
+        {
+            if (offset + sizeof(BinaryActivation) > header.parameter_offset || offset + sizeof(BinaryActivation) > size)
+                binary_format_error("The activation functions overlap the parameters.");
+
+            BinaryActivation record;
+            memcpy(&record, data + offset, sizeof(BinaryActivation));
+            offset += sizeof(BinaryActivation);
+
+            ActivationBase *activation_function = shared_activation_function((ActivationFunctions)record.type, record.parameter);
+            if (!activation_function)
+                binary_format_error("Unknown activation function " + std::to_string(record.type) + ".");
+
+            if (layer_records[i].activation_count == 1)
+                layer.activation_functions.assign(layer.outputs, activation_function);
+            else
+                layer.activation_functions[j] = activation_function;
+        }
+
+        if (mixes_softmax(layer.activation_functions))
+            binary_format_error("Only some of the neurons in layer " + std::to_string(i) + " use the softmax.");
+        layer.update_activation_type();
+    }
+
+    const char *values = data + header.parameter_offset;
+    if (header.scalar_size == sizeof(Scalar) && (uintptr_t)values % alignof(Scalar) == 0)
+    {
+        // Use the parameters where they are mapped. The mapping is copy-on-write, so training the
+        // network copies only the pages it changes, and never modifies the file.
+        parameters = Span<Scalar>(reinterpret_cast<Scalar *>(file->data() + header.parameter_offset), header.num_parameters);
+        parameter_file = file;
+    }
+    else
+    {
+        parameter_storage.resize(header.num_parameters);
+        if (header.scalar_size == sizeof(double))
+            load_parameters<double>(values, parameter_storage);
+        else
+            load_parameters<float>(values, parameter_storage);
+        parameters = Span<Scalar>(parameter_storage);
+    }
+
+    bind_layers();
+}
+
+#endif
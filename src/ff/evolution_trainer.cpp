@@ -0,0 +1,207 @@
+/**
+ * @file evolution_trainer.cpp
+ *
+ * @brief Trains a population of forward feed neural networks with a genetic algorithm on several threads
+ * @version 0.1
+ * @date 2022-04-23
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef EVOLUTION_TRAINER_CPP
+#define EVOLUTION_TRAINER_CPP
+
+#include "../../include/ff/evolution_trainer.h"
+#include "../../include/ff/ff.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+// A NaN fitness ranks below every other fitness
+static double comparable_fitness(double fitness)
+{
+    return std::isnan(fitness) ? -std::numeric_limits<double>::infinity() : fitness;
+}
+
+template <typename Scalar>
+BasicEvolutionTrainer<Scalar>::BasicEvolutionTrainer(const Network &prototype, const Config &config)
+    : config(config), pool(std::max(config.num_threads, 1)), randoms(pool.size()),
+      champion(new Network(prototype.clone())), champion_fitness(-std::numeric_limits<double>::infinity())
+{
+    if (config.population_size < 1)
+        throw std::invalid_argument("The population needs at least one organism");
+    if (config.elite_count < 0 || config.elite_count > config.population_size)
+        throw std::invalid_argument("elite_count must be between 0 and the population size");
+    if (config.selection_size < 1 || config.selection_size > config.population_size)
+        throw std::invalid_argument("selection_size must be between 1 and the population size");
+
+    uint64_t seed = config.seed ? config.seed : thread_random()();
+    for (size_t t = 0; t < randoms.size(); ++t)
+        randoms[t] = Xoshiro256(seed, t);
+
+    population.reserve(config.population_size);
+    next_population.reserve(config.population_size);
+    for (int i = 0; i < config.population_size; ++i)
+    {
+        population.push_back(prototype.clone());
+        next_population.push_back(prototype.clone());
+    }
+
+    for (int i = 1; i < config.population_size; ++i)
+        mutate(population[i], 1, randoms[0]);
+
+    fitnesses.resize(config.population_size);
+    ranking.resize(config.population_size);
+}
+
+template <typename Scalar>
+BasicEvolutionTrainer<Scalar>::~BasicEvolutionTrainer() {}
+
+template <typename Scalar>
+double BasicEvolutionTrainer<Scalar>::step(const FitnessFunction &fitness)
+{
+    int num_organisms = population.size();
+    int num_workers = pool.size();
+
+    // Thread t measures organisms t, t + num_workers, ... An exception stops that thread's share, and the
+    // first one is rethrown once every thread is done
+    std::vector<std::exception_ptr> errors(num_workers);
+    pool.run(num_workers, [&](int t) {
+        try
+        {
+            for (int i = t; i < num_organisms; i += num_workers)
+                fitnesses[i] = fitness(population[i]);
+        }
+        catch (...)
+        {
+            errors[t] = std::current_exception();
+        }
+    });
+
+    for (auto &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // Ties keep the order of the population, so the ranking does not depend on the sort
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::stable_sort(ranking.begin(), ranking.end(), [&](int a, int b) {
+        return comparable_fitness(fitnesses[a]) > comparable_fitness(fitnesses[b]);
+    });
+
+    champion->copy_parameters_from(population[ranking[0]]);
+    champion_fitness = fitnesses[ranking[0]];
+
+    // The children are written over the generation before last, so nothing is allocated
+    pool.run(num_workers, [&](int t) {
+        for (int i = t; i < num_organisms; i += num_workers)
+        {
+            if (i < config.elite_count)
+                next_population[i].copy_parameters_from(population[ranking[i]]);
+            else
+                breed(select(randoms[t]), select(randoms[t]), next_population[i], randoms[t]);
+        }
+    });
+
+    population.swap(next_population);
+    ++generations;
+
+    return champion_fitness;
+}
+
+template <typename Scalar>
+double BasicEvolutionTrainer<Scalar>::evolve(const FitnessFunction &fitness, int generations)
+{
+    for (int i = 0; i < generations; ++i)
+        step(fitness);
+
+    return champion_fitness;
+}
+
+template <typename Scalar>
+const BasicNeuralNetworkFF<Scalar> &BasicEvolutionTrainer<Scalar>::select(Xoshiro256 &random) const
+{
+    int num_organisms = population.size();
+
+    if (config.selection == Selection::Truncation)
+        return population[ranking[std::uniform_int_distribution<int>(0, config.selection_size - 1)(random)]];
+
+    std::uniform_int_distribution<int> organism(0, num_organisms - 1);
+    int best = organism(random);
+    for (int i = 1; i < config.selection_size; ++i)
+    {
+        int contender = organism(random);
+        if (comparable_fitness(fitnesses[contender]) > comparable_fitness(fitnesses[best]))
+            best = contender;
+    }
+
+    return population[best];
+}
+
+template <typename Scalar>
+void BasicEvolutionTrainer<Scalar>::breed(const Network &parent1, const Network &parent2, Network &child,
+                                          Xoshiro256 &random) const
+{
+    Span<const Scalar> a = parent1.get_parameters();
+    Span<const Scalar> b = parent2.get_parameters();
+    Span<Scalar> c = child.get_parameters();
+    size_t size = c.size();
+
+    switch (config.crossover)
+    {
+    case Crossover::Uniform:
+        // One random bit per parameter, 64 at a time
+        for (size_t begin = 0; begin < size; begin += 64)
+        {
+            unsigned long long bits = random();
+            size_t end = std::min(size, begin + 64);
+            for (size_t i = begin; i < end; ++i, bits >>= 1)
+                c[i] = bits & 1 ? a[i] : b[i];
+        }
+        break;
+
+    case Crossover::Average:
+        for (size_t i = 0; i < size; ++i)
+            c[i] = (a[i] + b[i]) / 2;
+        break;
+
+    case Crossover::SinglePoint:
+    {
+        size_t point = std::uniform_int_distribution<size_t>(0, size)(random);
+        std::copy(a.begin(), a.begin() + point, c.begin());
+        std::copy(b.begin() + point, b.end(), c.begin() + point);
+        break;
+    }
+    }
+
+    mutate(child, config.mutation_rate, random);
+}
+
+template <typename Scalar>
+void BasicEvolutionTrainer<Scalar>::mutate(Network &network, double rate, Xoshiro256 &random) const
+{
+    if (rate <= 0 || config.mutation_size == 0)
+        return;
+
+    Span<Scalar> parameters = network.get_parameters();
+
+    if (rate >= 1)
+    {
+        random.add_normal(parameters, config.mutation_size);
+        return;
+    }
+
+    // Rather than a coin toss for every parameter, skip straight to the next one that is mutated: the
+    // number of parameters between two mutations is geometrically distributed
+    std::geometric_distribution<size_t> gap(rate);
+    for (size_t i = gap(random); i < parameters.size(); i += gap(random) + 1)
+        parameters[i] += random.normal(0, config.mutation_size);
+}
+
+#endif
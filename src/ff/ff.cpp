@@ -19,134 +19,294 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <stdexcept>
+#include <utility>
 
-std::vector<std::vector<double>> random_bias_helper(std::vector<int> neuron_counts)
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts)
+    : BasicNeuralNetworkFF(num_layers, neuron_counts, thread_random()())
 {
-    std::vector<std::vector<double>> output;
-    output.resize(neuron_counts.size());
+}
+
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts, uint64_t seed)
+{
+    allocate_layers(std::vector<int>(neuron_counts.begin(), neuron_counts.begin() + num_layers));
 
-    for (int i = 0; i < output.size(); ++i)
+    // The layers draw from separate streams, so they could be filled in any order or at the same time
+    for (int x = 1; x < layers.size(); ++x)
     {
-        output[i].resize(neuron_counts[i]);
+        DenseLayer &layer = layers[x];
+        Xoshiro256 random(seed, x);
+        random.fill_uniform(Span<Scalar>(layer.weights, (size_t)layer.outputs * layer.inputs), -0.05, 0.05);
+        random.fill_uniform(Span<Scalar>(layer.bias, layer.outputs), -0.1, 0.1);
     }
+}
 
-    for (int i = 0; i < output.size(); ++i)
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts, const std::vector<std::vector<std::vector<Scalar>>> &weights, const std::vector<std::vector<Scalar>> &bias)
+{
+    allocate_layers(std::vector<int>(neuron_counts.begin(), neuron_counts.begin() + num_layers));
+
+    for (int x = 1; x < layers.size(); ++x)
     {
-        for (int j = 0; j < output[i].size(); ++j)
+        DenseLayer &layer = layers[x];
+        for (int y = 0; y < layer.outputs; ++y)
         {
-            output[i][j] = random_range(-0.1, 0.1);
-            //output[i][j] = 0;
+            layer.bias[y] = bias[x][y];
+            std::copy(weights[x][y].begin(), weights[x][y].begin() + layer.inputs, layer.weights + (size_t)y * layer.inputs);
         }
     }
-
-    return output;
 }
 
-std::vector<std::vector<std::vector<double>>> random_weight_helper(std::vector<int> neuron_counts)
-{
-
-    std::vector<std::vector<std::vector<double>>> output;
-    output.resize(neuron_counts.size());
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(const BasicNeuralNetworkFF &network) : BasicNeuralNetworkFF(network, true) {}
 
-    for (int i = 0; i < output.size(); ++i)
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(const BasicNeuralNetworkFF &network, bool copy_training_state)
+    : layers(network.layers), parameter_storage(network.parameters.begin(), network.parameters.end()),
+      parameters(parameter_storage), maxLayerSize(network.maxLayerSize), loss_function(network.loss_function)
+{
+    if (copy_training_state)
     {
-        output[i].resize(neuron_counts[i]);
+        gradient_sums = network.gradient_sums;
+        num_examples = network.num_examples;
     }
+    else
+        gradient_sums.assign(network.gradient_sums.size(), 0);
 
-    for (int i = 1; i < output.size(); ++i)
-    {
-        for (int j = 0; j < output[i].size(); ++j)
-        {
-            output[i][j].resize(neuron_counts[i - 1]);
-            for (int k = 0; k < output[i][j].size(); ++k)
-            {
-                output[i][j][k] = random_range(-0.05, 0.05);
-            }
-        }
-    }
+    bind_layers();
+}
 
-    return output;
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar> &BasicNeuralNetworkFF<Scalar>::operator=(const BasicNeuralNetworkFF &network)
+{
+    if (this == &network)
+        return *this;
+
+    layers = network.layers;
+    // A copy always owns its parameters, even if the original uses them from a mapped file
+    parameter_storage.assign(network.parameters.begin(), network.parameters.end());
+    parameter_file.reset();
+    parameters = Span<Scalar>(parameter_storage);
+    gradient_sums = network.gradient_sums;
+    num_examples = network.num_examples;
+    maxLayerSize = network.maxLayerSize;
+    loss_function = network.loss_function;
+    bind_layers();
+
+    return *this;
+}
+
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(BasicNeuralNetworkFF &&network) noexcept
+    : layers(std::move(network.layers)), parameter_storage(std::move(network.parameter_storage)),
+      parameter_file(std::move(network.parameter_file)), parameters(network.parameters),
+      gradient_sums(std::move(network.gradient_sums)), num_examples(network.num_examples),
+      neurons(std::move(network.neurons)), maxLayerSize(network.maxLayerSize),
+      batch_workspace(std::move(network.batch_workspace)), loss_function(network.loss_function)
+{
+    // The buffers moved along with the vectors, so the layers and neurons still point into them
+    network.parameters = Span<Scalar>();
+    network.num_examples = 0;
+    network.maxLayerSize = -1;
 }
 
-NeuralNetworkFF::NeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts)
-    : NeuralNetworkFF(num_layers, neuron_counts, random_weight_helper(neuron_counts), random_bias_helper(neuron_counts))
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar> &BasicNeuralNetworkFF<Scalar>::operator=(BasicNeuralNetworkFF &&network) noexcept
 {
+    if (this == &network)
+        return *this;
+
+    layers = std::move(network.layers);
+    parameter_storage = std::move(network.parameter_storage);
+    parameter_file = std::move(network.parameter_file);
+    parameters = network.parameters;
+    gradient_sums = std::move(network.gradient_sums);
+    num_examples = network.num_examples;
+    neurons = std::move(network.neurons);
+    maxLayerSize = network.maxLayerSize;
+    batch_workspace = std::move(network.batch_workspace);
+    loss_function = network.loss_function;
+
+    network.parameters = Span<Scalar>();
+    network.num_examples = 0;
+    network.maxLayerSize = -1;
+
+    return *this;
 }
 
-NeuralNetworkFF::NeuralNetworkFF(int num_layers, std::vector<int> &neuron_counts, const std::vector<std::vector<std::vector<double>>> &weights, const std::vector<std::vector<double>> &bias)
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar> BasicNeuralNetworkFF<Scalar>::clone() const
+{
+    return BasicNeuralNetworkFF(*this, false);
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::copy_parameters_from(const BasicNeuralNetworkFF &network)
+{
+    bool same_shape = layers.size() == network.layers.size();
+    for (int i = 0; same_shape && i < layers.size(); ++i)
+        same_shape = layers[i].outputs == network.layers[i].outputs;
+
+    if (!same_shape)
+        throw std::invalid_argument("copy_parameters_from needs a network with the same number of neurons in each layer");
+
+    std::copy(network.parameters.begin(), network.parameters.end(), parameters.begin());
+}
+
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::~BasicNeuralNetworkFF() {}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::allocate_layers(const std::vector<int> &neuron_counts, bool allocate_parameters)
 {
-    //Initializes first layer of Neural Network
-    neurons.resize(num_layers);
-    neurons[0].resize(neuron_counts[0]);
-    for (int i = 0; i < neuron_counts[0]; ++i)
+    layers.resize(neuron_counts.size());
+
+    size_t num_parameters = 0;
+    for (int i = 0; i < layers.size(); ++i)
     {
-        neurons[0][i] = Neuron();
+        layers[i].resize(i ? neuron_counts[i - 1] : 0, neuron_counts[i]);
+        num_parameters += layers[i].parameter_count();
     }
 
-    for (int x = 1; x < neuron_counts.size(); ++x)
+    parameter_storage.assign(allocate_parameters ? num_parameters : 0, 0);
+    parameter_file.reset();
+    parameters = Span<Scalar>(parameter_storage);
+    gradient_sums.assign(num_parameters, 0);
+    num_examples = 0;
+
+    findMaxLayerSize();
+
+    if (allocate_parameters)
+        bind_layers();
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::bind_layers()
+{
+    size_t offset = 0;
+    for (DenseLayer &layer : layers)
     {
-        neurons[x].resize(neuron_counts[x]);
-        for (int y = 0; y < neuron_counts[x]; ++y)
+        if (!layer.parameter_count())
         {
-            neurons[x][y].setBias(bias[x][y]);
-            neurons[x][y].setWeights(weights[x][y]);
+            layer.weights = layer.bias = nullptr;
+            layer.dLoss_dWeight_sum = layer.dLoss_dBias_sum = nullptr;
+            continue;
         }
-    }
-}
 
-NeuralNetworkFF::~NeuralNetworkFF() {}
+        size_t num_weights = (size_t)layer.outputs * layer.inputs;
 
-void NeuralNetworkFF::forwardPass(const std::vector<double> &input, std::vector<double> &output)
-{
-
-    if (maxLayerSize == -1)
-        findMaxLayerSize();
+        layer.weights = parameters.data() + offset;
+        layer.bias = layer.weights + num_weights;
+        layer.dLoss_dWeight_sum = gradient_sums.data() + offset;
+        layer.dLoss_dBias_sum = layer.dLoss_dWeight_sum + num_weights;
 
-    std::vector<double> intermediate_result;
-    intermediate_result.resize(maxLayerSize);
+        offset += layer.parameter_count();
+    }
 
-    // Setup all the input values for the neural network
-    for (int i = 0; i < neurons[0].size(); ++i)
+    neurons.resize(layers.size());
+    for (int i = 0; i < layers.size(); ++i)
     {
-        neurons[0][i].setOutput(input[i]);
-        intermediate_result[i] = input[i];
+        neurons[i].resize(layers[i].outputs);
+        for (int j = 0; j < layers[i].outputs; ++j)
+            neurons[i][j] = Neuron(&layers[i], i ? &layers[i - 1] : nullptr, j);
     }
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::forwardPass(const std::vector<Scalar> &input, std::vector<Scalar> &output, InferenceWorkspace &workspace) const
+{
+    workspace.reserve(maxLayerSize);
+    Span<Scalar> previous(workspace.ping);
+    Span<Scalar> current(workspace.pong);
+
+    // Setup all the input values for the neural network
+    std::copy(input.begin(), input.begin() + layers[0].outputs, previous.begin());
 
     // Compute the forward pass for the network
-    for (int i = 1; i < neurons.size(); ++i)
+    for (int i = 1; i < layers.size(); ++i)
     {
-        for (int j = 0; j < neurons[i].size(); ++j)
-        {   
-            neurons[i][j].computeInput(intermediate_result, neurons[i - 1].size());
-        }
+        const DenseLayer &layer = layers[i];
+        Span<Scalar> result = current.first(layer.outputs);
 
-        for (int j = 0; j < neurons[i].size(); ++j)
-        {
-            intermediate_result[j] = neurons[i][j].getOutput();
-        }
+        layer.compute_input(previous, result);
+        layer.activate(result, result);
+
+        std::swap(previous, current);
     }
 
-    for (int i = 0; i < neurons.back().size(); ++i)
+    output.assign(previous.begin(), previous.begin() + layers.back().outputs);
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::record_forward_pass(const std::vector<Scalar> &input)
+{
+    std::copy(input.begin(), input.begin() + layers[0].outputs, layers[0].activation.begin());
+
+    for (int i = 1; i < layers.size(); ++i)
     {
-        output.push_back(intermediate_result[i]);
+        layers[i].forward(layers[i - 1].activation);
     }
 }
 
-std::vector<double> NeuralNetworkFF::forwardPass(const std::vector<double> &input)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::forwardPass(const std::vector<Scalar> &input, std::vector<Scalar> &output) const
 {
-    std::vector<double> output;
+    static thread_local InferenceWorkspace workspace;
+    forwardPass(input, output, workspace);
+}
+
+template <typename Scalar>
+std::vector<Scalar> BasicNeuralNetworkFF<Scalar>::forwardPass(const std::vector<Scalar> &input) const
+{
+    std::vector<Scalar> output;
     forwardPass(input, output);
     return output;
 }
 
-void NeuralNetworkFF::findMaxLayerSize()
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::forwardBatch(const Matrix &inputs, Matrix &outputs, BatchWorkspace &workspace) const
+{
+    forward_batch(inputs, workspace);
+    outputs = workspace.activation.back();
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::forwardBatch(const Matrix &inputs, Matrix &outputs) const
+{
+    static thread_local BatchWorkspace workspace;
+    forwardBatch(inputs, outputs, workspace);
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::forward_batch(const Matrix &inputs, BatchWorkspace &workspace) const
+{
+    workspace.resize(layers.size());
+
+    for (int i = 1; i < layers.size(); ++i)
+    {
+        layers[i].forward_batch(i == 1 ? inputs : workspace.activation[i - 1], workspace.input[i], workspace.activation[i]);
+    }
+}
+
+template <typename Scalar>
+BasicMatrix<Scalar> BasicNeuralNetworkFF<Scalar>::forwardBatch(const Matrix &inputs) const
+{
+    Matrix outputs;
+    forwardBatch(inputs, outputs);
+    return outputs;
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::findMaxLayerSize()
 {
     maxLayerSize = 0;
-    for (int i = 0; i < neurons.size(); ++i)
+    for (int i = 0; i < layers.size(); ++i)
     {
-        if (maxLayerSize < neurons[i].size())
+        if (maxLayerSize < layers[i].outputs)
         {
-            maxLayerSize = neurons[i].size();
+            maxLayerSize = layers[i].outputs;
         }
     }
 }
@@ -155,141 +315,189 @@ void NeuralNetworkFF::findMaxLayerSize()
 // BELOW ARE THE TRAINING AND BACK PROP FUNCTIONS                 //
 ////////////////////////////////////////////////////////////////////
 
-void NeuralNetworkFF::train_on_example(const std::vector<double> &input, const std::vector<double> &expected_output)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::set_loss_function(const LossFunction *loss_function)
 {
+    this->loss_function = loss_function ? loss_function : default_loss_function();
+}
 
-    std::vector<double> output;
-    forwardPass(input, output);
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::set_activation_function(int layer, ActivationBase *activation_function)
+{
+    DenseLayer &current = layers[layer];
+    current.activation_functions.assign(current.outputs, layer_activation_function(activation_function));
+    current.update_activation_type();
+}
 
-    //BACK PROP PORTION
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::train_on_example(const std::vector<Scalar> &input, const std::vector<Scalar> &expected_output)
+{
 
-    // Step 1: compute dLoss/dActivation for the final layer in the network
-    for (int i = 0; i < output.size(); ++i)
-    {
-        double dLoss_dAct_val = 2 * (neurons.back()[i].getActivation() - expected_output[i]);
+    record_forward_pass(input);
 
-        neurons.back()[i].set_dLoss_dActivation(dLoss_dAct_val);
-    }
+    DenseLayer &output_layer = layers.back();
+    output_gradient(output_layer.input, output_layer.activation, expected_output,
+                    output_layer.dLoss_dActivation, output_layer.dActivation_dInput, output_layer.dLoss_dInput);
 
-    // Step 2: compute dActivation_dInput for the final layer in the network
-    for (int i = 0; i < output.size(); ++i)
-    {
-        Neuron &neuron = neurons.back()[i];
-        neuron.set_dActivation_dInput(neuron.getActivationFunction()->derivative(neuron.getInput()));
-    }
+    back_propagation();
 
-    // Now compute derivate of the bias and the weights for the first layer in the neural network
-    for (int i = 0; i < output.size(); ++i)
-    {
-        Neuron &neuron = neurons.back()[i];
-        calculate_dLoss_dWeight_and_dLoss_dBias(neuron, neurons.size() - 1);
-    }
+    ++num_examples;
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::trainBatch(const Matrix &inputs, const Matrix &expected_outputs)
+{
+    forward_batch(inputs, batch_workspace);
+
+    back_propagation_batch(inputs, expected_outputs, batch_workspace, gradient_sums.data());
 
-    // Call the backprop to train rest of the network
-    // TODO : Add condition small network of size 1 or 2 layers
-    if(get_num_layers()  > 2)
-        back_propagation(get_num_layers() - 2);
+    num_examples += inputs.rows;
 }
 
-void NeuralNetworkFF::back_propagation(int layer)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::train_batch_helper(const Matrix &inputs, const Matrix &expected_outputs, ParallelTrainer &parallel_trainer)
 {
-    // Calculate dLoss_dActivation for the current layer
-    for (int i = 0; i < neurons[layer].size(); ++i)
-    {
-        Neuron &neuron = neurons[layer][i];
-        this->calculate_dLoss_dActivation(neuron, layer, i);
-    }
+    if (parallel_trainer.num_threads() > 1)
+        parallel_trainer.trainBatch(*this, inputs, expected_outputs);
+    else
+        trainBatch(inputs, expected_outputs);
+}
 
-    // Step 2: compute dActivation_dInput
-    for (int i = 0; i < neurons[layer].size(); ++i)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::back_propagation_batch(const Matrix &inputs, const Matrix &expected_outputs, BatchWorkspace &workspace,
+                                                          Scalar *gradient_sums) const
+{
+    int batch = inputs.rows;
+    int last = layers.size() - 1;
+
+    // dLoss/dInput for the final layer in the network, one example at a time
+    int outputs = layers.back().outputs;
+    Matrix &output_delta = workspace.dLoss_dInput[last];
+    Matrix &output_derivative = workspace.dActivation_dInput[last];
+    output_delta.resize(batch, outputs);
+    output_derivative.resize(batch, outputs);
+    for (int e = 0; e < batch; ++e)
     {
-        Neuron &neuron = neurons[layer][i];
-        calculate_dActivation_dInput(neuron, layer);
-        // neuron.set_dActivation_dInput( neuron.getActivationFunction()->derivative( neuron.getInput() ));
+        output_gradient(Span<const Scalar>(workspace.input[last].row(e), outputs), Span<const Scalar>(workspace.activation[last].row(e), outputs),
+                        Span<const Scalar>(expected_outputs.row(e), outputs), Span<Scalar>(output_delta.row(e), outputs),
+                        Span<Scalar>(output_derivative.row(e), outputs), Span<Scalar>(output_delta.row(e), outputs));
     }
 
-    // Now compute derivate of the bias and the weights for the first layer in the neural network
-    for (int i = 0; i < neurons[layer].size(); ++i)
+    for (int layer = last; layer > 0; --layer)
     {
-        Neuron &neuron = neurons[layer][i];
-        calculate_dLoss_dWeight_and_dLoss_dBias(neuron, layer);
-    }
+        const DenseLayer &current = layers[layer];
+        const Matrix &delta = workspace.dLoss_dInput[layer];
+        const Matrix &previous_activation = layer == 1 ? inputs : workspace.activation[layer - 1];
+
+        // The gradients have the same layout as the parameters
+        Scalar *dLoss_dWeight = gradient_sums + (current.weights - parameters.data());
+        Scalar *dLoss_dBias = gradient_sums + (current.bias - parameters.data());
 
-    if (layer != 1)
-        back_propagation(layer - 1);
+        // Add the sum over the batch of delta^T * previous_activation to the gradients
+        kernels::gemm_nn(current.outputs, current.inputs, batch, 1, delta.data.data(), 1, delta.cols,
+                         previous_activation.data.data(), previous_activation.cols, dLoss_dWeight, current.inputs, true);
+
+        for (int o = 0; o < current.outputs; ++o)
+        {
+            Scalar sum = 0;
+            for (int e = 0; e < batch; ++e)
+                sum += delta(e, o);
+
+            dLoss_dBias[o] += sum;
+        }
+
+        if (layer == 1)
+            break;
+
+        // dLoss/dInput of the previous layer is (delta * weights) passed back through its activation function
+        const DenseLayer &previous = layers[layer - 1];
+        Matrix &previous_delta = workspace.dLoss_dInput[layer - 1];
+        Matrix &previous_derivative = workspace.dActivation_dInput[layer - 1];
+        previous_delta.resize(batch, previous.outputs);
+
+        kernels::gemm_nn(batch, previous.outputs, current.outputs, 1, delta.data.data(), delta.cols, 1,
+                         current.weights, current.inputs, previous_delta.data.data(), previous.outputs, false);
+
+        previous_derivative.resize(batch, previous.outputs);
+        previous.input_gradient(workspace.input[layer - 1].data, workspace.activation[layer - 1].data, previous_delta.data,
+                                previous_derivative.data, previous_delta.data);
+    }
 }
 
-void NeuralNetworkFF::calculate_dActivation_dInput(Neuron &neuron, int layer)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::output_gradient(Span<const Scalar> input, Span<const Scalar> activation, Span<const Scalar> expected,
+                                                   Span<Scalar> dLoss_dActivation, Span<Scalar> dActivation_dInput, Span<Scalar> dLoss_dInput) const
 {
-    neuron.set_dActivation_dInput(neuron.getActivationFunction()->derivative(neuron.getInput()));
+    const DenseLayer &output_layer = layers.back();
+    if (loss_function->fused_gradient(output_layer.activation_type, activation, expected, dLoss_dInput))
+        return;
+
+    loss_function->gradient(activation, expected, dLoss_dActivation);
+    output_layer.input_gradient(input, activation, dLoss_dActivation, dActivation_dInput, dLoss_dInput);
 }
 
-void NeuralNetworkFF::calculate_dLoss_dActivation(Neuron &neuron, int layer, int index)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::back_propagation()
 {
-    double dL_dA = 0;
-
-    for (int j = 0; j < neurons[layer + 1].size(); ++j)
+    for (int layer = layers.size() - 1; layer > 0; --layer)
     {
-        Neuron &neuron = neurons[layer + 1][j];
-        dL_dA += neuron.weights[index] * neuron.get_dActivation_dInput() * neuron.get_dLoss_dActivation();
-    }
+        DenseLayer &current = layers[layer];
+        DenseLayer &previous = layers[layer - 1];
 
-    neurons[layer][index].set_dLoss_dActivation(dL_dA);
-}
+        // The bias gradients are the deltas, and the weight gradients are the outer product of the
+        // deltas with the activations of the previous layer
+        kernels::axpy(current.outputs, 1, current.dLoss_dInput.data(), current.dLoss_dBias_sum);
+        kernels::ger(current.outputs, current.inputs, 1, current.dLoss_dInput.data(), previous.activation.data(), current.dLoss_dWeight_sum);
 
-// void NeuralNetworkFF::calculate_dLoss_dBias(Neuron & neuron, int layer){
+        if (layer == 1)
+            break;
 
-// }
+        // dLoss/dActivation of the previous layer is weights^T * deltas, read row by row from the weights
+        kernels::gemv_t(current.outputs, current.inputs, 1, current.weights, current.dLoss_dInput.data(), previous.dLoss_dActivation.data(), false);
+
+        previous.input_gradient(previous.input, previous.activation, previous.dLoss_dActivation, previous.dActivation_dInput, previous.dLoss_dInput);
+    }
+}
 
-void NeuralNetworkFF::calculate_dLoss_dWeight_and_dLoss_dBias(Neuron &neuron, int layer)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::update_weights(double learning_rate, bool reset)
 {
 
-    double dL_dB = neuron.get_dLoss_dActivation() * neuron.get_dActivation_dInput();
-    neuron.set_dLoss_dBias(dL_dB);
-    neuron.add_dLoss_dBias_data_point(dL_dB);
+    if (!num_examples)
+        return;
 
-    // Computes the derivate of the loss with respect to each weight
-    double dA_dZ = neuron.get_dActivation_dInput();
-    std::vector<double> dLoss_dWeights = std::vector<double>(neuron.weights.size(), 0);
+    // Every weight and bias is stored contiguously, so update them in a single pass, which also
+    // turns the sums into averages
+    kernels::axpy(parameters.size(), -learning_rate / num_examples, gradient_sums.data(), parameters.data());
 
-    double dLoss_dZ = neuron.get_dLoss_dActivation() * dA_dZ;
-    for (int j = 0; j < neuron.weights.size(); ++j)
+    if (reset)
     {
-        double dZ_dW = neurons[layer - 1][j].getActivation();
-        double dL_dW = dLoss_dZ * dZ_dW;
-        dLoss_dWeights[j] = dL_dW;
-        neuron.dLoss_dWeight[j] = dL_dW;
+        std::fill(gradient_sums.begin(), gradient_sums.end(), 0);
+        num_examples = 0;
     }
-
-    neuron.add_dLoss_dWeight_data_point(dLoss_dWeights);
 }
 
-void NeuralNetworkFF::update_weights(double learning_rate, bool reset)
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::update_weights(Optimizer &optimizer, double learning_rate, bool reset)
 {
+    if (!num_examples)
+        return;
+
+    // Optimizers work from the average gradients, which they scale the sums to as they read them, so
+    // the sums are left exact for when they are not reset
+    optimizer.step(parameters, gradient_sums, learning_rate, 1.0 / num_examples);
 
-    // Update layer by layer, neuron by neuron within each layer
-    for (int layer = 0; layer < neurons.size(); ++layer)
+    if (reset)
     {
-        for (Neuron &neuron : neurons[layer])
-        {
-            neuron.update_weights_bias(learning_rate, reset);
-        }
+        std::fill(gradient_sums.begin(), gradient_sums.end(), 0);
+        num_examples = 0;
     }
 }
 
-size_t NeuralNetworkFF::get_num_layers()
+template <typename Scalar>
+size_t BasicNeuralNetworkFF<Scalar>::get_num_layers()
 {
-    return neurons.size();
-}
-
-
-std::ostream & operator<<(std::ostream & os, const NeuralNetworkFF::TestResults & results){
-    os << "Test Results:\n\n"; 
-    os << "    Total Correct: " << results.correct << "\n";
-    os << "    Total Incorrect: " << results.incorrect << "\n";
-    os << "    Total Examples: " << results.num_examples << "\n";
-    os << "    Correct Rate: " << results.correct_rate << "\n";
-    return os; 
+    return layers.size();
 }
 
 #endif
\ No newline at end of file
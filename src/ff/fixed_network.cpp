@@ -0,0 +1,215 @@
+/**
+ * @file fixed_network.cpp
+ *
+ * @brief Forward feed neural networks with a topology fixed at compile time
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef FIXED_NETWORK_CPP
+#define FIXED_NETWORK_CPP
+
+#include "../../include/ff/fixed_network.h"
+#include "../../include/ff/ff.h"
+#include "../../include/ff/layer.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+template <typename Scalar, int... Sizes>
+BasicFixedNetwork<Scalar, Sizes...>::BasicFixedNetwork()
+{
+    parameters.fill(0);
+    activation_types.fill(ActivationFunctions::Sigmoid);
+    activation_parameters.fill(0);
+}
+
+template <typename Scalar, int... Sizes>
+template <typename NetworkScalar>
+BasicFixedNetwork<Scalar, Sizes...>::BasicFixedNetwork(const BasicNeuralNetworkFF<NetworkScalar> &network)
+    : BasicFixedNetwork()
+{
+    bool same_shape = network.layers.size() == num_layers;
+    for (int l = 0; same_shape && l < num_layers; ++l)
+        same_shape = network.layers[l].outputs == layer_sizes[l];
+    if (!same_shape)
+        throw std::invalid_argument("The network does not have the layer sizes of the fixed network");
+
+    for (int l = 1; l < num_layers; ++l)
+    {
+        ActivationBase *layer_activation = network.layers[l].layer_activation;
+        if (!layer_activation || layer_activation->type() == ActivationFunctions::Custom)
+            throw std::invalid_argument("Every neuron in layer " + std::to_string(l) +
+                                        " must use the same built in activation function");
+        set_activation_function(l, layer_activation);
+    }
+
+    Span<const NetworkScalar> source = network.get_parameters();
+    std::transform(source.begin(), source.end(), parameters.begin(),
+                   [](NetworkScalar parameter) { return (Scalar)parameter; });
+}
+
+template <typename Scalar, int... Sizes>
+BasicFixedNetwork<Scalar, Sizes...>::BasicFixedNetwork(const std::string &filename)
+    : BasicFixedNetwork(BasicNeuralNetworkFF<Scalar>(filename))
+{
+}
+
+template <typename Scalar, int... Sizes>
+template <typename NetworkScalar>
+BasicNeuralNetworkFF<NetworkScalar> BasicFixedNetwork<Scalar, Sizes...>::to_network() const
+{
+    std::vector<int> neuron_counts(layer_sizes.begin(), layer_sizes.end());
+    BasicNeuralNetworkFF<NetworkScalar> network(num_layers, neuron_counts, 0);
+
+    std::transform(parameters.begin(), parameters.end(), network.get_parameters().begin(),
+                   [](Scalar parameter) { return (NetworkScalar)parameter; });
+    for (int l = 1; l < num_layers; ++l)
+        network.set_activation_function(l, get_activation_function(l));
+
+    return network;
+}
+
+template <typename Scalar, int... Sizes>
+void BasicFixedNetwork<Scalar, Sizes...>::save_to_file(const std::string &filename) const
+{
+    to_network().save_to_file(filename);
+}
+
+template <typename Scalar, int... Sizes>
+void BasicFixedNetwork<Scalar, Sizes...>::save_binary(const std::string &filename) const
+{
+    to_network().save_binary(filename);
+}
+
+template <typename Scalar, int... Sizes>
+void BasicFixedNetwork<Scalar, Sizes...>::set_activation_function(int layer, ActivationBase *activation_function)
+{
+    if (activation_function->type() == ActivationFunctions::Custom)
+        throw std::invalid_argument("Fixed networks only use built in activation functions");
+
+    activation_types[layer] = activation_function->type();
+    activation_parameters[layer] = activation_function->parameter();
+}
+
+template <typename Scalar, int... Sizes>
+ActivationBase *BasicFixedNetwork<Scalar, Sizes...>::get_activation_function(int layer) const
+{
+    return shared_activation_function(activation_types[layer], activation_parameters[layer]);
+}
+
+template <typename Scalar, int... Sizes>
+typename BasicFixedNetwork<Scalar, Sizes...>::Output BasicFixedNetwork<Scalar, Sizes...>::forwardPass(const Input &input) const
+{
+    Output output;
+    forward_from<1>(input.data(), output.data());
+    return output;
+}
+
+template <typename Scalar, int... Sizes>
+void BasicFixedNetwork<Scalar, Sizes...>::forwardPass(const Scalar *input, Scalar *output) const
+{
+    forward_from<1>(input, output);
+}
+
+template <typename Scalar, int... Sizes>
+template <int Layer>
+void BasicFixedNetwork<Scalar, Sizes...>::forward_from(const Scalar *input, Scalar *output) const
+{
+    if constexpr (Layer == num_layers - 1)
+    {
+        forward_layer<Layer>(input, output);
+    }
+    else
+    {
+        std::array<Scalar, layer_sizes[Layer]> activation;
+        forward_layer<Layer>(input, activation.data());
+        forward_from<Layer + 1>(activation.data(), output);
+    }
+}
+
+template <typename Scalar, int... Sizes>
+template <int Layer>
+void BasicFixedNetwork<Scalar, Sizes...>::forward_layer(const Scalar *input, Scalar *activation) const
+{
+    constexpr int inputs = layer_sizes[Layer - 1];
+    constexpr int outputs = layer_sizes[Layer];
+    constexpr size_t offset = fixed_network_offset<Sizes...>(Layer);
+
+    const Scalar *weights = parameters.data() + offset;
+    const Scalar *bias = weights + (size_t)outputs * inputs;
+
+    for (int o = 0; o < outputs; ++o)
+    {
+        Scalar sum = bias[o];
+        for (int i = 0; i < inputs; ++i)
+            sum += weights[o * inputs + i] * input[i];
+        activation[o] = sum;
+    }
+
+    activate<outputs>(activation_types[Layer], activation_parameters[Layer], activation);
+}
+
+template <typename Scalar, int... Sizes>
+template <int Size>
+void BasicFixedNetwork<Scalar, Sizes...>::activate(ActivationFunctions type, double activation_parameter, Scalar *values)
+{
+    Scalar parameter = (Scalar)activation_parameter;
+
+    // The same formulas as the compute functions in activation_functions.cpp, chosen once per layer
+    switch (type)
+    {
+    case ActivationFunctions::Sigmoid:
+        for (int i = 0; i < Size; ++i)
+            values[i] = 1 / (1 + std::exp(-values[i]));
+        break;
+    case ActivationFunctions::Linear:
+        for (int i = 0; i < Size; ++i)
+            values[i] *= parameter;
+        break;
+    case ActivationFunctions::ReLU:
+        for (int i = 0; i < Size; ++i)
+            values[i] = values[i] > 0 ? values[i] : 0;
+        break;
+    case ActivationFunctions::LeakyReLU:
+        for (int i = 0; i < Size; ++i)
+            values[i] = values[i] > 0 ? values[i] : parameter * values[i];
+        break;
+    case ActivationFunctions::ELU:
+        for (int i = 0; i < Size; ++i)
+            values[i] = values[i] > 0 ? values[i] : parameter * std::expm1(values[i]);
+        break;
+    case ActivationFunctions::GELU:
+        for (int i = 0; i < Size; ++i)
+        {
+            Scalar x = values[i];
+            values[i] = (Scalar)0.5 * x * (1 + std::tanh((Scalar)GELU_SQRT_2_OVER_PI * (x + (Scalar)GELU_CUBIC * x * x * x)));
+        }
+        break;
+    case ActivationFunctions::Tanh:
+        for (int i = 0; i < Size; ++i)
+            values[i] = std::tanh(values[i]);
+        break;
+    case ActivationFunctions::Softmax:
+    {
+        Scalar largest = *std::max_element(values, values + Size);
+        double sum = 0;
+        for (int i = 0; i < Size; ++i)
+        {
+            values[i] = std::exp(values[i] - largest);
+            sum += values[i];
+        }
+        for (int i = 0; i < Size; ++i)
+            values[i] *= (Scalar)(1 / sum);
+        break;
+    }
+    case ActivationFunctions::Custom:
+        break;
+    }
+}
+
+#endif
@@ -0,0 +1,776 @@
+/**
+ * @file kernels.cpp
+ *
+ * @brief The scalar, AVX2 and AVX-512 kernels in double and float precision and for 8 bit integers, and
+ *        picking between them at runtime
+ * @version 0.1
+ * @date 2022-04-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef KERNELS_CPP
+#define KERNELS_CPP
+
+#include "../../include/ff/kernels.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace kernels
+{
+
+namespace scalar
+{
+
+namespace f64
+{
+
+using Scalar = double;
+
+struct Vec
+{
+    static constexpr int width = 1;
+    double v;
+
+    static inline Vec zero() { return {0}; }
+    static inline Vec load(const double *p) { return {*p}; }
+    static inline Vec broadcast(double x) { return {x}; }
+    inline void store(double *p) const { *p = v; }
+    inline double sum() const { return v; }
+};
+
+static inline Vec fmadd(Vec a, Vec b, Vec c) { return {a.v * b.v + c.v}; }
+static inline Vec add(Vec a, Vec b) { return {a.v + b.v}; }
+static inline Vec mul(Vec a, Vec b) { return {a.v * b.v}; }
+static inline Vec sub(Vec a, Vec b) { return {a.v - b.v}; }
+static inline Vec div(Vec a, Vec b) { return {a.v / b.v}; }
+static inline Vec sqrt(Vec a) { return {std::sqrt(a.v)}; }
+
+// Same NaN handling as maxpd / minpd: if either is NaN, b is returned
+static inline Vec max(Vec a, Vec b) { return {a.v > b.v ? a.v : b.v}; }
+static inline Vec min(Vec a, Vec b) { return {a.v < b.v ? a.v : b.v}; }
+static inline Vec round(Vec a) { return {std::nearbyint(a.v)}; }
+static inline Vec scale_by_power_of_2(Vec a, Vec k) { return {std::ldexp(a.v, (int)k.v)}; }
+
+static constexpr int NT_MR = 2, NT_NR = 2;
+static constexpr int NN_MR = 2, NN_NV = 2;
+static constexpr int GEMV_NR = 4;
+
+#include "kernels_impl.h"
+
+// Without SIMD there is nothing to gain over the library exp
+static inline Vec vexp(Vec x) { return {std::exp(x.v)}; }
+
+} // namespace f64
+
+namespace f32
+{
+
+using Scalar = float;
+
+struct Vec
+{
+    static constexpr int width = 1;
+    float v;
+
+    static inline Vec zero() { return {0}; }
+    static inline Vec load(const float *p) { return {*p}; }
+    static inline Vec broadcast(float x) { return {x}; }
+    inline void store(float *p) const { *p = v; }
+    inline float sum() const { return v; }
+};
+
+static inline Vec fmadd(Vec a, Vec b, Vec c) { return {a.v * b.v + c.v}; }
+static inline Vec add(Vec a, Vec b) { return {a.v + b.v}; }
+static inline Vec mul(Vec a, Vec b) { return {a.v * b.v}; }
+static inline Vec sub(Vec a, Vec b) { return {a.v - b.v}; }
+static inline Vec div(Vec a, Vec b) { return {a.v / b.v}; }
+static inline Vec sqrt(Vec a) { return {std::sqrt(a.v)}; }
+static inline Vec max(Vec a, Vec b) { return {a.v > b.v ? a.v : b.v}; }
+static inline Vec min(Vec a, Vec b) { return {a.v < b.v ? a.v : b.v}; }
+static inline Vec round(Vec a) { return {std::nearbyint(a.v)}; }
+static inline Vec scale_by_power_of_2(Vec a, Vec k) { return {std::ldexp(a.v, (int)k.v)}; }
+
+static constexpr int NT_MR = 2, NT_NR = 2;
+static constexpr int NN_MR = 2, NN_NV = 2;
+static constexpr int GEMV_NR = 4;
+
+#include "kernels_impl.h"
+
+static inline Vec vexp(Vec x) { return {std::exp(x.v)}; }
+
+} // namespace f32
+
+static void gemv_u8s8(int rows, int cols, const int8_t *A, const uint8_t *x, int32_t *y)
+{
+    for (int r = 0; r < rows; ++r)
+    {
+        const int8_t *row = A + (size_t)r * cols;
+        int32_t sum = 0;
+        for (int i = 0; i < cols; ++i)
+            sum += (int32_t)x[i] * row[i];
+        y[r] = sum;
+    }
+}
+
+} // namespace scalar
+
+#ifdef KERNELS_X86_SIMD
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+namespace avx2
+{
+
+namespace f64
+{
+
+using Scalar = double;
+
+struct Vec
+{
+    static constexpr int width = 4;
+    __m256d v;
+
+    static inline Vec zero() { return {_mm256_setzero_pd()}; }
+    static inline Vec load(const double *p) { return {_mm256_loadu_pd(p)}; }
+    static inline Vec broadcast(double x) { return {_mm256_set1_pd(x)}; }
+    inline void store(double *p) const { _mm256_storeu_pd(p, v); }
+    inline double sum() const
+    {
+        __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+};
+
+static inline Vec fmadd(Vec a, Vec b, Vec c) { return {_mm256_fmadd_pd(a.v, b.v, c.v)}; }
+static inline Vec add(Vec a, Vec b) { return {_mm256_add_pd(a.v, b.v)}; }
+static inline Vec mul(Vec a, Vec b) { return {_mm256_mul_pd(a.v, b.v)}; }
+static inline Vec sub(Vec a, Vec b) { return {_mm256_sub_pd(a.v, b.v)}; }
+static inline Vec div(Vec a, Vec b) { return {_mm256_div_pd(a.v, b.v)}; }
+static inline Vec sqrt(Vec a) { return {_mm256_sqrt_pd(a.v)}; }
+static inline Vec max(Vec a, Vec b) { return {_mm256_max_pd(a.v, b.v)}; }
+static inline Vec min(Vec a, Vec b) { return {_mm256_min_pd(a.v, b.v)}; }
+static inline Vec round(Vec a) { return {_mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+
+// k is a whole number in [-1022, 1023], so 2^k can be built directly in the exponent bits
+static inline Vec scale_by_power_of_2(Vec a, Vec k)
+{
+    __m256i exponent = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k.v)), _mm256_set1_epi64x(1023));
+    return {_mm256_mul_pd(a.v, _mm256_castsi256_pd(_mm256_slli_epi64(exponent, 52)))};
+}
+
+// 16 ymm registers: 8 accumulators plus the loaded values
+static constexpr int NT_MR = 4, NT_NR = 2;
+static constexpr int NN_MR = 4, NN_NV = 2;
+static constexpr int GEMV_NR = 8;
+
+#include "kernels_impl.h"
+
+static inline Vec vexp(Vec x) { return exp_approximation(x); }
+
+} // namespace f64
+
+namespace f32
+{
+
+using Scalar = float;
+
+struct Vec
+{
+    static constexpr int width = 8;
+    __m256 v;
+
+    static inline Vec zero() { return {_mm256_setzero_ps()}; }
+    static inline Vec load(const float *p) { return {_mm256_loadu_ps(p)}; }
+    static inline Vec broadcast(float x) { return {_mm256_set1_ps(x)}; }
+    inline void store(float *p) const { _mm256_storeu_ps(p, v); }
+    inline float sum() const
+    {
+        __m128 quad = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pair, _mm_movehdup_ps(pair)));
+    }
+};
+
+static inline Vec fmadd(Vec a, Vec b, Vec c) { return {_mm256_fmadd_ps(a.v, b.v, c.v)}; }
+static inline Vec add(Vec a, Vec b) { return {_mm256_add_ps(a.v, b.v)}; }
+static inline Vec mul(Vec a, Vec b) { return {_mm256_mul_ps(a.v, b.v)}; }
+static inline Vec sub(Vec a, Vec b) { return {_mm256_sub_ps(a.v, b.v)}; }
+static inline Vec div(Vec a, Vec b) { return {_mm256_div_ps(a.v, b.v)}; }
+static inline Vec sqrt(Vec a) { return {_mm256_sqrt_ps(a.v)}; }
+static inline Vec max(Vec a, Vec b) { return {_mm256_max_ps(a.v, b.v)}; }
+static inline Vec min(Vec a, Vec b) { return {_mm256_min_ps(a.v, b.v)}; }
+static inline Vec round(Vec a) { return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+
+// k is a whole number in [-126, 127], so 2^k can be built directly in the exponent bits
+static inline Vec scale_by_power_of_2(Vec a, Vec k)
+{
+    __m256i exponent = _mm256_add_epi32(_mm256_cvtps_epi32(k.v), _mm256_set1_epi32(127));
+    return {_mm256_mul_ps(a.v, _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23)))};
+}
+
+static constexpr int NT_MR = 4, NT_NR = 2;
+static constexpr int NN_MR = 4, NN_NV = 2;
+static constexpr int GEMV_NR = 8;
+
+#include "kernels_impl.h"
+
+static inline Vec vexp(Vec x) { return exp_approximation(x); }
+
+} // namespace f32
+
+struct Int8Vec
+{
+    static constexpr int width = 32;
+    __m256i v;
+
+    static inline Int8Vec zero() { return {_mm256_setzero_si256()}; }
+    static inline Int8Vec load(const void *p) { return {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))}; }
+    inline int32_t sum() const
+    {
+        __m128i quad = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        __m128i pair = _mm_add_epi32(quad, _mm_unpackhi_epi64(quad, quad));
+        return _mm_cvtsi128_si32(_mm_add_epi32(pair, _mm_shuffle_epi32(pair, 1)));
+    }
+};
+
+// Pairs of u8 * s8 products are added to 16 bits (vpmaddubsw), then pairs of those to 32 bits. The 16 bit
+// sums saturate above 32767, which is why gemv_u8s8 keeps x below 128.
+static inline Int8Vec dot_u8s8(Int8Vec sum, Int8Vec x, Int8Vec a)
+{
+    return {_mm256_add_epi32(sum.v, _mm256_madd_epi16(_mm256_maddubs_epi16(x.v, a.v), _mm256_set1_epi16(1)))};
+}
+
+#include "kernels_int8.h"
+
+} // namespace avx2
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+
+namespace avx512
+{
+
+namespace f64
+{
+
+using Scalar = double;
+
+struct Vec
+{
+    static constexpr int width = 8;
+    __m512d v;
+
+    static inline Vec zero() { return {_mm512_setzero_pd()}; }
+    static inline Vec load(const double *p) { return {_mm512_loadu_pd(p)}; }
+    static inline Vec broadcast(double x) { return {_mm512_set1_pd(x)}; }
+    inline void store(double *p) const { _mm512_storeu_pd(p, v); }
+    inline double sum() const { return _mm512_reduce_add_pd(v); }
+};
+
+static inline Vec fmadd(Vec a, Vec b, Vec c) { return {_mm512_fmadd_pd(a.v, b.v, c.v)}; }
+static inline Vec add(Vec a, Vec b) { return {_mm512_add_pd(a.v, b.v)}; }
+static inline Vec mul(Vec a, Vec b) { return {_mm512_mul_pd(a.v, b.v)}; }
+static inline Vec sub(Vec a, Vec b) { return {_mm512_sub_pd(a.v, b.v)}; }
+static inline Vec div(Vec a, Vec b) { return {_mm512_div_pd(a.v, b.v)}; }
+static inline Vec sqrt(Vec a) { return {_mm512_sqrt_pd(a.v)}; }
+static inline Vec max(Vec a, Vec b) { return {_mm512_max_pd(a.v, b.v)}; }
+static inline Vec min(Vec a, Vec b) { return {_mm512_min_pd(a.v, b.v)}; }
+static inline Vec round(Vec a) { return {_mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+static inline Vec scale_by_power_of_2(Vec a, Vec k) { return {_mm512_scalef_pd(a.v, k.v)}; }
+
+// 32 zmm registers: 16 accumulators plus the loaded values
+static constexpr int NT_MR = 4, NT_NR = 4;
+static constexpr int NN_MR = 4, NN_NV = 4;
+static constexpr int GEMV_NR = 8;
+
+#include "kernels_impl.h"
+
+static inline Vec vexp(Vec x) { return exp_approximation(x); }
+
+} // namespace f64
+
+namespace f32
+{
+
+using Scalar = float;
+
+struct Vec
+{
+    static constexpr int width = 16;
+    __m512 v;
+
+    static inline Vec zero() { return {_mm512_setzero_ps()}; }
+    static inline Vec load(const float *p) { return {_mm512_loadu_ps(p)}; }
+    static inline Vec broadcast(float x) { return {_mm512_set1_ps(x)}; }
+    inline void store(float *p) const { _mm512_storeu_ps(p, v); }
+    inline float sum() const { return _mm512_reduce_add_ps(v); }
+};
+
+static inline Vec fmadd(Vec a, Vec b, Vec c) { return {_mm512_fmadd_ps(a.v, b.v, c.v)}; }
+static inline Vec add(Vec a, Vec b) { return {_mm512_add_ps(a.v, b.v)}; }
+static inline Vec mul(Vec a, Vec b) { return {_mm512_mul_ps(a.v, b.v)}; }
+static inline Vec sub(Vec a, Vec b) { return {_mm512_sub_ps(a.v, b.v)}; }
+static inline Vec div(Vec a, Vec b) { return {_mm512_div_ps(a.v, b.v)}; }
+static inline Vec sqrt(Vec a) { return {_mm512_sqrt_ps(a.v)}; }
+static inline Vec max(Vec a, Vec b) { return {_mm512_max_ps(a.v, b.v)}; }
+static inline Vec min(Vec a, Vec b) { return {_mm512_min_ps(a.v, b.v)}; }
+static inline Vec round(Vec a) { return {_mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+static inline Vec scale_by_power_of_2(Vec a, Vec k) { return {_mm512_scalef_ps(a.v, k.v)}; }
+
+static constexpr int NT_MR = 4, NT_NR = 4;
+static constexpr int NN_MR = 4, NN_NV = 4;
+static constexpr int GEMV_NR = 16;
+
+#include "kernels_impl.h"
+
+static inline Vec vexp(Vec x) { return exp_approximation(x); }
+
+} // namespace f32
+
+} // namespace avx512
+
+#pragma GCC pop_options
+
+// The 8 bit kernels need AVX-512 BW, which every AVX-512 CPU but the Xeon Phi has, and AVX-512 VNNI for
+// the fused multiply and add. Without them the AVX2 version is used.
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx2,fma")
+
+namespace avx512bw
+{
+
+struct Int8Vec
+{
+    static constexpr int width = 64;
+    __m512i v;
+
+    static inline Int8Vec zero() { return {_mm512_setzero_si512()}; }
+    static inline Int8Vec load(const void *p) { return {_mm512_loadu_si512(p)}; }
+    inline int32_t sum() const { return _mm512_reduce_add_epi32(v); }
+};
+
+static inline Int8Vec dot_u8s8(Int8Vec sum, Int8Vec x, Int8Vec a)
+{
+    return {_mm512_add_epi32(sum.v, _mm512_madd_epi16(_mm512_maddubs_epi16(x.v, a.v), _mm512_set1_epi16(1)))};
+}
+
+#include "kernels_int8.h"
+
+} // namespace avx512bw
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vnni,avx2,fma")
+
+namespace avx512vnni
+{
+
+struct Int8Vec
+{
+    static constexpr int width = 64;
+    __m512i v;
+
+    static inline Int8Vec zero() { return {_mm512_setzero_si512()}; }
+    static inline Int8Vec load(const void *p) { return {_mm512_loadu_si512(p)}; }
+    inline int32_t sum() const { return _mm512_reduce_add_epi32(v); }
+};
+
+// vpdpbusd adds the four products of each 32 bit lane straight into the sum, without the 16 bit step
+static inline Int8Vec dot_u8s8(Int8Vec sum, Int8Vec x, Int8Vec a) { return {_mm512_dpbusd_epi32(sum.v, x.v, a.v)}; }
+
+#include "kernels_int8.h"
+
+} // namespace avx512vnni
+
+#pragma GCC pop_options
+
+namespace avx512
+{
+
+static void gemv_u8s8(int rows, int cols, const int8_t *A, const uint8_t *x, int32_t *y)
+{
+    static const auto kernel = __builtin_cpu_supports("avx512vnni") ? avx512vnni::gemv_u8s8
+                               : __builtin_cpu_supports("avx512bw") ? avx512bw::gemv_u8s8
+                                                                    : avx2::gemv_u8s8;
+    kernel(rows, cols, A, x, y);
+}
+
+} // namespace avx512
+
+#endif // KERNELS_X86_SIMD
+
+/**
+ * @brief The kernels for one instruction set and precision
+ *
+ */
+template <typename Scalar>
+struct KernelSet
+{
+    void (*gemm_nt)(int, int, int, const Scalar *, int, const Scalar *, int, const Scalar *, Scalar *, int);
+    void (*gemm_nn)(int, int, int, Scalar, const Scalar *, int, int, const Scalar *, int, Scalar *, int, bool);
+    void (*gemv)(int, int, const Scalar *, const Scalar *, const Scalar *, Scalar *);
+    void (*axpby)(long, Scalar, const Scalar *, Scalar, Scalar *);
+    void (*axpy)(long, Scalar, const Scalar *, Scalar *);
+    void (*scale)(long, Scalar, Scalar *);
+    void (*exp)(long, const Scalar *, Scalar *);
+    void (*sigmoid)(long, const Scalar *, Scalar *);
+    void (*leaky_relu)(long, Scalar, const Scalar *, Scalar *);
+    void (*elu)(long, Scalar, const Scalar *, Scalar *);
+    void (*tanh)(long, const Scalar *, Scalar *);
+    void (*gelu)(long, const Scalar *, Scalar *);
+    void (*momentum_update)(long, Scalar, Scalar, bool, Scalar, const Scalar *, Scalar *, Scalar *);
+    void (*adam_update)(long, Scalar, Scalar, Scalar, Scalar, Scalar, const Scalar *, Scalar *, Scalar *, Scalar *);
+    void (*rmsprop_update)(long, Scalar, Scalar, Scalar, Scalar, const Scalar *, Scalar *, Scalar *);
+};
+
+/**
+ * @brief The kernels for one instruction set
+ *
+ */
+struct KernelTable
+{
+    Isa isa;
+    KernelSet<double> f64;
+    KernelSet<float> f32;
+    void (*gemv_u8s8)(int, int, const int8_t *, const uint8_t *, int32_t *);
+};
+
+static const KernelTable scalar_kernels = {
+    Isa::Scalar,
+    {scalar::f64::gemm_nt, scalar::f64::gemm_nn, scalar::f64::gemv, scalar::f64::axpby, scalar::f64::axpy, scalar::f64::scale,
+     scalar::f64::exp, scalar::f64::sigmoid, scalar::f64::leaky_relu, scalar::f64::elu, scalar::f64::tanh, scalar::f64::gelu,
+     scalar::f64::momentum_update, scalar::f64::adam_update, scalar::f64::rmsprop_update},
+    {scalar::f32::gemm_nt, scalar::f32::gemm_nn, scalar::f32::gemv, scalar::f32::axpby, scalar::f32::axpy, scalar::f32::scale,
+     scalar::f32::exp, scalar::f32::sigmoid, scalar::f32::leaky_relu, scalar::f32::elu, scalar::f32::tanh, scalar::f32::gelu,
+     scalar::f32::momentum_update, scalar::f32::adam_update, scalar::f32::rmsprop_update},
+    scalar::gemv_u8s8};
+
+#ifdef KERNELS_X86_SIMD
+static const KernelTable avx2_kernels = {
+    Isa::AVX2,
+    {avx2::f64::gemm_nt, avx2::f64::gemm_nn, avx2::f64::gemv, avx2::f64::axpby, avx2::f64::axpy, avx2::f64::scale,
+     avx2::f64::exp, avx2::f64::sigmoid, avx2::f64::leaky_relu, avx2::f64::elu, avx2::f64::tanh, avx2::f64::gelu,
+     avx2::f64::momentum_update, avx2::f64::adam_update, avx2::f64::rmsprop_update},
+    {avx2::f32::gemm_nt, avx2::f32::gemm_nn, avx2::f32::gemv, avx2::f32::axpby, avx2::f32::axpy, avx2::f32::scale,
+     avx2::f32::exp, avx2::f32::sigmoid, avx2::f32::leaky_relu, avx2::f32::elu, avx2::f32::tanh, avx2::f32::gelu,
+     avx2::f32::momentum_update, avx2::f32::adam_update, avx2::f32::rmsprop_update},
+    avx2::gemv_u8s8};
+static const KernelTable avx512_kernels = {
+    Isa::AVX512,
+    {avx512::f64::gemm_nt, avx512::f64::gemm_nn, avx512::f64::gemv, avx512::f64::axpby, avx512::f64::axpy, avx512::f64::scale,
+     avx512::f64::exp, avx512::f64::sigmoid, avx512::f64::leaky_relu, avx512::f64::elu, avx512::f64::tanh, avx512::f64::gelu,
+     avx512::f64::momentum_update, avx512::f64::adam_update, avx512::f64::rmsprop_update},
+    {avx512::f32::gemm_nt, avx512::f32::gemm_nn, avx512::f32::gemv, avx512::f32::axpby, avx512::f32::axpy, avx512::f32::scale,
+     avx512::f32::exp, avx512::f32::sigmoid, avx512::f32::leaky_relu, avx512::f32::elu, avx512::f32::tanh, avx512::f32::gelu,
+     avx512::f32::momentum_update, avx512::f32::adam_update, avx512::f32::rmsprop_update},
+    avx512::gemv_u8s8};
+#endif
+
+/**
+ * @brief The table for isa, or nullptr if the CPU does not support it
+ *
+ */
+static const KernelTable *kernel_table(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return &scalar_kernels;
+#ifdef KERNELS_X86_SIMD
+    case Isa::AVX2:
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return &avx2_kernels;
+        return nullptr;
+    case Isa::AVX512:
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return &avx512_kernels;
+        return nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief The kernels in use. Starts out as the best ones the CPU supports.
+ *
+ */
+static const KernelTable *&active_kernels()
+{
+    static const KernelTable *active = kernel_table(Isa::AVX512) ? kernel_table(Isa::AVX512)
+                                       : kernel_table(Isa::AVX2) ? kernel_table(Isa::AVX2)
+                                                                 : &scalar_kernels;
+    return active;
+}
+
+bool supported(Isa isa)
+{
+    return kernel_table(isa) != nullptr;
+}
+
+bool select(Isa isa)
+{
+    const KernelTable *table = kernel_table(isa);
+    if (!table)
+        return false;
+
+    active_kernels() = table;
+    return true;
+}
+
+Isa selected()
+{
+    return active_kernels()->isa;
+}
+
+const char *isa_name(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+/**
+ * @brief The kernels in use for a precision
+ *
+ */
+template <typename Scalar>
+static inline const KernelSet<Scalar> &active_set();
+
+template <>
+inline const KernelSet<double> &active_set<double>() { return active_kernels()->f64; }
+
+template <>
+inline const KernelSet<float> &active_set<float>() { return active_kernels()->f32; }
+
+// Each kernel is written once for both precisions, and the overloads in kernels.h forward to these
+
+template <typename Scalar>
+static inline void dispatch_gemm_nt(int m, int n, int k, const Scalar *A, int lda, const Scalar *B, int ldb,
+                                    const Scalar *bias, Scalar *C, int ldc)
+{
+    active_set<Scalar>().gemm_nt(m, n, k, A, lda, B, ldb, bias, C, ldc);
+}
+
+template <typename Scalar>
+static inline void dispatch_gemv_t(int rows, int cols, Scalar alpha, const Scalar *A, const Scalar *x, Scalar *y, bool accumulate)
+{
+    // y^T = x^T * A, a single row of gemm_nn
+    active_set<Scalar>().gemm_nn(1, cols, rows, alpha, x, 0, 1, A, cols, y, cols, accumulate);
+}
+
+template <typename Scalar>
+static inline void dispatch_ger(int rows, int cols, Scalar alpha, const Scalar *x, const Scalar *y, Scalar *A)
+{
+    // A += x * y^T, gemm_nn with an inner dimension of 1
+    active_set<Scalar>().gemm_nn(rows, cols, 1, alpha, x, 1, 0, y, cols, A, cols, true);
+}
+
+void gemm_nt(int m, int n, int k, const double *A, int lda, const double *B, int ldb,
+             const double *bias, double *C, int ldc)
+{
+    dispatch_gemm_nt(m, n, k, A, lda, B, ldb, bias, C, ldc);
+}
+
+void gemm_nt(int m, int n, int k, const float *A, int lda, const float *B, int ldb,
+             const float *bias, float *C, int ldc)
+{
+    dispatch_gemm_nt(m, n, k, A, lda, B, ldb, bias, C, ldc);
+}
+
+void gemm_nn(int m, int n, int k, double alpha, const double *A, int a_row_stride, int a_col_stride,
+             const double *B, int ldb, double *C, int ldc, bool accumulate)
+{
+    active_set<double>().gemm_nn(m, n, k, alpha, A, a_row_stride, a_col_stride, B, ldb, C, ldc, accumulate);
+}
+
+void gemm_nn(int m, int n, int k, float alpha, const float *A, int a_row_stride, int a_col_stride,
+             const float *B, int ldb, float *C, int ldc, bool accumulate)
+{
+    active_set<float>().gemm_nn(m, n, k, alpha, A, a_row_stride, a_col_stride, B, ldb, C, ldc, accumulate);
+}
+
+void gemv(int rows, int cols, const double *A, const double *x, const double *bias, double *y)
+{
+    active_set<double>().gemv(rows, cols, A, x, bias, y);
+}
+
+void gemv(int rows, int cols, const float *A, const float *x, const float *bias, float *y)
+{
+    active_set<float>().gemv(rows, cols, A, x, bias, y);
+}
+
+void gemv_t(int rows, int cols, double alpha, const double *A, const double *x, double *y, bool accumulate)
+{
+    dispatch_gemv_t(rows, cols, alpha, A, x, y, accumulate);
+}
+
+void gemv_t(int rows, int cols, float alpha, const float *A, const float *x, float *y, bool accumulate)
+{
+    dispatch_gemv_t(rows, cols, alpha, A, x, y, accumulate);
+}
+
+void ger(int rows, int cols, double alpha, const double *x, const double *y, double *A)
+{
+    dispatch_ger(rows, cols, alpha, x, y, A);
+}
+
+void ger(int rows, int cols, float alpha, const float *x, const float *y, float *A)
+{
+    dispatch_ger(rows, cols, alpha, x, y, A);
+}
+
+void axpby(long n, double alpha, const double *x, double beta, double *y)
+{
+    active_set<double>().axpby(n, alpha, x, beta, y);
+}
+
+void axpby(long n, float alpha, const float *x, float beta, float *y)
+{
+    active_set<float>().axpby(n, alpha, x, beta, y);
+}
+
+void axpy(long n, double alpha, const double *x, double *y)
+{
+    active_set<double>().axpy(n, alpha, x, y);
+}
+
+void axpy(long n, float alpha, const float *x, float *y)
+{
+    active_set<float>().axpy(n, alpha, x, y);
+}
+
+void scale(long n, double alpha, double *x)
+{
+    active_set<double>().scale(n, alpha, x);
+}
+
+void scale(long n, float alpha, float *x)
+{
+    active_set<float>().scale(n, alpha, x);
+}
+
+void exp(long n, const double *x, double *y)
+{
+    active_set<double>().exp(n, x, y);
+}
+
+void exp(long n, const float *x, float *y)
+{
+    active_set<float>().exp(n, x, y);
+}
+
+void sigmoid(long n, const double *x, double *y)
+{
+    active_set<double>().sigmoid(n, x, y);
+}
+
+void sigmoid(long n, const float *x, float *y)
+{
+    active_set<float>().sigmoid(n, x, y);
+}
+
+void leaky_relu(long n, double slope, const double *x, double *y)
+{
+    active_set<double>().leaky_relu(n, slope, x, y);
+}
+
+void leaky_relu(long n, float slope, const float *x, float *y)
+{
+    active_set<float>().leaky_relu(n, slope, x, y);
+}
+
+void elu(long n, double alpha, const double *x, double *y)
+{
+    active_set<double>().elu(n, alpha, x, y);
+}
+
+void elu(long n, float alpha, const float *x, float *y)
+{
+    active_set<float>().elu(n, alpha, x, y);
+}
+
+void tanh(long n, const double *x, double *y)
+{
+    active_set<double>().tanh(n, x, y);
+}
+
+void tanh(long n, const float *x, float *y)
+{
+    active_set<float>().tanh(n, x, y);
+}
+
+void gelu(long n, const double *x, double *y)
+{
+    active_set<double>().gelu(n, x, y);
+}
+
+void gelu(long n, const float *x, float *y)
+{
+    active_set<float>().gelu(n, x, y);
+}
+
+void momentum_update(long n, double learning_rate, double momentum, bool nesterov, double gradient_scale,
+                     const double *gradients, double *velocity, double *parameters)
+{
+    active_set<double>().momentum_update(n, learning_rate, momentum, nesterov, gradient_scale, gradients, velocity, parameters);
+}
+
+void momentum_update(long n, float learning_rate, float momentum, bool nesterov, float gradient_scale,
+                     const float *gradients, float *velocity, float *parameters)
+{
+    active_set<float>().momentum_update(n, learning_rate, momentum, nesterov, gradient_scale, gradients, velocity, parameters);
+}
+
+void adam_update(long n, double step_size, double beta1, double beta2, double epsilon, double gradient_scale,
+                 const double *gradients, double *first_moment, double *second_moment, double *parameters)
+{
+    active_set<double>().adam_update(n, step_size, beta1, beta2, epsilon, gradient_scale, gradients, first_moment, second_moment, parameters);
+}
+
+void adam_update(long n, float step_size, float beta1, float beta2, float epsilon, float gradient_scale,
+                 const float *gradients, float *first_moment, float *second_moment, float *parameters)
+{
+    active_set<float>().adam_update(n, step_size, beta1, beta2, epsilon, gradient_scale, gradients, first_moment, second_moment, parameters);
+}
+
+void rmsprop_update(long n, double learning_rate, double decay, double epsilon, double gradient_scale,
+                    const double *gradients, double *mean_square, double *parameters)
+{
+    active_set<double>().rmsprop_update(n, learning_rate, decay, epsilon, gradient_scale, gradients, mean_square, parameters);
+}
+
+void rmsprop_update(long n, float learning_rate, float decay, float epsilon, float gradient_scale,
+                    const float *gradients, float *mean_square, float *parameters)
+{
+    active_set<float>().rmsprop_update(n, learning_rate, decay, epsilon, gradient_scale, gradients, mean_square, parameters);
+}
+
+void gemv_u8s8(int rows, int cols, const int8_t *A, const uint8_t *x, int32_t *y)
+{
+    active_kernels()->gemv_u8s8(rows, cols, A, x, y);
+}
+
+} // namespace kernels
+
+#endif
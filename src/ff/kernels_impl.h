@@ -0,0 +1,467 @@
+/**
+ * @file kernels_impl.h
+ *
+ * @brief The instruction set independent part of the kernels
+ * @version 0.1
+ * @date 2022-04-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note This file has no include guard on purpose. kernels.cpp includes it once per instruction set and
+ *       precision, inside a namespace that defines:
+ *          Scalar - double or float
+ *          Vec - a SIMD register of Scalars with width, zero, load, broadcast, store and sum
+ *          fmadd(a, b, c), add(a, b), mul(a, b), sub(a, b), div(a, b), sqrt(a)
+ *          max(a, b), min(a, b) - returning b when either is NaN, like maxpd / minpd
+ *          round(a) - round to the nearest whole number
+ *          scale_by_power_of_2(a, k) - a * 2^k for whole numbers k in the range of normal Scalars
+ *       and, after including this file, vexp(x) - e^x, usually exp_approximation
+ *          NT_MR, NT_NR - the register block used by gemm_nt (rows of A x rows of B)
+ *          NN_MR, NN_NV - the register block used by gemm_nn (rows of A x vectors of B)
+ *          GEMV_NR - the number of rows of the matrix gemv works on at once
+ */
+
+// The loops over the register blocks below have compile time trip counts and are fully unrolled so that
+// the accumulators live in registers.
+
+// The number of columns of A and B (for gemm_nt) or rows of B (for gemm_nn) worked on at a time,
+// so that the blocks being reused stay in the L1 cache
+static constexpr int KC = 256;
+
+static inline Vec vexp(Vec x);
+
+/**
+ * @brief C (MR x NR) += A (MR x k) * B (NR x k)^T, keeping all of C in registers
+ *
+ */
+template <int MR, int NR>
+static inline void nt_block(int k, const Scalar *A, int lda, const Scalar *B, int ldb, Scalar *C, int ldc)
+{
+    Vec acc[MR][NR];
+    #pragma GCC unroll 16
+    for (int i = 0; i < MR; ++i)
+        #pragma GCC unroll 16
+        for (int j = 0; j < NR; ++j)
+            acc[i][j] = Vec::zero();
+
+    int p = 0;
+    for (; p + Vec::width <= k; p += Vec::width)
+    {
+        Vec b[NR];
+        #pragma GCC unroll 16
+        for (int j = 0; j < NR; ++j)
+            b[j] = Vec::load(B + (size_t)j * ldb + p);
+
+        #pragma GCC unroll 16
+        for (int i = 0; i < MR; ++i)
+        {
+            Vec a = Vec::load(A + (size_t)i * lda + p);
+            #pragma GCC unroll 16
+            for (int j = 0; j < NR; ++j)
+                acc[i][j] = fmadd(a, b[j], acc[i][j]);
+        }
+    }
+
+    #pragma GCC unroll 16
+    for (int i = 0; i < MR; ++i)
+    {
+        #pragma GCC unroll 16
+        for (int j = 0; j < NR; ++j)
+        {
+            Scalar sum = acc[i][j].sum();
+            for (int q = p; q < k; ++q)
+                sum += A[(size_t)i * lda + q] * B[(size_t)j * ldb + q];
+            C[(size_t)i * ldc + j] += sum;
+        }
+    }
+}
+
+void gemv(int rows, int cols, const Scalar *A, const Scalar *x, const Scalar *bias, Scalar *y)
+{
+    int r = 0;
+    for (; r + GEMV_NR <= rows; r += GEMV_NR)
+    {
+        for (int j = 0; j < GEMV_NR; ++j)
+            y[r + j] = bias ? bias[r + j] : 0;
+        nt_block<1, GEMV_NR>(cols, x, cols, A + (size_t)r * cols, cols, y + r, 1);
+    }
+    for (; r < rows; ++r)
+    {
+        y[r] = bias ? bias[r] : 0;
+        nt_block<1, 1>(cols, x, cols, A + (size_t)r * cols, cols, y + r, 1);
+    }
+}
+
+void gemm_nt(int m, int n, int k, const Scalar *A, int lda, const Scalar *B, int ldb,
+             const Scalar *bias, Scalar *C, int ldc)
+{
+    if (m == 1)
+    {
+        gemv(n, k, B, A, bias, C);
+        return;
+    }
+
+    for (int i = 0; i < m; ++i)
+        for (int j = 0; j < n; ++j)
+            C[(size_t)i * ldc + j] = bias ? bias[j] : 0;
+
+    for (int p = 0; p < k; p += KC)
+    {
+        int kc = k - p < KC ? k - p : KC;
+
+        // The NR rows of B stay in L1 while every row of A is multiplied with them
+        int j = 0;
+        for (; j + NT_NR <= n; j += NT_NR)
+        {
+            const Scalar *b = B + (size_t)j * ldb + p;
+            int i = 0;
+            for (; i + NT_MR <= m; i += NT_MR)
+                nt_block<NT_MR, NT_NR>(kc, A + (size_t)i * lda + p, lda, b, ldb, C + (size_t)i * ldc + j, ldc);
+            for (; i < m; ++i)
+                nt_block<1, NT_NR>(kc, A + (size_t)i * lda + p, lda, b, ldb, C + (size_t)i * ldc + j, ldc);
+        }
+        for (; j < n; ++j)
+        {
+            const Scalar *b = B + (size_t)j * ldb + p;
+            int i = 0;
+            for (; i + NT_MR <= m; i += NT_MR)
+                nt_block<NT_MR, 1>(kc, A + (size_t)i * lda + p, lda, b, ldb, C + (size_t)i * ldc + j, ldc);
+            for (; i < m; ++i)
+                nt_block<1, 1>(kc, A + (size_t)i * lda + p, lda, b, ldb, C + (size_t)i * ldc + j, ldc);
+        }
+    }
+}
+
+/**
+ * @brief C (MR x NV vectors) = alpha * A (MR x k) * B (k x NV vectors) (+ C), keeping all of C in registers
+ *
+ */
+template <int MR, int NV>
+static inline void nn_block(int k, Scalar alpha, const Scalar *A, int a_row_stride, int a_col_stride,
+                            const Scalar *B, int ldb, Scalar *C, int ldc, bool accumulate)
+{
+    Vec acc[MR][NV];
+    #pragma GCC unroll 16
+    for (int i = 0; i < MR; ++i)
+        #pragma GCC unroll 16
+        for (int v = 0; v < NV; ++v)
+            acc[i][v] = Vec::zero();
+
+    for (int p = 0; p < k; ++p)
+    {
+        Vec b[NV];
+        #pragma GCC unroll 16
+        for (int v = 0; v < NV; ++v)
+            b[v] = Vec::load(B + (size_t)p * ldb + v * Vec::width);
+
+        #pragma GCC unroll 16
+        for (int i = 0; i < MR; ++i)
+        {
+            Vec a = Vec::broadcast(A[(size_t)i * a_row_stride + (size_t)p * a_col_stride]);
+            #pragma GCC unroll 16
+            for (int v = 0; v < NV; ++v)
+                acc[i][v] = fmadd(a, b[v], acc[i][v]);
+        }
+    }
+
+    Vec scale = Vec::broadcast(alpha);
+    #pragma GCC unroll 16
+    for (int i = 0; i < MR; ++i)
+    {
+        #pragma GCC unroll 16
+        for (int v = 0; v < NV; ++v)
+        {
+            Scalar *c = C + (size_t)i * ldc + v * Vec::width;
+            Vec result = mul(acc[i][v], scale);
+            if (accumulate)
+                result = add(result, Vec::load(c));
+            result.store(c);
+        }
+    }
+}
+
+/**
+ * @brief A single column of C, used for the columns left over after the vector blocks
+ *
+ */
+static inline void nn_column(int m, int k, Scalar alpha, const Scalar *A, int a_row_stride, int a_col_stride,
+                             const Scalar *B, int ldb, Scalar *C, int ldc, bool accumulate)
+{
+    for (int i = 0; i < m; ++i)
+    {
+        Scalar sum = 0;
+        for (int p = 0; p < k; ++p)
+            sum += A[(size_t)i * a_row_stride + (size_t)p * a_col_stride] * B[(size_t)p * ldb];
+
+        Scalar &c = C[(size_t)i * ldc];
+        c = accumulate ? c + alpha * sum : alpha * sum;
+    }
+}
+
+void gemm_nn(int m, int n, int k, Scalar alpha, const Scalar *A, int a_row_stride, int a_col_stride,
+             const Scalar *B, int ldb, Scalar *C, int ldc, bool accumulate)
+{
+    constexpr int W = Vec::width;
+
+    if (k == 0 && !accumulate)
+    {
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j < n; ++j)
+                C[(size_t)i * ldc + j] = 0;
+        return;
+    }
+
+    for (int p = 0; p < k; p += KC)
+    {
+        int kc = k - p < KC ? k - p : KC;
+        const Scalar *a = A + (size_t)p * a_col_stride;
+        bool acc = accumulate || p > 0;
+
+        // The kc x (NV vectors) panel of B stays in L1 while every row of A is multiplied with it
+        int j = 0;
+        for (; j + NN_NV * W <= n; j += NN_NV * W)
+        {
+            const Scalar *b = B + (size_t)p * ldb + j;
+            int i = 0;
+            for (; i + NN_MR <= m; i += NN_MR)
+                nn_block<NN_MR, NN_NV>(kc, alpha, a + (size_t)i * a_row_stride, a_row_stride, a_col_stride, b, ldb, C + (size_t)i * ldc + j, ldc, acc);
+            for (; i < m; ++i)
+                nn_block<1, NN_NV>(kc, alpha, a + (size_t)i * a_row_stride, a_row_stride, a_col_stride, b, ldb, C + (size_t)i * ldc + j, ldc, acc);
+        }
+        for (; j + W <= n; j += W)
+        {
+            const Scalar *b = B + (size_t)p * ldb + j;
+            int i = 0;
+            for (; i + NN_MR <= m; i += NN_MR)
+                nn_block<NN_MR, 1>(kc, alpha, a + (size_t)i * a_row_stride, a_row_stride, a_col_stride, b, ldb, C + (size_t)i * ldc + j, ldc, acc);
+            for (; i < m; ++i)
+                nn_block<1, 1>(kc, alpha, a + (size_t)i * a_row_stride, a_row_stride, a_col_stride, b, ldb, C + (size_t)i * ldc + j, ldc, acc);
+        }
+        for (; j < n; ++j)
+            nn_column(m, kc, alpha, a, a_row_stride, a_col_stride, B + (size_t)p * ldb + j, ldb, C + j, ldc, acc);
+    }
+}
+
+void axpby(long n, Scalar alpha, const Scalar *x, Scalar beta, Scalar *y)
+{
+    Vec a = Vec::broadcast(alpha);
+    Vec b = Vec::broadcast(beta);
+
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+        fmadd(a, Vec::load(x + i), mul(b, Vec::load(y + i))).store(y + i);
+    for (; i < n; ++i)
+        y[i] = std::fma(alpha, x[i], beta * y[i]);
+}
+
+void axpy(long n, Scalar alpha, const Scalar *x, Scalar *y)
+{
+    Vec a = Vec::broadcast(alpha);
+
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+        fmadd(a, Vec::load(x + i), Vec::load(y + i)).store(y + i);
+    for (; i < n; ++i)
+        y[i] = std::fma(alpha, x[i], y[i]);
+}
+
+void scale(long n, Scalar alpha, Scalar *x)
+{
+    Vec a = Vec::broadcast(alpha);
+
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+        mul(a, Vec::load(x + i)).store(x + i);
+    for (; i < n; ++i)
+        x[i] *= alpha;
+}
+
+/**
+ * @brief e^x to within a couple of ulps. x is split into k * ln(2) + r with |r| <= ln(2) / 2, so that
+ *        e^x = 2^k * e^r, and e^r is the Taylor series to degree 13 for doubles and 7 for floats (the
+ *        remainder is below the precision of either). Inputs are clamped to [-708, 708] ([-87, 87] for
+ *        floats) so that 2^k stays a normal number. NaN is kept as NaN.
+ *
+ */
+static inline Vec exp_approximation(Vec x)
+{
+    constexpr bool single = sizeof(Scalar) == sizeof(float);
+
+    // ln(2) split into a high part with few enough bits that k * ln2_high is exact, and the rest
+    const Vec log2e = Vec::broadcast(1.4426950408889634074);
+    const Vec ln2_high = Vec::broadcast(single ? 6.93359375e-1 : 6.93145751953125e-1);
+    const Vec ln2_low = Vec::broadcast(single ? -2.12194440e-4 : 1.42860682030941723212e-6);
+    const Scalar limit = single ? 87 : 708;
+
+    x = min(Vec::broadcast(limit), max(Vec::broadcast(-limit), x));
+
+    Vec k = round(mul(x, log2e));
+    Vec r = sub(x, mul(k, ln2_high));
+    r = sub(r, mul(k, ln2_low));
+
+    static constexpr Scalar inverse_factorials[] = {
+        1.0 / 6227020800, 1.0 / 479001600, 1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880,
+        1.0 / 40320, 1.0 / 5040, 1.0 / 720, 1.0 / 120, 1.0 / 24, 1.0 / 6, 1.0 / 2, 1, 1};
+    constexpr int first = single ? 6 : 0; // 1 / 7!
+
+    Vec p = Vec::broadcast(inverse_factorials[first]);
+    #pragma GCC unroll 16
+    for (int i = first + 1; i < 14; ++i)
+        p = fmadd(p, r, Vec::broadcast(inverse_factorials[i]));
+
+    return scale_by_power_of_2(p, k);
+}
+
+/**
+ * @brief Apply op to n values a vector at a time. The last partial vector goes through a padded copy,
+ *        so every value gets exactly the same treatment wherever it sits in the array.
+ *
+ */
+template <typename Op>
+static inline void elementwise(long n, const Scalar *x, Scalar *y, Op op)
+{
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+        op(Vec::load(x + i)).store(y + i);
+
+    if (i < n)
+    {
+        Scalar padded[Vec::width] = {};
+        for (long j = i; j < n; ++j)
+            padded[j - i] = x[j];
+        op(Vec::load(padded)).store(padded);
+        for (long j = i; j < n; ++j)
+            y[j] = padded[j - i];
+    }
+}
+
+void exp(long n, const Scalar *x, Scalar *y)
+{
+    elementwise(n, x, y, [](Vec v) { return vexp(v); });
+}
+
+void sigmoid(long n, const Scalar *x, Scalar *y)
+{
+    elementwise(n, x, y, [](Vec v) {
+        const Vec one = Vec::broadcast(1);
+        return div(one, add(one, vexp(sub(Vec::zero(), v))));
+    });
+}
+
+// The activation functions below split x into max(0, x) and min(0, x), which keep NaN as NaN
+
+void leaky_relu(long n, Scalar slope, const Scalar *x, Scalar *y)
+{
+    const Vec s = Vec::broadcast(slope);
+    elementwise(n, x, y, [&](Vec v) { return fmadd(s, min(Vec::zero(), v), max(Vec::zero(), v)); });
+}
+
+void elu(long n, Scalar alpha, const Scalar *x, Scalar *y)
+{
+    const Vec a = Vec::broadcast(alpha);
+    elementwise(n, x, y, [&](Vec v) {
+        const Vec one = Vec::broadcast(1);
+        return fmadd(a, sub(vexp(min(Vec::zero(), v)), one), max(Vec::zero(), v));
+    });
+}
+
+void tanh(long n, const Scalar *x, Scalar *y)
+{
+    elementwise(n, x, y, [](Vec v) {
+        const Vec one = Vec::broadcast(1);
+        return sub(one, div(Vec::broadcast(2), add(vexp(add(v, v)), one)));
+    });
+}
+
+void gelu(long n, const Scalar *x, Scalar *y)
+{
+    // -2u = x * (a + b x^2)
+    const Scalar c = 0.7978845608028654; // sqrt(2 / pi)
+    const Vec a = Vec::broadcast(-2 * c);
+    const Vec b = Vec::broadcast(-2 * c * 0.044715);
+    elementwise(n, x, y, [&](Vec v) {
+        const Vec one = Vec::broadcast(1);
+        return div(v, add(one, vexp(mul(v, fmadd(mul(v, v), b, a)))));
+    });
+}
+
+// The optimizer updates below read and write every parameter and its state once, in a single pass. Their
+// scalar tails round with std::fma exactly as the vector bodies do, so a parameter gets the same result
+// wherever it falls relative to the vector width.
+
+void momentum_update(long n, Scalar learning_rate, Scalar momentum, bool nesterov, Scalar gradient_scale,
+                     const Scalar *gradients, Scalar *velocity, Scalar *parameters)
+{
+    Vec rate = Vec::broadcast(-learning_rate);
+    Vec mu = Vec::broadcast(momentum);
+    Vec scale = Vec::broadcast(gradient_scale);
+
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+    {
+        Vec g = mul(scale, Vec::load(gradients + i));
+        Vec v = fmadd(mu, Vec::load(velocity + i), g);
+        v.store(velocity + i);
+        fmadd(rate, nesterov ? fmadd(mu, v, g) : v, Vec::load(parameters + i)).store(parameters + i);
+    }
+    for (; i < n; ++i)
+    {
+        Scalar g = gradient_scale * gradients[i];
+        velocity[i] = std::fma(momentum, velocity[i], g);
+        parameters[i] = std::fma(-learning_rate, nesterov ? std::fma(momentum, velocity[i], g) : velocity[i], parameters[i]);
+    }
+}
+
+void adam_update(long n, Scalar step_size, Scalar beta1, Scalar beta2, Scalar epsilon, Scalar gradient_scale,
+                 const Scalar *gradients, Scalar *first_moment, Scalar *second_moment, Scalar *parameters)
+{
+    // The gradient scale is folded into the weights of the new gradients
+    Scalar weight1 = (1 - beta1) * gradient_scale, weight2 = (1 - beta2) * gradient_scale * gradient_scale;
+
+    Vec rate = Vec::broadcast(-step_size);
+    Vec b1 = Vec::broadcast(beta1), w1 = Vec::broadcast(weight1);
+    Vec b2 = Vec::broadcast(beta2), w2 = Vec::broadcast(weight2);
+    Vec eps = Vec::broadcast(epsilon);
+
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+    {
+        Vec g = Vec::load(gradients + i);
+        Vec m = fmadd(b1, Vec::load(first_moment + i), mul(w1, g));
+        Vec v = fmadd(b2, Vec::load(second_moment + i), mul(mul(w2, g), g));
+        m.store(first_moment + i);
+        v.store(second_moment + i);
+        fmadd(rate, div(m, add(sqrt(v), eps)), Vec::load(parameters + i)).store(parameters + i);
+    }
+    for (; i < n; ++i)
+    {
+        first_moment[i] = std::fma(beta1, first_moment[i], weight1 * gradients[i]);
+        second_moment[i] = std::fma(beta2, second_moment[i], weight2 * gradients[i] * gradients[i]);
+        parameters[i] = std::fma(-step_size, first_moment[i] / (std::sqrt(second_moment[i]) + epsilon), parameters[i]);
+    }
+}
+
+void rmsprop_update(long n, Scalar learning_rate, Scalar decay, Scalar epsilon, Scalar gradient_scale,
+                    const Scalar *gradients, Scalar *mean_square, Scalar *parameters)
+{
+    // The gradient scale is folded into the weight of the new squares and the step size
+    Scalar weight = (1 - decay) * gradient_scale * gradient_scale, step_size = learning_rate * gradient_scale;
+
+    Vec rate = Vec::broadcast(-step_size);
+    Vec rho = Vec::broadcast(decay), w = Vec::broadcast(weight);
+    Vec eps = Vec::broadcast(epsilon);
+
+    long i = 0;
+    for (; i + Vec::width <= n; i += Vec::width)
+    {
+        Vec g = Vec::load(gradients + i);
+        Vec s = fmadd(rho, Vec::load(mean_square + i), mul(mul(w, g), g));
+        s.store(mean_square + i);
+        fmadd(rate, div(g, add(sqrt(s), eps)), Vec::load(parameters + i)).store(parameters + i);
+    }
+    for (; i < n; ++i)
+    {
+        mean_square[i] = std::fma(decay, mean_square[i], weight * gradients[i] * gradients[i]);
+        parameters[i] = std::fma(-step_size, gradients[i] / (std::sqrt(mean_square[i]) + epsilon), parameters[i]);
+    }
+}
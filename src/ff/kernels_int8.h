@@ -0,0 +1,49 @@
+/**
+ * @file kernels_int8.h
+ *
+ * @brief The instruction set independent part of the 8 bit integer kernels
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note Like kernels_impl.h this file has no include guard. kernels.cpp includes it once per instruction
+ *       set, inside a namespace that defines:
+ *          Int8Vec - a SIMD register of width bytes with zero, load and sum (of its 32 bit lanes)
+ *          dot_u8s8(sum, x, a) - sum plus the products of the unsigned bytes of x and the signed bytes
+ *                                of a, each 32 bit lane getting the four products of its bytes
+ */
+
+static void gemv_u8s8(int rows, int cols, const int8_t *A, const uint8_t *x, int32_t *y)
+{
+    constexpr int width = Int8Vec::width;
+
+    // Four rows at a time share each load of x
+    int r = 0;
+    for (; r + 4 <= rows; r += 4)
+    {
+        const int8_t *row = A + (size_t)r * cols;
+        Int8Vec sum0 = Int8Vec::zero(), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+        for (int i = 0; i < cols; i += width)
+        {
+            Int8Vec xv = Int8Vec::load(x + i);
+            sum0 = dot_u8s8(sum0, xv, Int8Vec::load(row + i));
+            sum1 = dot_u8s8(sum1, xv, Int8Vec::load(row + cols + i));
+            sum2 = dot_u8s8(sum2, xv, Int8Vec::load(row + 2 * (size_t)cols + i));
+            sum3 = dot_u8s8(sum3, xv, Int8Vec::load(row + 3 * (size_t)cols + i));
+        }
+        y[r] = sum0.sum();
+        y[r + 1] = sum1.sum();
+        y[r + 2] = sum2.sum();
+        y[r + 3] = sum3.sum();
+    }
+
+    for (; r < rows; ++r)
+    {
+        const int8_t *row = A + (size_t)r * cols;
+        Int8Vec sum = Int8Vec::zero();
+        for (int i = 0; i < cols; i += width)
+            sum = dot_u8s8(sum, Int8Vec::load(x + i), Int8Vec::load(row + i));
+        y[r] = sum.sum();
+    }
+}
@@ -0,0 +1,311 @@
+/**
+ * @file layer.cpp
+ *
+ * @brief Dense layer storage used internally by the forward feed neural network
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LAYER_CPP
+#define LAYER_CPP
+
+#include "../../include/ff/layer.h"
+#include "../../include/ff/kernels.h"
+#include "../../include/ff/sigmoid.h"
+#include "../../include/ff/activation_functions.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+/**
+ * @brief The activation function every neuron gets by default. It is shared between
+ *        all the layers, so it is never freed.
+ *
+ * @return ActivationBase*
+ */
+ActivationBase *default_activation_function()
+{
+    static Sigmoid sigmoid;
+    return &sigmoid;
+}
+
+/**
+ * @brief The shared instance of a built in function with a parameter. One is created the first time each
+ *        type and parameter is asked for, and kept for the life of the program, so loading or copying any
+ *        number of networks never creates another.
+ *
+ */
+static ActivationBase *interned_activation_function(ActivationFunctions type, double parameter)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<ActivationFunctions, uint64_t>, std::unique_ptr<ActivationBase>> functions;
+
+    // Keyed on the bits of the parameter, so -0 and 0 (which behave differently) are kept apart
+    uint64_t bits;
+    memcpy(&bits, &parameter, sizeof(bits));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<ActivationBase> &function = functions[{type, bits}];
+    if (!function)
+    {
+        switch (type)
+        {
+        case ActivationFunctions::Linear:
+            function.reset(new Linear(parameter));
+            break;
+        case ActivationFunctions::LeakyReLU:
+            function.reset(new LeakyReLU(parameter));
+            break;
+        case ActivationFunctions::ELU:
+            function.reset(new ELU(parameter));
+            break;
+        default:
+            break;
+        }
+    }
+
+    return function.get();
+}
+
+ActivationBase *shared_activation_function(ActivationFunctions type, double parameter)
+{
+    switch (type)
+    {
+    case ActivationFunctions::Sigmoid:
+        return default_activation_function();
+    case ActivationFunctions::Linear:
+    case ActivationFunctions::LeakyReLU:
+    case ActivationFunctions::ELU:
+        return interned_activation_function(type, parameter);
+    // The functions without a parameter are all the same, so there is just one of each
+    case ActivationFunctions::ReLU:
+    {
+        static ReLU relu;
+        return &relu;
+    }
+    case ActivationFunctions::GELU:
+    {
+        static GELU gelu;
+        return &gelu;
+    }
+    case ActivationFunctions::Tanh:
+    {
+        static Tanh tanh;
+        return &tanh;
+    }
+    case ActivationFunctions::Softmax:
+    {
+        static Softmax softmax;
+        return &softmax;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+ActivationBase *layer_activation_function(ActivationBase *activation_function)
+{
+    ActivationFunctions type = activation_function->type();
+    if (type == ActivationFunctions::Custom)
+        return activation_function;
+
+    return shared_activation_function(type, activation_function->parameter());
+}
+
+bool mixes_softmax(const std::vector<ActivationBase *> &activation_functions)
+{
+    size_t softmax_count = std::count_if(activation_functions.begin(), activation_functions.end(), [](ActivationBase *activation_function)
+                                         { return activation_function->type() == ActivationFunctions::Softmax; });
+    return softmax_count && softmax_count != activation_functions.size();
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::resize(int inputs, int outputs)
+{
+    this->inputs = inputs;
+    this->outputs = outputs;
+
+    input.assign(outputs, 0);
+    activation.assign(outputs, 0);
+    dLoss_dActivation.assign(outputs, 0);
+    dActivation_dInput.assign(outputs, 0);
+    dLoss_dInput.assign(outputs, 0);
+    activation_functions.assign(outputs, default_activation_function());
+    update_activation_type();
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::set_activation_function(int index, ActivationBase *activation_function)
+{
+    ActivationBase *previous = activation_functions[index];
+    activation_functions[index] = layer_activation_function(activation_function);
+    if (mixes_softmax(activation_functions))
+    {
+        activation_functions[index] = previous;
+        throw std::invalid_argument("The softmax applies to a whole layer, every neuron in the layer must use it");
+    }
+    update_activation_type();
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::update_activation_type()
+{
+    if (mixes_softmax(activation_functions))
+        throw std::invalid_argument("The softmax applies to a whole layer, every neuron in the layer must use it");
+
+    layer_activation = activation_functions.empty() ? default_activation_function() : activation_functions[0];
+    activation_type = layer_activation->type();
+
+    for (ActivationBase *activation_function : activation_functions)
+    {
+        // The built in functions are fully described by their type and parameter, so separate objects
+        // with the same type and parameter are as good as the same one
+        bool same = activation_function == layer_activation ||
+                    (activation_type != ActivationFunctions::Custom && activation_function->type() == activation_type &&
+                     activation_function->parameter() == layer_activation->parameter());
+        if (!same)
+        {
+            layer_activation = nullptr;
+            activation_type = ActivationFunctions::Custom;
+            return;
+        }
+    }
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::compute_input(Span<const Scalar> previous_activation, Span<Scalar> input) const
+{
+    kernels::gemv(outputs, inputs, weights, previous_activation.data(), bias, input.data());
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::activate(Span<const Scalar> input, Span<Scalar> activation) const
+{
+    // The neurons use different functions, fall back to one call per neuron
+    if (!layer_activation)
+    {
+        for (size_t o = 0; o < input.size(); ++o)
+            activation[o] = activation_functions[o % outputs]->compute(input[o]);
+        return;
+    }
+
+    switch (activation_type)
+    {
+    case ActivationFunctions::Sigmoid:
+        kernels::sigmoid(input.size(), input.data(), activation.data());
+        break;
+    case ActivationFunctions::Softmax:
+        // The spans may hold several examples, each gets its own softmax
+        for (size_t o = 0; o < input.size(); o += outputs)
+            layer_activation->apply(Span<const Scalar>(input.data() + o, outputs), Span<Scalar>(activation.data() + o, outputs));
+        break;
+    default:
+        layer_activation->apply(input, activation);
+        break;
+    }
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::activation_derivative(Span<const Scalar> input, Span<const Scalar> activation, Span<Scalar> derivative) const
+{
+    if (!layer_activation)
+    {
+        for (size_t o = 0; o < input.size(); ++o)
+            derivative[o] = activation_functions[o % outputs]->derivative(input[o]);
+        return;
+    }
+
+    switch (activation_type)
+    {
+    case ActivationFunctions::Sigmoid:
+        for (size_t o = 0; o < activation.size(); ++o)
+            derivative[o] = activation[o] * (1 - activation[o]);
+        break;
+    default:
+        layer_activation->derivative_from_output(input, activation, derivative);
+        break;
+    }
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::input_gradient(Span<const Scalar> input, Span<const Scalar> activation, Span<const Scalar> dLoss_dActivation,
+                                             Span<Scalar> dActivation_dInput, Span<Scalar> dLoss_dInput) const
+{
+    activation_derivative(input, activation, dActivation_dInput);
+
+    if (activation_type != ActivationFunctions::Softmax)
+    {
+        for (size_t o = 0; o < dLoss_dInput.size(); ++o)
+            dLoss_dInput[o] = dLoss_dActivation[o] * dActivation_dInput[o];
+        return;
+    }
+
+    // The Jacobian of the softmax is diag(s) - s s^T, so dLoss/dInput = s * (dLoss/dActivation - dot(dLoss/dActivation, s))
+    for (size_t e = 0; e < dLoss_dInput.size(); e += outputs)
+    {
+        Scalar dot = 0;
+        for (int o = 0; o < outputs; ++o)
+            dot += dLoss_dActivation[e + o] * activation[e + o];
+
+        for (int o = 0; o < outputs; ++o)
+            dLoss_dInput[e + o] = activation[e + o] * (dLoss_dActivation[e + o] - dot);
+    }
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::forward(Span<const Scalar> previous_activation)
+{
+    compute_input(previous_activation, input);
+    activate(input, activation);
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::compute_input_batch(const Matrix &previous_activation, Matrix &input) const
+{
+    int batch = previous_activation.rows;
+    input.resize(batch, outputs);
+
+    // input = previous_activation * weights^T + bias
+    kernels::gemm_nt(batch, outputs, inputs, previous_activation.data.data(), previous_activation.cols,
+                     weights, inputs, bias, input.data.data(), outputs);
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::activate_batch(const Matrix &input, Matrix &activation) const
+{
+    activation.resize(input.rows, outputs);
+
+    // The rows are stored back to back, so the whole batch is one long span
+    activate(input.data, activation.data);
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::activation_derivative_batch(const Matrix &input, const Matrix &activation, Matrix &derivative) const
+{
+    derivative.resize(input.rows, outputs);
+    activation_derivative(input.data, activation.data, derivative.data);
+}
+
+template <typename Scalar>
+void BasicDenseLayer<Scalar>::forward_batch(const Matrix &previous_activation, Matrix &input, Matrix &activation) const
+{
+    compute_input_batch(previous_activation, input);
+    activate_batch(input, activation);
+}
+
+template <typename Scalar>
+size_t BasicDenseLayer<Scalar>::parameter_count() const
+{
+    if (!inputs)
+        return 0; // The input layer has no weights or bias'
+    return (size_t)outputs * inputs + outputs;
+}
+
+#endif
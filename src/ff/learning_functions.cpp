@@ -0,0 +1,106 @@
+/**
+ * @file learning_functions.cpp
+ *
+ * @brief The learning rate schedules declared in learning_functions.h
+ * @version 0.1
+ * @date 2022-04-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LEARNING_FUNCTIONS_CPP
+#define LEARNING_FUNCTIONS_CPP
+
+#include "../../include/ff/learning_functions.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+StepDecayLearningFunction::StepDecayLearningFunction(double initial_rate, double factor, int epochs_per_drop)
+    : initial_rate(initial_rate), factor(factor), epochs_per_drop(epochs_per_drop)
+{
+    if (epochs_per_drop <= 0)
+        throw std::invalid_argument("StepDecayLearningFunction needs a positive number of epochs per drop");
+}
+
+
+double StepDecayLearningFunction::get_learning_rate(const LearningRateContext &context)
+{
+    return initial_rate * std::pow(factor, context.epoch / epochs_per_drop);
+}
+
+ExponentialDecayLearningFunction::ExponentialDecayLearningFunction(double initial_rate, double decay, long decay_steps)
+    : initial_rate(initial_rate), decay(decay), decay_steps(decay_steps)
+{
+    if (decay_steps <= 0)
+        throw std::invalid_argument("ExponentialDecayLearningFunction needs a positive number of decay steps");
+}
+
+double ExponentialDecayLearningFunction::get_learning_rate(const LearningRateContext &context)
+{
+    return initial_rate * std::pow(decay, (double)context.step / decay_steps);
+}
+
+CosineAnnealingLearningFunction::CosineAnnealingLearningFunction(double max_rate, double min_rate, long period, double period_multiplier)
+    : max_rate(max_rate), min_rate(min_rate), period(period), period_multiplier(period_multiplier)
+{
+    // An empty period, or periods that shrink, would never leave the loop that finds the current period
+    if (period <= 0)
+        throw std::invalid_argument("CosineAnnealingLearningFunction needs a positive period");
+    if (!(period_multiplier >= 1))
+        throw std::invalid_argument("CosineAnnealingLearningFunction needs a period multiplier of at least 1");
+}
+
+double CosineAnnealingLearningFunction::get_learning_rate(const LearningRateContext &context)
+{
+    // Find the step within the current period
+    double position = context.step;
+    double length = period;
+    if (period_multiplier == 1)
+    {
+        position = std::fmod(position, length);
+    }
+    else
+    {
+        while (position >= length)
+        {
+            position -= length;
+            length *= period_multiplier;
+        }
+    }
+
+    return min_rate + (max_rate - min_rate) * (1 + std::cos(M_PI * position / length)) / 2;
+}
+
+double WarmupLearningFunction::get_learning_rate(const LearningRateContext &context)
+{
+    double rate = after->get_learning_rate(context);
+    if (context.step < warmup_steps)
+        rate *= (double)(context.step + 1) / warmup_steps;
+    return rate;
+}
+
+double ReduceOnPlateauLearningFunction::get_learning_rate(const LearningRateContext &context)
+{
+    // Each epoch's loss is only looked at once, however many steps there are in the next epoch
+    if (context.epoch != last_epoch && !std::isnan(context.loss))
+    {
+        last_epoch = context.epoch;
+
+        if (best_loss == std::numeric_limits<double>::infinity() || context.loss < best_loss - threshold * std::abs(best_loss))
+        {
+            best_loss = context.loss;
+            epochs_without_improvement = 0;
+        }
+        else if (++epochs_without_improvement >= patience)
+        {
+            rate = std::max(rate * factor, min_rate);
+            epochs_without_improvement = 0;
+        }
+    }
+
+    return rate;
+}
+
+#endif
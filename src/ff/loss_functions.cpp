@@ -0,0 +1,188 @@
+/**
+ * @file loss_functions.cpp
+ *
+ * @brief The loss functions declared in loss_functions.h
+ * @version 0.1
+ * @date 2022-04-21
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LOSS_FUNCTIONS_CPP
+#define LOSS_FUNCTIONS_CPP
+
+#include "../../include/ff/loss_functions.h"
+#include "../../include/ff/activation_functions.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Outputs are kept this far from 0 and 1 when the cross-entropy takes their log or divides by them
+static const double PROBABILITY_EPSILON = 1e-12;
+
+/**
+ * @brief The double copies of the values the float overloads of a loss function work on, one set per thread
+ *        so that networks on different threads can share a loss function
+ *
+ */
+struct LossConversionBuffers
+{
+    std::vector<double> output, expected, result;
+
+    static LossConversionBuffers &get(Span<const float> output, Span<const float> expected)
+    {
+        static thread_local LossConversionBuffers buffers;
+        buffers.output.assign(output.begin(), output.end());
+        buffers.expected.assign(expected.begin(), expected.end());
+        buffers.result.resize(output.size());
+        return buffers;
+    }
+};
+
+double LossFunction::loss(Span<const float> output, Span<const float> expected) const
+{
+    LossConversionBuffers &buffers = LossConversionBuffers::get(output, expected);
+    return loss(buffers.output, buffers.expected);
+}
+
+void LossFunction::gradient(Span<const float> output, Span<const float> expected, Span<float> dLoss_dOutput) const
+{
+    LossConversionBuffers &buffers = LossConversionBuffers::get(output, expected);
+    gradient(buffers.output, buffers.expected, buffers.result);
+    std::copy(buffers.result.begin(), buffers.result.end(), dLoss_dOutput.begin());
+}
+
+bool LossFunction::fused_gradient(ActivationFunctions output_activation, Span<const float> output, Span<const float> expected,
+                                  Span<float> dLoss_dInput) const
+{
+    LossConversionBuffers &buffers = LossConversionBuffers::get(output, expected);
+    if (!fused_gradient(output_activation, buffers.output, buffers.expected, buffers.result))
+        return false;
+
+    std::copy(buffers.result.begin(), buffers.result.end(), dLoss_dInput.begin());
+    return true;
+}
+
+double MeanSquaredError::loss(Span<const double> output, Span<const double> expected) const
+{
+    double sum = 0;
+    for (size_t i = 0; i < output.size(); ++i)
+        sum += (output[i] - expected[i]) * (output[i] - expected[i]);
+
+    return sum;
+}
+
+void MeanSquaredError::gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const
+{
+    for (size_t i = 0; i < output.size(); ++i)
+        dLoss_dOutput[i] = 2 * (output[i] - expected[i]);
+}
+
+double BinaryCrossEntropy::loss(Span<const double> output, Span<const double> expected) const
+{
+    double sum = 0;
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        double probability = std::min(std::max(output[i], PROBABILITY_EPSILON), 1 - PROBABILITY_EPSILON);
+        sum -= expected[i] * std::log(probability) + (1 - expected[i]) * std::log(1 - probability);
+    }
+
+    return sum;
+}
+
+void BinaryCrossEntropy::gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const
+{
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        double probability = std::min(std::max(output[i], PROBABILITY_EPSILON), 1 - PROBABILITY_EPSILON);
+        dLoss_dOutput[i] = (probability - expected[i]) / (probability * (1 - probability));
+    }
+}
+
+bool BinaryCrossEntropy::fused_gradient(ActivationFunctions output_activation, Span<const double> output, Span<const double> expected,
+                                        Span<double> dLoss_dInput) const
+{
+    // The sigmoid's derivative output * (1 - output) cancels the denominator of the gradient
+    if (output_activation != ActivationFunctions::Sigmoid)
+        return false;
+
+    for (size_t i = 0; i < output.size(); ++i)
+        dLoss_dInput[i] = output[i] - expected[i];
+
+    return true;
+}
+
+double CategoricalCrossEntropy::loss(Span<const double> output, Span<const double> expected) const
+{
+    double sum = 0;
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        if (expected[i])
+            sum -= expected[i] * std::log(std::max(output[i], PROBABILITY_EPSILON));
+    }
+
+    return sum;
+}
+
+void CategoricalCrossEntropy::gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const
+{
+    for (size_t i = 0; i < output.size(); ++i)
+        dLoss_dOutput[i] = -expected[i] / std::max(output[i], PROBABILITY_EPSILON);
+}
+
+bool CategoricalCrossEntropy::fused_gradient(ActivationFunctions output_activation, Span<const double> output, Span<const double> expected,
+                                             Span<double> dLoss_dInput) const
+{
+    // The Jacobian of the softmax cancels the division by the outputs
+    if (output_activation != ActivationFunctions::Softmax)
+        return false;
+
+    double expected_sum = 0;
+    for (size_t i = 0; i < expected.size(); ++i)
+        expected_sum += expected[i];
+
+    for (size_t i = 0; i < output.size(); ++i)
+        dLoss_dInput[i] = output[i] * expected_sum - expected[i];
+
+    return true;
+}
+
+double SoftmaxCrossEntropy::loss(Span<const double> output, Span<const double> expected) const
+{
+    double largest = *std::max_element(output.begin(), output.end());
+
+    double exp_sum = 0, expected_sum = 0, expected_dot_output = 0;
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        exp_sum += std::exp(output[i] - largest);
+        expected_sum += expected[i];
+        expected_dot_output += expected[i] * output[i];
+    }
+
+    return expected_sum * (largest + std::log(exp_sum)) - expected_dot_output;
+}
+
+void SoftmaxCrossEntropy::gradient(Span<const double> output, Span<const double> expected, Span<double> dLoss_dOutput) const
+{
+    double expected_sum = 0;
+    for (size_t i = 0; i < expected.size(); ++i)
+        expected_sum += expected[i];
+
+    softmax(output, dLoss_dOutput);
+    for (size_t i = 0; i < output.size(); ++i)
+        dLoss_dOutput[i] = dLoss_dOutput[i] * expected_sum - expected[i];
+}
+
+void SoftmaxCrossEntropy::softmax(Span<const double> logits, Span<double> probabilities)
+{
+    Softmax().apply(logits, probabilities);
+}
+
+const LossFunction *default_loss_function()
+{
+    static MeanSquaredError mean_squared_error;
+    return &mean_squared_error;
+}
+
+#endif
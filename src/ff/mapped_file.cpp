@@ -0,0 +1,77 @@
+/**
+ * @file mapped_file.cpp
+ *
+ * @brief A file mapped into memory
+ * @version 0.1
+ * @date 2022-04-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MAPPED_FILE_CPP
+#define MAPPED_FILE_CPP
+
+#include "../../include/ff/mapped_file.h"
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &filename)
+{
+#ifdef MAPPED_FILE_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0)
+    {
+        length = info.st_size;
+        opened = true;
+
+        if (length)
+        {
+            void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED)
+            {
+                contents = static_cast<char *>(address);
+                mapped = true;
+            }
+        }
+    }
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+
+    if (!opened || mapped || !length)
+        return;
+#endif
+
+    // No mmap, or the file could not be mapped (a pipe, for example), so read it instead
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return;
+
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    contents = buffer.data();
+    length = buffer.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef MAPPED_FILE_MMAP
+    if (mapped)
+        munmap(contents, length);
+#endif
+}
+
+#endif
@@ -1,215 +1,161 @@
 /**
  * @file neuron.cpp
- * 
- * @brief 
+ *
+ * @brief
  * @version 0.1
  * @date 2021-12-27
- * 
+ *
  * @copyright Copyright (c) 2021
- * 
+ *
  */
 
 #ifndef NEURON_CPP
 #define NEURON_CPP
 
 #include "../../include/ff/neuron.h"
-#include "../../include/ff/sigmoid.h"
 
-Neuron::Neuron() : bias(0), weights(), activation(0)
-{
-
-    this->activationBase = new Sigmoid(); // TODO : Add neuron deconstructer
-}
-
-Neuron::Neuron(double bias, std::vector<double> weights) : bias(bias), weights(weights), activation(0), 
-                                                            dLoss_dWeight(weights.size(), 0), average_dLoss_dWeight(weights.size(), 0)
-{ 
-    this->activationBase = new Sigmoid(); // TODO: Add neurom deconstructor
-}
+template <typename Scalar>
+BasicNeuron<Scalar>::BasicNeuron() : layer(nullptr), previous(nullptr), index(0) {}
 
-Neuron::Neuron(double bias, std::vector<double> weights, ActivationBase *activationFunction) : bias(bias), weights(weights),
-                                                                                               activation(0), activationBase(activationFunction), 
-                                                                                               dLoss_dWeight(weights.size(), 0),
-                                                                                               average_dLoss_dWeight(weights.size()) {}
-
-Neuron::Neuron(const Neuron &n1)
-{
-    bias = n1.bias;
-    weights = n1.weights;
-    activation = n1.activation;
-
-    // TODO: Double check this. I think that the activation base is dynamically allocated, thus we need to deep copy this
-    activationBase = n1.activationBase;
-}
+template <typename Scalar>
+BasicNeuron<Scalar>::BasicNeuron(BasicDenseLayer<Scalar> *layer, const BasicDenseLayer<Scalar> *previous, int index)
+    : layer(layer), previous(previous), index(index) {}
 
-void Neuron::setInput(double input)
+template <typename Scalar>
+void BasicNeuron<Scalar>::setInput(Scalar input)
 {
-    activation = activationBase->compute(input);
-    this->input = input;
+    layer->activation[index] = layer->activation_functions[index]->compute(input);
+    layer->input[index] = input;
 }
 
-void Neuron::computeInput(std::vector<double> previousLayer, int previousLayerSize)
+template <typename Scalar>
+void BasicNeuron<Scalar>::computeInput(const std::vector<Scalar> &previousLayer, int previousLayerSize)
 {
-    double sum = 0;
+    const Scalar *row = layer->weights + (size_t)index * layer->inputs;
+    Scalar sum = 0;
 
     for (int i = 0; i < previousLayerSize; ++i)
     {
-        sum += previousLayer[i] * weights[i];
+        sum += previousLayer[i] * row[i];
     }
-    sum += bias;
-    input = sum;
+    sum += layer->bias[index];
+    layer->input[index] = sum;
 
-    activation = (*activationBase).compute(sum);
+    layer->activation[index] = layer->activation_functions[index]->compute(sum);
 }
 
-double Neuron::getOutput()
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::getOutput()
 {
-    return activation;
+    return layer->activation[index];
 }
 
-void Neuron::setOutput(double output)
+template <typename Scalar>
+void BasicNeuron<Scalar>::setOutput(Scalar output)
 {
-    activation = output;
+    layer->activation[index] = output;
 }
 
-void Neuron::setBias(double bias)
+template <typename Scalar>
+void BasicNeuron<Scalar>::setBias(Scalar bias)
 {
-    this->bias = bias;
+    layer->bias[index] = bias;
 }
 
-// TODO: Make this take the input by reference rather than by copy
-void Neuron::setWeights(std::vector<double> weights)
+template <typename Scalar>
+void BasicNeuron<Scalar>::setWeights(const std::vector<Scalar> &weights)
 {
-    this->weights = weights;
-    this->average_dLoss_dWeight.resize(weights.size()); 
-    this->dLoss_dWeight.resize(weights.size()); 
-
+    Scalar *row = layer->weights + (size_t)index * layer->inputs;
+    for (int i = 0; i < layer->inputs && i < weights.size(); ++i)
+        row[i] = weights[i];
 }
 
-void Neuron::setActivation(double activation)
+template <typename Scalar>
+void BasicNeuron<Scalar>::setActivation(Scalar activation)
 {
-    this->activation = activation;
+    layer->activation[index] = activation;
 }
 
-void Neuron::setActivationBase(ActivationBase *activationFunc)
+template <typename Scalar>
+void BasicNeuron<Scalar>::setActivationBase(ActivationBase *activationFunc)
 {
-    activationBase = activationFunc;
+    layer->set_activation_function(index, activationFunc);
 }
 
-double Neuron::getBias()
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::getBias()
 {
-    return bias;
+    // The input layer does not have any bias'
+    if (!layer->bias)
+        return 0;
+    return layer->bias[index];
 }
 
-std::vector<double> Neuron::getWeights()
+template <typename Scalar>
+std::vector<Scalar> BasicNeuron<Scalar>::getWeights()
 {
-    return weights;
+    const Scalar *row = layer->weights + (size_t)index * layer->inputs;
+    return std::vector<Scalar>(row, row + layer->inputs);
 }
 
-double Neuron::getActivation()
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::getActivation()
 {
-    return activation;
+    return layer->activation[index];
 }
 
-ActivationBase *Neuron::getActivationFunction()
+template <typename Scalar>
+ActivationBase *BasicNeuron<Scalar>::getActivationFunction()
 {
-    return activationBase;
+    return layer->activation_functions[index];
 }
 
-void Neuron::set_dActivation_dInput(double value)
+template <typename Scalar>
+void BasicNeuron<Scalar>::set_dActivation_dInput(Scalar value)
 {
-    dActivaton_dInput = value;
+    layer->dActivation_dInput[index] = value;
 }
 
-double Neuron::get_dActivation_dInput()
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::get_dActivation_dInput()
 {
-    return dActivaton_dInput;
+    return layer->dActivation_dInput[index];
 }
 
-void Neuron::set_dLoss_dActivation(double value)
+template <typename Scalar>
+void BasicNeuron<Scalar>::set_dLoss_dActivation(Scalar value)
 {
-    dLoss_dActivation = value;
+    layer->dLoss_dActivation[index] = value;
 }
 
-double Neuron::get_dLoss_dActivation()
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::get_dLoss_dActivation()
 {
-    return dLoss_dActivation;
+    return layer->dLoss_dActivation[index];
 }
 
-double Neuron::getInput()
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::getInput()
 {
-    return input;
+    return layer->input[index];
 }
 
-void Neuron::set_dLoss_dBias(double val)
+template <typename Scalar>
+Scalar BasicNeuron<Scalar>::get_dLoss_dBias()
 {
-    dLoss_dBias = val;
+    return layer->dLoss_dInput[index];
 }
 
-double Neuron::get_dLoss_dBias()
+template <typename Scalar>
+std::vector<Scalar> BasicNeuron<Scalar>::get_dLoss_dWeight()
 {
-    return dLoss_dBias;
-}
+    std::vector<Scalar> dLoss_dWeight(layer->inputs, 0);
+    Scalar dLoss_dInput = get_dLoss_dBias();
 
-void Neuron::set_dLoss_dWeight(std::vector<double> val)
-{
-    dLoss_dWeight = val;
-}
+    for (int j = 0; j < layer->inputs; ++j)
+        dLoss_dWeight[j] = dLoss_dInput * previous->activation[j];
 
-std::vector<double> Neuron::get_dLoss_dWeight()
-{
     return dLoss_dWeight;
 }
 
-void Neuron::add_dLoss_dBias_data_point(double data_points)
-{
-    average_dLoss_dBias *= num_examples_dBias;
-    ++num_examples_dBias;
-    average_dLoss_dBias += data_points;
-    average_dLoss_dBias /= num_examples_dBias;
-}
-
-void Neuron::add_dLoss_dWeight_data_point(std::vector<double> &data_points)
-{
-    for (int i = 0; i < average_dLoss_dWeight.size(); ++i)
-    {
-        average_dLoss_dWeight[i] *= num_examples_dWeight;
-        average_dLoss_dWeight[i] += data_points[i];
-    }
-    ++num_examples_dWeight;
-    for (int i = 0; i < average_dLoss_dWeight.size(); ++i)
-    {
-        average_dLoss_dWeight[i] /= num_examples_dWeight;
-    }
-}
-
-void Neuron::reset_partial_averages()
-{
-    for (int i = 0; i < average_dLoss_dWeight.size(); ++i)
-        average_dLoss_dWeight[i] = 0;
-    average_dLoss_dBias = 0;
-    num_examples_dWeight = 0;
-    num_examples_dBias = 0;
-}
-
-void Neuron::update_weights_bias(double learning_weight, bool reset){
-    bias = getBias() - average_dLoss_dBias * learning_weight; 
-
-    if(reset){
-        average_dLoss_dBias = 0;
-        num_examples_dBias = 0;
-    }
-
-    for(int i = 0; i < weights.size(); ++i){
-        weights[i] = getWeights()[i] - average_dLoss_dWeight[i] * learning_weight;
-        
-        if(reset)
-            average_dLoss_dWeight[i] = 0;
-    }
-
-    if(reset)
-        num_examples_dWeight = 0;
-    
-}
-
-#endif
\ No newline at end of file
+#endif
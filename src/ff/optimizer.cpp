@@ -0,0 +1,91 @@
+/**
+ * @file optimizer.cpp
+ *
+ * @brief The optimizers declared in learning_functions.h
+ * @version 0.1
+ * @date 2022-04-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef OPTIMIZER_CPP
+#define OPTIMIZER_CPP
+
+#include "../../include/ff/learning_functions.h"
+#include "../../include/ff/kernels.h"
+#include <cmath>
+
+/**
+ * @brief Size an optimizer's state for the parameters, starting from zero the first time or if
+ *        the network changed shape
+ *
+ * @return true if the state was (re)started
+ */
+template <typename Scalar>
+static bool size_state(std::vector<Scalar> &state, size_t num_parameters)
+{
+    if (state.size() == num_parameters)
+        return false;
+
+    state.assign(num_parameters, 0);
+    return true;
+}
+
+template <typename Scalar>
+void BasicSGD<Scalar>::step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale)
+{
+    kernels::axpy(parameters.size(), -learning_rate * gradient_scale, gradients.data(), parameters.data());
+}
+
+template <typename Scalar>
+void BasicMomentum<Scalar>::step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale)
+{
+    size_state(velocity, parameters.size());
+    kernels::momentum_update(parameters.size(), learning_rate, momentum, nesterov, gradient_scale, gradients.data(), velocity.data(), parameters.data());
+}
+
+template <typename Scalar>
+void BasicMomentum<Scalar>::reset()
+{
+    velocity.clear();
+}
+
+template <typename Scalar>
+void BasicAdam<Scalar>::step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale)
+{
+    if (size_state(first_moment, parameters.size()) | size_state(second_moment, parameters.size()))
+        steps = 0;
+    ++steps;
+
+    // The bias corrections of both moments are the same for every parameter, so they are folded into
+    // the step size and epsilon instead of being applied to each moment
+    double correction1 = 1 - std::pow(beta1, steps);
+    double correction2 = std::sqrt(1 - std::pow(beta2, steps));
+
+    kernels::adam_update(parameters.size(), learning_rate * correction2 / correction1, beta1, beta2, epsilon * correction2, gradient_scale,
+                         gradients.data(), first_moment.data(), second_moment.data(), parameters.data());
+}
+
+template <typename Scalar>
+void BasicAdam<Scalar>::reset()
+{
+    first_moment.clear();
+    second_moment.clear();
+    steps = 0;
+}
+
+template <typename Scalar>
+void BasicRMSProp<Scalar>::step(Span<Scalar> parameters, Span<const Scalar> gradients, double learning_rate, double gradient_scale)
+{
+    size_state(mean_square, parameters.size());
+    kernels::rmsprop_update(parameters.size(), learning_rate, decay, epsilon, gradient_scale, gradients.data(), mean_square.data(), parameters.data());
+}
+
+template <typename Scalar>
+void BasicRMSProp<Scalar>::reset()
+{
+    mean_square.clear();
+}
+
+#endif
@@ -16,62 +16,180 @@
 #include "../../include/ff/ff.h"
 #include "../../include/ff/neuron.h"
 #include "../../include/ff/activation.h"
-#include "../../include/utils.h"
+#include "../../include/ff/model_file_error.h"
+#include <algorithm>
+#include <charconv>
 #include <string> 
+#include <string_view>
 #include <vector> 
 #include <iostream> 
 #include <fstream>
 
 using namespace std; 
 
-void NeuralNetworkFF::to_external_repr(std::ostream & os){
+/**
+ * @brief Formats the text representation into a buffer, which is written to the stream at once,
+ *        or whenever it grows past the chunk size. Numbers are written with std::to_chars, which
+ *        gives the shortest text that reads back as exactly the same double (or float).
+ * 
+ */
+class TextModelWriter{
+
+public:
+
+    /**
+     * @param os - the stream to write to
+     * @param chunk_size - write to the stream every time this many bytes are formatted, or 0 to
+     *                     format everything before writing it
+     * @param size_hint - roughly how many bytes will be written
+     */
+    TextModelWriter(std::ostream & os, size_t chunk_size, size_t size_hint) : os(os), chunk_size(chunk_size){
+        buffer.resize(chunk_size ? chunk_size + max_number_length : size_hint);
+    }
+
+    ~TextModelWriter(){
+        flush();
+    }
+
+    void text(std::string_view str){
+        char * out = reserve(str.size());
+        std::copy(str.begin(), str.end(), out);
+        size += str.size();
+    }
+
+    template <typename T>
+    void number(T value){
+        char * out = reserve(max_number_length);
+        size = std::to_chars(out, out + max_number_length, value).ptr - buffer.data();
+    }
+
+    /**
+     * @brief Write everything formatted so far to the stream
+     * 
+     */
+    void flush(){
+        os.write(buffer.data(), size);
+        size = 0;
+    }
+
+private:
+
+    static const size_t max_number_length = 32; // The longest double is 24 characters
+
+    /**
+     * @brief Make room for count more bytes, writing out a full chunk first
+     * 
+     * @return where to put them
+     */
+    char * reserve(size_t count){
+        if(chunk_size && size >= chunk_size)
+            flush();
+
+        if(size + count > buffer.size())
+            buffer.resize(std::max(buffer.size() * 2, size + count));
+
+        return buffer.data() + size;
+    }
+
+    std::ostream & os;
+    size_t chunk_size;
+    std::vector<char> buffer;
+    size_t size = 0;
+
+};
+
+/**
+ * @brief Throw if a layer after the input layer has a custom activation function, which the text
+ *        format can not name
+ * 
+ */
+template <typename Layer>
+static void check_text_activation_functions(const std::vector<Layer> & layers){
+    for(int layer = 1; layer < layers.size(); ++layer)
+        for(ActivationBase * activation_function : layers[layer].activation_functions)
+            if(activation_function->type() == ActivationFunctions::Custom)
+                throw ModelFileError("Custom activation functions can not be saved in a text model file");
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::to_external_repr(std::ostream & os, size_t chunk_size) const{
 
-    for(int layer = 0; layer < neurons.size(); ++layer){
+    // Checked before anything is written, so nothing is left half written
+    check_text_activation_functions(layers);
+
+    // Every parameter takes at most 25 bytes with its separator
+    TextModelWriter out(os, chunk_size, parameters.size() * 25 + layers.size() * 64);
+
+    for(int layer = 0; layer < layers.size(); ++layer){
+
+        const DenseLayer & current = layers[layer];
 
         // new layer
-        os << "def layer\n"; 
-        os << "neurons " << neurons[layer].size() << "\n\n";
+        out.text("def layer\n"); 
+        out.text("neurons "); 
+        out.number(current.outputs);
+        out.text("\n\n");
 
         if(!layer){
-            os << "end layer\n\n";
+            out.text("end layer\n\n");
             continue;
         }
 
-        for(int neuron_index = 0; neuron_index < neurons[layer].size(); ++neuron_index){
+        for(int neuron_index = 0; neuron_index < current.outputs; ++neuron_index){
             
-            os << "neuron " << neuron_index << " bias " << neurons[layer][neuron_index].getBias() << "\n";
-            os << "neuron " << neuron_index << " weights "; 
-
-            for(auto weight : neurons[layer][neuron_index].weights){
-                os << weight << " "; 
+            out.text("neuron "); 
+            out.number(neuron_index);
+            out.text(" bias ");
+            out.number(current.bias[neuron_index]);
+            out.text("\nneuron ");
+            out.number(neuron_index);
+            out.text(" weights "); 
+
+            const Scalar * row = current.weights + (size_t)neuron_index * current.inputs;
+            for(int i = 0; i < current.inputs; ++i){
+                out.number(row[i]);
+                out.text(" "); 
             }
-            os << "\n"; 
-
-            if(neurons[layer][neuron_index].getActivationFunction()->to_external_repr() != "Sigmoid"){
-                os << "neuron " << neuron_index << " activation " 
-                << neurons[layer][neuron_index].getActivationFunction()->to_external_repr()
-                << "\n";
-               
+            out.text("\n"); 
+
+            ActivationBase * activation_function = current.activation_functions[neuron_index];
+            ActivationFunctions type = activation_function->type();
+            if(type != ActivationFunctions::Sigmoid){
+                out.text("neuron ");
+                out.number(neuron_index);
+                out.text(" activation ");
+                out.text(activation_function_name(type));
+                if(activation_function_has_parameter(type)){
+                    out.text(" ");
+                    out.number(activation_function->parameter());
+                }
+                out.text("\n");
             }
 
         }
-            os << "\nend layer\n\n";
+        out.text("\nend layer\n\n");
     }
 
 }
 
-void NeuralNetworkFF::save_to_file(std::string filename){
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::save_to_file(std::string filename, size_t chunk_size) const{
+    check_text_activation_functions(layers);
+
     ofstream outfile; 
-    outfile.open(filename); 
+    outfile.open(filename, ios::binary); 
 
     if(!outfile){
-        cerr << "Error: Could not open " << filename << endl; 
-        exit(1); 
+        throw ModelFileError("Could not open " + filename); 
     }
 
     // If no error, output network to file
-    to_external_repr(outfile);
+    to_external_repr(outfile, chunk_size);
+
+    if(!outfile.flush()){
+        throw ModelFileError("Could not write " + filename); 
+    }
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file parallel_trainer.cpp
+ *
+ * @brief Data-parallel training of a forward feed neural network on several threads
+ * @version 0.1
+ * @date 2022-04-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef PARALLEL_TRAINER_CPP
+#define PARALLEL_TRAINER_CPP
+
+#include "../../include/ff/parallel_trainer.h"
+#include "../../include/ff/ff.h"
+#include "../../include/ff/kernels.h"
+#include <algorithm>
+
+template <typename Scalar>
+BasicParallelTrainer<Scalar>::BasicParallelTrainer(int num_threads) : pool(std::max(num_threads, 1)), workers(pool.size()) {}
+
+template <typename Scalar>
+void BasicParallelTrainer<Scalar>::trainBatch(BasicNeuralNetworkFF<Scalar> &net, const Matrix &inputs, const Matrix &expected_outputs)
+{
+    int batch = inputs.rows;
+    int num_workers = workers.size();
+    size_t num_parameters = net.parameters.size();
+
+    // Each worker sums the gradients over its shard of the batch
+    pool.run(num_workers, [&](int w) {
+        Worker &worker = workers[w];
+        worker.gradients.assign(num_parameters, 0);
+
+        int begin = (long)batch * w / num_workers;
+        int end = (long)batch * (w + 1) / num_workers;
+        if (begin == end)
+            return;
+
+        worker.inputs.resize(end - begin, inputs.cols);
+        worker.expected_outputs.resize(end - begin, expected_outputs.cols);
+        std::copy(inputs.row(begin), inputs.row(end), worker.inputs.row(0));
+        std::copy(expected_outputs.row(begin), expected_outputs.row(end), worker.expected_outputs.row(0));
+
+        net.forward_batch(worker.inputs, worker.workspace);
+        net.back_propagation_batch(worker.inputs, worker.expected_outputs, worker.workspace, worker.gradients.data());
+    });
+
+    // Add the sums together and into the network's sums. The parameters are split into one chunk per thread,
+    // and every chunk is reduced over the workers in the same tree, so the order of the additions
+    // does not depend on how the chunks are split.
+    pool.run(num_workers, [&](int chunk) {
+        size_t begin = num_parameters * chunk / num_workers;
+        size_t end = num_parameters * (chunk + 1) / num_workers;
+
+        for (int stride = 1; stride < num_workers; stride *= 2)
+        {
+            for (int w = 0; w + stride < num_workers; w += 2 * stride)
+            {
+                kernels::axpy(end - begin, 1, workers[w + stride].gradients.data() + begin, workers[w].gradients.data() + begin);
+            }
+        }
+
+        kernels::axpy(end - begin, 1, workers[0].gradients.data() + begin, net.gradient_sums.data() + begin);
+    });
+
+    net.num_examples += batch;
+}
+
+#endif
@@ -0,0 +1,402 @@
+/**
+ * @file quantized.cpp
+ *
+ * @brief Quantizing trained networks to 8 bit weights, inference with them, and their file format
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef QUANTIZED_CPP
+#define QUANTIZED_CPP
+
+#include "../../include/ff/quantized.h"
+#include "../../include/ff/quantized_format.h"
+#include "../../include/ff/ff.h"
+#include "../../include/ff/kernels.h"
+#include "../../include/ff/mapped_file.h"
+#include "../../include/ff/model_file_error.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// The rows of the weights are padded to a multiple of this for kernels::gemv_u8s8
+static const int QUANTIZED_ROW_ALIGNMENT = 64;
+
+void QuantizedLayer::prepare()
+{
+    row_sums.assign(outputs, 0);
+    row_scales.resize(outputs);
+    for (int o = 0; o < outputs; ++o)
+    {
+        const int8_t *row = weights.data() + (size_t)o * stride;
+        for (int i = 0; i < inputs; ++i)
+            row_sums[o] += row[i];
+        row_scales[o] = input_scale * weight_scales[o];
+    }
+
+    // The built in functions are fully described by their type and parameter, as in DenseLayer
+    layer_activation = activation_functions[0];
+    for (ActivationBase *activation_function : activation_functions)
+    {
+        bool same = activation_function == layer_activation ||
+                    (activation_function->type() != ActivationFunctions::Custom &&
+                     activation_function->type() == layer_activation->type() &&
+                     activation_function->parameter() == layer_activation->parameter());
+        if (!same)
+        {
+            layer_activation = nullptr;
+            break;
+        }
+    }
+}
+
+template <typename T>
+void QuantizedLayer::quantize_input(const T *values, uint8_t *quantized) const
+{
+    float inverse_scale = 1 / input_scale;
+    float zero_point = input_zero_point;
+    for (int i = 0; i < inputs; ++i)
+    {
+        // Clamped first, so that rounding is adding a half and truncating, which the compiler can
+        // vectorize. Written so that NaN becomes 0.
+        float q = (float)values[i] * inverse_scale + zero_point;
+        q = q > 0 ? q : 0;
+        q = q < 127 ? q : 127;
+        quantized[i] = (uint8_t)(q + 0.5f);
+    }
+    std::fill(quantized + inputs, quantized + stride, 0);
+}
+
+void QuantizedLayer::forward(const uint8_t *quantized, int32_t *sums, float *activation) const
+{
+    kernels::gemv_u8s8(outputs, stride, weights.data(), quantized, sums);
+
+    for (int o = 0; o < outputs; ++o)
+        activation[o] = row_scales[o] * (float)(sums[o] - input_zero_point * row_sums[o]) + bias[o];
+
+    if (layer_activation)
+    {
+        layer_activation->apply(Span<const float>(activation, outputs), Span<float>(activation, outputs));
+    }
+    else
+    {
+        for (int o = 0; o < outputs; ++o)
+            activation[o] = activation_functions[o]->compute(activation[o]);
+    }
+}
+
+template <typename Scalar, typename ExamplesIterator>
+QuantizedNetworkFF::QuantizedNetworkFF(const BasicNeuralNetworkFF<Scalar> &network, ExamplesIterator calibration_begin,
+                                       ExamplesIterator calibration_end)
+{
+    const auto &network_layers = network.layers;
+    size_t num_layers = network_layers.size();
+
+    // The lowest and highest value going into each layer. Both start at 0, so that 0 is always in the
+    // range and quantizes exactly.
+    std::vector<float> lowest(num_layers - 1, 0), highest(num_layers - 1, 0);
+
+    std::vector<Scalar> previous(network.maxLayerSize), current(network.maxLayerSize);
+    long num_examples = 0;
+    for (; calibration_begin != calibration_end; ++calibration_begin, ++num_examples)
+    {
+        const auto &example = *calibration_begin;
+        std::copy(example.begin(), example.begin() + network_layers[0].outputs, previous.begin());
+
+        for (size_t l = 1; l < num_layers; ++l)
+        {
+            const auto &layer = network_layers[l];
+            for (int i = 0; i < layer.inputs; ++i)
+            {
+                lowest[l - 1] = std::min<float>(lowest[l - 1], previous[i]);
+                highest[l - 1] = std::max<float>(highest[l - 1], previous[i]);
+            }
+
+            Span<Scalar> result(current.data(), layer.outputs);
+            layer.compute_input(Span<const Scalar>(previous.data(), layer.inputs), result);
+            layer.activate(result, result);
+            std::swap(previous, current);
+        }
+    }
+
+    if (num_examples == 0)
+        throw std::invalid_argument("Quantizing a network needs at least one example to calibrate on");
+
+    layers.resize(num_layers - 1);
+    for (size_t l = 1; l < num_layers; ++l)
+    {
+        const auto &source = network_layers[l];
+        QuantizedLayer &layer = layers[l - 1];
+
+        layer.inputs = source.inputs;
+        layer.outputs = source.outputs;
+        layer.stride = (source.inputs + QUANTIZED_ROW_ALIGNMENT - 1) / QUANTIZED_ROW_ALIGNMENT * QUANTIZED_ROW_ALIGNMENT;
+
+        // [lowest, highest] is spread over [0, 127]
+        float range = highest[l - 1] - lowest[l - 1];
+        layer.input_scale = range > 0 ? range / 127 : 1;
+        layer.input_zero_point = (int32_t)std::nearbyint(-lowest[l - 1] / layer.input_scale);
+
+        // Each row is scaled so that its largest weight is +-127
+        layer.weights.assign((size_t)layer.outputs * layer.stride, 0);
+        layer.weight_scales.resize(layer.outputs);
+        for (int o = 0; o < layer.outputs; ++o)
+        {
+            const Scalar *row = source.weights + (size_t)o * source.inputs;
+            double largest = 0;
+            for (int i = 0; i < source.inputs; ++i)
+                largest = std::max<double>(largest, std::abs(row[i]));
+
+            double scale = largest > 0 ? largest / 127 : 1;
+            layer.weight_scales[o] = scale;
+            for (int i = 0; i < source.inputs; ++i)
+                layer.weights[(size_t)o * layer.stride + i] = (int8_t)std::nearbyint(row[i] / scale);
+        }
+
+        layer.bias.assign(source.bias, source.bias + source.outputs);
+        layer.activation_functions = source.activation_functions;
+    }
+
+    prepare_layers();
+}
+
+void QuantizedNetworkFF::prepare_layers()
+{
+    max_stride = 0;
+    max_outputs = 0;
+    for (QuantizedLayer &layer : layers)
+    {
+        layer.prepare();
+        max_stride = std::max(max_stride, layer.stride);
+        max_outputs = std::max(max_outputs, layer.outputs);
+    }
+}
+
+template <typename T>
+void QuantizedNetworkFF::forwardPass(const std::vector<T> &input, std::vector<float> &output, QuantizedWorkspace &workspace) const
+{
+    if (workspace.quantized.size() < (size_t)max_stride)
+        workspace.quantized.resize(max_stride);
+    if (workspace.sums.size() < (size_t)max_outputs)
+        workspace.sums.resize(max_outputs);
+    if (workspace.activation.size() < (size_t)max_outputs)
+        workspace.activation.resize(max_outputs);
+
+    // Each layer quantizes the activations of the one before, so the float activations are only ever
+    // needed for one layer at a time
+    layers[0].quantize_input(input.data(), workspace.quantized.data());
+    for (size_t l = 0; l < layers.size(); ++l)
+    {
+        if (l)
+            layers[l].quantize_input(workspace.activation.data(), workspace.quantized.data());
+        layers[l].forward(workspace.quantized.data(), workspace.sums.data(), workspace.activation.data());
+    }
+
+    output.assign(workspace.activation.begin(), workspace.activation.begin() + layers.back().outputs);
+}
+
+template <typename T>
+void QuantizedNetworkFF::forwardPass(const std::vector<T> &input, std::vector<float> &output) const
+{
+    static thread_local QuantizedWorkspace workspace;
+    forwardPass(input, output, workspace);
+}
+
+template <typename T>
+std::vector<float> QuantizedNetworkFF::forwardPass(const std::vector<T> &input) const
+{
+    std::vector<float> output;
+    forwardPass(input, output);
+    return output;
+}
+
+/**
+ * @brief Pad a quantized model file with zeros to a multiple of BINARY_ALIGNMENT bytes
+ *
+ */
+static void pad_quantized_file(std::vector<char> &contents)
+{
+    contents.resize((contents.size() + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT, 0);
+}
+
+/**
+ * @brief Append count values to a buffer
+ *
+ */
+template <typename T>
+static void append_values(std::vector<char> &buffer, const T *values, size_t count)
+{
+    const char *bytes = reinterpret_cast<const char *>(values);
+    buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+void QuantizedNetworkFF::save(const std::string &filename) const
+{
+    std::vector<char> contents(sizeof(QuantizedHeader));
+
+    for (const QuantizedLayer &layer : layers)
+    {
+        QuantizedLayerRecord record = {(uint32_t)layer.outputs, (uint32_t)(layer.layer_activation ? 1 : layer.outputs),
+                                       layer.input_scale, layer.input_zero_point};
+        append_values(contents, &record, 1);
+    }
+
+    for (const QuantizedLayer &layer : layers)
+    {
+        int count = layer.layer_activation ? 1 : layer.outputs;
+        for (int i = 0; i < count; ++i)
+        {
+            ActivationBase *activation_function = layer.layer_activation ? layer.layer_activation : layer.activation_functions[i];
+            if (activation_function->type() == ActivationFunctions::Custom)
+                throw ModelFileError("Custom activation functions can not be saved in a quantized model file");
+
+            BinaryActivation record = {(uint32_t)activation_function->type(), 0, activation_function->parameter()};
+            append_values(contents, &record, 1);
+        }
+    }
+    pad_quantized_file(contents);
+
+    for (const QuantizedLayer &layer : layers)
+    {
+        append_values(contents, layer.weights.data(), layer.weights.size());
+        append_values(contents, layer.weight_scales.data(), layer.outputs);
+        append_values(contents, layer.bias.data(), layer.outputs);
+        pad_quantized_file(contents);
+    }
+
+    QuantizedHeader header = {};
+    memcpy(header.magic, QUANTIZED_MAGIC, sizeof(QUANTIZED_MAGIC));
+    header.version = QUANTIZED_VERSION;
+    header.byte_order = BINARY_BYTE_ORDER;
+    header.num_inputs = input_size();
+    header.num_layers = layers.size();
+    header.file_size = contents.size();
+    header.checksum = binary_checksum(contents.data() + sizeof(QuantizedHeader), contents.size() - sizeof(QuantizedHeader));
+    memcpy(contents.data(), &header, sizeof(QuantizedHeader));
+
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile.write(contents.data(), contents.size()))
+        throw ModelFileError("Could not write " + filename);
+}
+
+/**
+ * @brief Report a problem with a quantized model file
+ *
+ */
+[[noreturn]] static void quantized_format_error(const std::string &message)
+{
+    throw ModelFileError("Invalid quantized model file. " + message);
+}
+
+/**
+ * @brief Copy count values out of a quantized model file, checking that they are inside it
+ *
+ */
+template <typename T>
+static void read_values(const MappedFile &file, size_t &offset, T *values, size_t count)
+{
+    if (count > (file.size() - offset) / sizeof(T))
+        quantized_format_error("The file ends in the middle of the parameters.");
+
+    memcpy(values, file.data() + offset, count * sizeof(T));
+    offset += count * sizeof(T);
+}
+
+QuantizedNetworkFF::QuantizedNetworkFF(const std::string &filename)
+{
+    MappedFile file(filename);
+    if (!file.is_open())
+        throw ModelFileError("Could not open " + filename);
+
+    const char *data = file.data();
+    size_t size = file.size();
+
+    QuantizedHeader header;
+    if (size < sizeof(QuantizedHeader))
+        quantized_format_error("The file is too small for the header.");
+    memcpy(&header, data, sizeof(QuantizedHeader));
+
+    if (memcmp(header.magic, QUANTIZED_MAGIC, sizeof(QUANTIZED_MAGIC)) != 0)
+        quantized_format_error("The file does not start with the quantized model magic.");
+    if (header.byte_order != BINARY_BYTE_ORDER)
+        quantized_format_error("It was saved on a machine with a different byte order.");
+    if (header.version != QUANTIZED_VERSION)
+        quantized_format_error("Unsupported version " + std::to_string(header.version) + ".");
+    if (header.file_size != size)
+        quantized_format_error("The file is " + std::to_string(size) + " bytes, the header says " + std::to_string(header.file_size) + ".");
+    if (header.checksum != binary_checksum(data + sizeof(QuantizedHeader), size - sizeof(QuantizedHeader)))
+        quantized_format_error("The checksum does not match, the file is corrupt.");
+
+    size_t offset = sizeof(QuantizedHeader);
+    if (header.num_layers == 0 || header.num_layers > (size - offset) / sizeof(QuantizedLayerRecord))
+        quantized_format_error("Invalid number of layers.");
+    if (header.num_inputs == 0 || header.num_inputs > (uint32_t)std::numeric_limits<int>::max() - QUANTIZED_ROW_ALIGNMENT)
+        quantized_format_error("Invalid number of inputs.");
+
+    std::vector<QuantizedLayerRecord> records(header.num_layers);
+    read_values(file, offset, records.data(), records.size());
+
+    layers.resize(header.num_layers);
+    int inputs = header.num_inputs;
+    for (size_t l = 0; l < layers.size(); ++l)
+    {
+        const QuantizedLayerRecord &record = records[l];
+        if (record.neurons == 0 || record.neurons > (uint32_t)std::numeric_limits<int>::max() - QUANTIZED_ROW_ALIGNMENT ||
+            (record.activation_count != 1 && record.activation_count != record.neurons))
+            quantized_format_error("Invalid shape for layer " + std::to_string(l) + ".");
+        if (!(record.input_scale > 0) || !std::isfinite(record.input_scale) ||
+            record.input_zero_point < 0 || record.input_zero_point > 127)
+            quantized_format_error("Invalid input quantization for layer " + std::to_string(l) + ".");
+
+        QuantizedLayer &layer = layers[l];
+        layer.inputs = inputs;
+        layer.outputs = record.neurons;
+        layer.stride = (inputs + QUANTIZED_ROW_ALIGNMENT - 1) / QUANTIZED_ROW_ALIGNMENT * QUANTIZED_ROW_ALIGNMENT;
+        layer.input_scale = record.input_scale;
+        layer.input_zero_point = record.input_zero_point;
+        inputs = layer.outputs;
+    }
+
+    for (size_t l = 0; l < layers.size(); ++l)
+    {
+        QuantizedLayer &layer = layers[l];
+        layer.activation_functions.resize(layer.outputs);
+        for (uint32_t i = 0; i < records[l].activation_count; ++i)
+        {
+            BinaryActivation record;
+            read_values(file, offset, &record, 1);
+
+            ActivationBase *activation_function = shared_activation_function((ActivationFunctions)record.type, record.parameter);
+            if (!activation_function)
+                quantized_format_error("Unknown activation function " + std::to_string(record.type) + ".");
+
+            if (records[l].activation_count == 1)
+                layer.activation_functions.assign(layer.outputs, activation_function);
+            else
+                layer.activation_functions[i] = activation_function;
+        }
+    }
+
+    for (QuantizedLayer &layer : layers)
+    {
+        offset = (offset + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT;
+        if (offset > size || (size_t)layer.outputs * layer.stride > size - offset)
+            quantized_format_error("The file ends in the middle of the parameters.");
+
+        layer.weights.resize((size_t)layer.outputs * layer.stride);
+        layer.weight_scales.resize(layer.outputs);
+        layer.bias.resize(layer.outputs);
+        read_values(file, offset, layer.weights.data(), layer.weights.size());
+        read_values(file, offset, layer.weight_scales.data(), layer.outputs);
+        read_values(file, offset, layer.bias.data(), layer.outputs);
+    }
+
+    prepare_layers();
+}
+
+#endif
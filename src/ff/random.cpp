@@ -0,0 +1,147 @@
+/**
+ * @file random.cpp
+ *
+ * @brief A fast, seedable random number generator with independent streams for each thread
+ * @version 0.1
+ * @date 2022-04-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef RANDOM_CPP
+#define RANDOM_CPP
+
+#include "../../include/ff/random.h"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <random>
+
+static const double TWO_PI = 6.283185307179586;
+
+// splitmix64, which turns any seed (even 0, or seeds that differ in one bit) into well mixed state
+static uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed, uint64_t stream)
+{
+    // The stream is mixed in on its own first, so that (seed, stream) pairs do not collide the way
+    // seed + stream would
+    uint64_t stream_mix = stream;
+    uint64_t x = seed ^ splitmix64(stream_mix);
+    for (uint64_t &word : state)
+        word = splitmix64(x);
+}
+
+double Xoshiro256::normal(double mean, double stddev)
+{
+    // 1 - uniform() is in (0, 1], so the log is finite
+    double radius = std::sqrt(-2 * std::log(1 - uniform()));
+    return mean + stddev * radius * std::cos(TWO_PI * uniform());
+}
+
+/**
+ * @brief Xoshiro256::fill_uniform in either precision
+ *
+ */
+template <typename T>
+static void fill_uniform_values(Xoshiro256 &random, Span<T> values, double a, double b)
+{
+    for (T &value : values)
+        value = random.uniform(a, b);
+}
+
+/**
+ * @brief Xoshiro256::fill_normal, or Xoshiro256::add_normal when add is set, in either precision. The values
+ *        are drawn two at a time (Box-Muller).
+ *
+ */
+template <typename T>
+static void normal_values(Xoshiro256 &random, Span<T> values, double mean, double stddev, bool add)
+{
+    size_t i = 0;
+    for (; i + 1 < values.size(); i += 2)
+    {
+        double radius = stddev * std::sqrt(-2 * std::log(1 - random.uniform()));
+        double angle = TWO_PI * random.uniform();
+        values[i] = (add ? values[i] : 0) + mean + radius * std::cos(angle);
+        values[i + 1] = (add ? values[i + 1] : 0) + mean + radius * std::sin(angle);
+    }
+
+    if (i < values.size())
+        values[i] = (add ? values[i] : 0) + random.normal(mean, stddev);
+}
+
+void Xoshiro256::fill_uniform(Span<double> values, double a, double b)
+{
+    fill_uniform_values(*this, values, a, b);
+}
+
+void Xoshiro256::fill_normal(Span<double> values, double mean, double stddev)
+{
+    normal_values(*this, values, mean, stddev, false);
+}
+
+void Xoshiro256::add_normal(Span<double> values, double stddev)
+{
+    normal_values(*this, values, 0, stddev, true);
+}
+
+void Xoshiro256::fill_uniform(Span<float> values, double a, double b)
+{
+    fill_uniform_values(*this, values, a, b);
+}
+
+void Xoshiro256::fill_normal(Span<float> values, double mean, double stddev)
+{
+    normal_values(*this, values, mean, stddev, false);
+}
+
+void Xoshiro256::add_normal(Span<float> values, double stddev)
+{
+    normal_values(*this, values, 0, stddev, true);
+}
+
+// The seed every thread's generator is made from. Each call to seed_random starts a new epoch, and a thread
+// makes a new generator the first time it draws in an epoch.
+static std::mutex random_seed_mutex;
+static uint64_t random_seed = 0;
+static uint64_t random_next_stream = 0;
+static std::atomic<uint64_t> random_epoch(0);
+
+void seed_random(uint64_t seed)
+{
+    std::lock_guard<std::mutex> lock(random_seed_mutex);
+    random_seed = seed;
+    random_next_stream = 0;
+    random_epoch.fetch_add(1, std::memory_order_release);
+}
+
+Xoshiro256 &thread_random()
+{
+    thread_local Xoshiro256 generator;
+    thread_local uint64_t generator_epoch = -1;
+
+    if (generator_epoch != random_epoch.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(random_seed_mutex);
+
+        // Epoch 0 is before seed_random has been called
+        uint64_t epoch = random_epoch.load(std::memory_order_relaxed);
+        if (epoch == 0 && random_next_stream == 0)
+            random_seed = ((uint64_t)std::random_device()() << 32) ^ std::random_device()();
+
+        generator = Xoshiro256(random_seed, random_next_stream++);
+        generator_epoch = epoch;
+    }
+
+    return generator;
+}
+
+#endif
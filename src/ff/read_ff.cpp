@@ -1,7 +1,7 @@
 /**
  * @file read_ff.cpp
  *
- * @brief Contains functionality for reading in a neural network from a stream
+ * @brief Contains functionality for reading in a neural network from a stream or file
  * @version 0.1
  * @date 2022-02-12
  *
@@ -13,174 +13,335 @@
 #define READ_FF_CPP
 
 #include "../../include/ff/ff.h"
-#include "../../include/ff/neuron.h"
 #include "../../include/ff/activation.h"
-#include "../../include/utils.h"
+#include "../../include/ff/model_file_error.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
-#include <iostream>
-#include <fstream>
 
-using namespace std;
+/**
+ * @brief Convert a plain decimal like -0.0279005 without the general algorithm in std::from_chars.
+ *        With at most 15 digits (7 for a float, with at most 10 after the point) the digits and the power
+ *        of ten are both exact, so the one division is correctly rounded and gives the same value
+ *        std::from_chars would.
+ *
+ * @return false if the text is not a plain decimal with few enough digits, and value is unchanged
+ */
+template <typename T>
+static bool parse_short_decimal(std::string_view text, T &value)
+{
+    static const T powers_of_10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    static const int max_digits = std::is_same_v<T, float> ? 7 : 15;
+    static const int max_fraction_digits = std::is_same_v<T, float> ? 10 : 15;
+
+    const char *c = text.data(), *end = text.data() + text.size();
+    bool negative = c < end && *c == '-';
+    c += negative;
+
+    uint64_t digits = 0;
+    int num_digits = 0, num_fraction_digits = 0;
+    for (; c < end && (unsigned)(*c - '0') < 10; ++c, ++num_digits)
+        digits = digits * 10 + (*c - '0');
+    if (c < end && *c == '.')
+    {
+        for (++c; c < end && (unsigned)(*c - '0') < 10; ++c, ++num_digits, ++num_fraction_digits)
+            digits = digits * 10 + (*c - '0');
+    }
 
-vector<Neuron> parse_layer_from_is(istream &is, int prev_layer_size);
+    if (c != end || num_digits == 0 || num_digits > max_digits || num_fraction_digits > max_fraction_digits)
+        return false;
 
-NeuralNetworkFF::NeuralNetworkFF(std::istream &is)
+    value = (T)digits / powers_of_10[num_fraction_digits];
+    if (negative)
+        value = -value;
+    return true;
+}
+
+/**
+ * @brief Splits the text representation into lines and words in place, without copying it. Numbers
+ *        are converted with std::from_chars, and every error is thrown with the line it is on.
+ *
+ */
+class TextModelTokenizer
 {
+public:
+    TextModelTokenizer(const char *begin, const char *end) : position(begin), line_end(begin), next_line_start(begin), end(end) {}
+
+    /**
+     * @brief Move to the start of the next line that is not blank or a comment
+     *
+     * @return false at the end of the text
+     */
+    bool next_line()
+    {
+        while (next_line_start < end)
+        {
+            position = next_line_start;
+            const char *newline = static_cast<const char *>(memchr(position, '\n', end - position));
+            line_end = newline ? newline : end;
+            next_line_start = newline ? newline + 1 : end;
+            ++line_number;
+
+            if (!at_end_of_line())
+                return true;
+        }
 
-    string line;
-    //is >> std::ws; // remove unwanted leading whitespace
+        return false;
+    }
 
-    // Run this loop while there is data left in the input stream
-    while (is >> std::ws && getline(is, line, '\n') && line.length())
+    /**
+     * @brief The next word on the current line, or an empty view at the end of the line
+     *
+     */
+    std::string_view word()
     {
+        if (at_end_of_line())
+            return {};
+
+        // Scanning through a local pointer keeps it in a register, the characters could alias a member
+        const char *start = position, *stop = position;
+        while (stop < line_end && !is_space(*stop))
+            ++stop;
 
-        vector<string> split_str = split(line, ' ');
-        string command = split_str[0];
+        position = stop;
+        return std::string_view(start, stop - start);
+    }
 
-        // Skip line on comment
-        if (command[0] == '#')
+    /**
+     * @brief The next word on the current line, converted to a number
+     *
+     * @param what - what the number is, for the error message
+     */
+    template <typename T>
+    T number(const char *what)
+    {
+        std::string_view text = word();
+        if (text.empty())
+            error(std::string("Expected ") + what);
+
+        T value;
+        if constexpr (std::is_floating_point_v<T>)
         {
-            continue;
+            if (parse_short_decimal(text, value))
+                return value;
         }
 
-        // Parse a new layer
-        if (command == "def")
-        {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+            error(std::string("Invalid ") + what + " \"" + std::string(text) + "\"");
 
-            // Parse a layer
-            if (split_str.size() > 1 && split_str[1] == "layer")
-            {
-                if (neurons.size())
-                {
-                    neurons.push_back(parse_layer_from_is(is, neurons.back().size()));
-                }
-                else
-                {
-                    neurons.push_back(parse_layer_from_is(is, 0));
-                }
-            }
-            else
-            {
-                cerr << "Invalid definition. Try \"def layer\"" << endl;
-                exit(1);
-            }
-        }
+        return value;
     }
-}
-
-vector<Neuron> parse_layer_from_is(istream &is, int prev_layer_size)
-{
 
-    string line;
-    // is >> std::ws; // remove unwanted leading whitespace
+    /**
+     * @brief Whether only whitespace and comments are left on the current line
+     *
+     */
+    bool at_end_of_line()
+    {
+        const char *next = position;
+        while (next < line_end && is_space(*next))
+            ++next;
 
-    bool size_set = false;
-    int layer_size = 0;
+        position = next;
+        return next == line_end || *next == '#';
+    }
 
-    vector<Neuron> neurons;
+    /**
+     * @brief Throw if there is anything but whitespace and comments left on the current line
+     *
+     */
+    void expect_end_of_line()
+    {
+        if (!at_end_of_line())
+            error("Unexpected \"" + std::string(word()) + "\"");
+    }
 
-    while (is >> std::ws && getline(is, line, '\n') && line.length())
+    [[noreturn]] void error(const std::string &message) const
     {
+        throw ModelFileError(message, line_number);
+    }
 
-        vector<string> split_str = split(line, ' ');
+private:
+    static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
 
-        if (split_str[0] == "def")
-        {
-            cerr << "Error: Unclosed layer before new layer definition." << endl;
-            ::exit(1);
-        }
+    const char *position; // The next character to read
+    const char *line_end; // The newline (or end of the text) at the end of the current line
+    const char *next_line_start;
+    const char *end;
+    int line_number = 0;
+};
 
-        else if (split_str[0] == "neurons")
-        {
-            if (size_set)
-            {
-                cerr << "Size already set" << endl;
-                ::exit(1);
-            }
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(std::istream &is)
+{
+    std::string text((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    read_text(text.data(), text.data() + text.size());
+}
+
+template <typename Scalar>
+void BasicNeuralNetworkFF<Scalar>::read_text(const char *begin, const char *end)
+{
+    TextModelTokenizer tokens(begin, end);
 
-            size_set = true;
-            layer_size = stoi(split_str[1]);
+    // The values go straight into their final layout: for each layer, the weights then the bias'
+    std::vector<int> neuron_counts;
+    std::vector<Scalar> values;
+    std::vector<std::vector<ActivationBase *>> activations;
 
-            neurons.resize(layer_size);
-        }
+    while (tokens.next_line())
+    {
+        if (tokens.word() != "def" || tokens.word() != "layer")
+            tokens.error("Invalid definition. Try \"def layer\"");
+        tokens.expect_end_of_line();
 
-        else if (split_str[0] == "neuron")
+        int inputs = neuron_counts.empty() ? 0 : neuron_counts.back();
+        size_t offset = values.size();
+        int size = 0;
+
+        while (true)
         {
-            int index = stoi(split_str[1]);
+            if (!tokens.next_line())
+                tokens.error("Unfinished layer definition");
+
+            std::string_view command = tokens.word();
 
-            if (split_str[2] == "bias")
+            if (command == "neurons")
             {
-                neurons[index].setBias(stod(split_str[3]));
+                if (size)
+                    tokens.error("Size already set");
+
+                size = tokens.number<int>("neuron count");
+                if (size <= 0)
+                    tokens.error("The neuron count must be positive");
+
+                if (inputs)
+                    values.resize(offset + (size_t)size * inputs + size, 0);
+                activations.emplace_back(size, default_activation_function());
             }
 
-            if (split_str[2] == "weights")
+            else if (command == "neuron")
             {
-                if (split_str.size() != 3 + prev_layer_size)
-                {
-                    cerr << "Invalid number of weights in neuron defintion\nLine: " << endl;
-                    cerr << line;
-                    exit(1);
-                }
+                if (!size)
+                    tokens.error("The neuron count must be set before the neurons");
+
+                int index = tokens.number<int>("neuron index");
+                if (index < 0 || index >= size)
+                    tokens.error("Neuron index " + std::to_string(index) + " is out of range");
 
-                vector<double> weights;
+                Scalar *weights = values.data() + offset + (size_t)index * inputs;
+                Scalar *bias = values.data() + offset + (size_t)size * inputs + index;
 
-                for (int i = 0; i < prev_layer_size; ++i)
+                std::string_view property = tokens.word();
+                if (property == "bias")
+                {
+                    Scalar value = tokens.number<Scalar>("bias");
+                    if (inputs) // The input layer has no bias'
+                        *bias = value;
+                }
+                else if (property == "weights")
+                {
+                    for (int i = 0; i < inputs; ++i)
+                    {
+                        if (tokens.at_end_of_line())
+                            tokens.error("Invalid number of weights in neuron definition, expected " + std::to_string(inputs) + " and got " + std::to_string(i));
+                        weights[i] = tokens.number<Scalar>("weight");
+                    }
+                    if (!tokens.at_end_of_line())
+                        tokens.error("Invalid number of weights in neuron definition, expected " + std::to_string(inputs));
+                }
+                else if (property == "weight")
                 {
-                    weights.push_back(stod(split_str[3 + i]));
+                    int weight_index = tokens.number<int>("weight index");
+                    if (weight_index < 0 || weight_index >= inputs)
+                        tokens.error("Weight index " + std::to_string(weight_index) + " is out of range");
+                    weights[weight_index] = tokens.number<Scalar>("weight");
                 }
+                else if (property == "activation")
+                {
+                    std::string_view name = tokens.word();
+                    ActivationFunctions type = activation_function_from_name(name);
+                    if (type == ActivationFunctions::Custom)
+                        tokens.error("Unknown activation function \"" + std::string(name) + "\"");
 
-                neurons[index].setWeights(weights);
+                    double parameter = activation_function_has_parameter(type) ? tokens.number<double>("activation parameter") : 0;
+                    activations.back()[index] = shared_activation_function(type, parameter);
+                }
+                else
+                    tokens.error("Unknown neuron property \"" + std::string(property) + "\"");
             }
 
-            if (split_str[2] == "weight")
+            else if (command == "end")
             {
-                int weight_index = stoi(split_str[3]);
-                neurons[index].setWeight(weight_index, stod(split_str[4]));
+                if (tokens.word() != "layer")
+                    tokens.error("Invalid close. Try \"end layer\"");
+                tokens.expect_end_of_line();
+                break;
             }
 
-            if (split_str[2] == "activation")
-            {
-                if (split_str[3] == "linear")
-                {
-                    neurons[index].setActivationBase(new Linear(stod(split_str[4])));
-                }
-            }
-        }
+            else if (command == "def")
+                tokens.error("Unclosed layer before new layer definition");
 
-        else if (split_str[0] == "end")
-        {
-            if (split_str[1] == "layer")
-            {
-                return neurons;
-            }
+            else
+                tokens.error("Unknown command \"" + std::string(command) + "\"");
 
-            cerr << "Error: Invalid close" << endl;
-            cerr << "Line: " << line << endl;
-            exit(1);
+            tokens.expect_end_of_line();
         }
+
+        if (!size)
+            tokens.error("The layer has no neuron count");
+        if (mixes_softmax(activations.back()))
+            tokens.error("The softmax applies to a whole layer, every neuron in the layer must use it");
+        neuron_counts.push_back(size);
     }
 
-    cerr << "Error: Invalid file. Unfinished layer definition" << endl;
-    exit(1);
-    return {};
-}
+    if (neuron_counts.empty())
+        tokens.error("The file does not define any layers");
 
-static std::ifstream INFILE_g;
-std::ifstream &file_helper(std::string filename)
-{
-    INFILE_g.open(filename);
+    allocate_layers(neuron_counts, false);
+    parameter_storage = std::move(values);
+    parameters = Span<Scalar>(parameter_storage);
+    bind_layers();
 
-    if (!INFILE_g.is_open())
+    for (int i = 0; i < layers.size(); ++i)
     {
-        std::cerr << "Error: could not open file " << filename << endl;
-        exit(1);
+        layers[i].activation_functions = std::move(activations[i]);
+        layers[i].update_activation_type();
     }
+}
 
-    return INFILE_g;
+/**
+ * @brief Whether a file starts with the magic bytes of a binary model file
+ *
+ */
+static bool is_binary_model_file(const MappedFile &file)
+{
+    return file.size() >= sizeof(BINARY_MAGIC) && std::equal(BINARY_MAGIC, BINARY_MAGIC + sizeof(BINARY_MAGIC), file.data());
 }
-NeuralNetworkFF::NeuralNetworkFF(std::string filename) : NeuralNetworkFF(file_helper(filename))
+
+template <typename Scalar>
+BasicNeuralNetworkFF<Scalar>::BasicNeuralNetworkFF(std::string filename)
 {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+
+    if (!file->is_open())
+        throw ModelFileError("Could not open " + filename);
+
+    if (is_binary_model_file(*file))
+    {
+        read_binary(file);
+    }
+    else
+    {
+        read_text(file->data(), file->data() + file->size());
+    }
 }
 
 #endif
\ No newline at end of file
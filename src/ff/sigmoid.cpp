@@ -13,6 +13,7 @@
 #define SIGNOID_CPP
 
 #include "../../include/ff/sigmoid.h"
+#include "../../include/ff/kernels.h"
 #include <cmath>
 #include <string>
 
@@ -29,8 +30,30 @@ double Sigmoid::derivative(double x){
     return s * (1 - s); // derivate of sigmoid S(X) is S(X) * (1 - S(X)) 
 }
 
+ActivationFunctions Sigmoid::type(){
+    return ActivationFunctions::Sigmoid; 
+}
+
+void Sigmoid::apply(Span<const double> input, Span<double> output){
+    kernels::sigmoid(input.size(), input.data(), output.data()); 
+}
+
+void Sigmoid::derivative_from_output(Span<const double> /*input*/, Span<const double> output, Span<double> derivative){
+    for(size_t i = 0; i < output.size(); ++i)
+        derivative[i] = output[i] * (1 - output[i]); 
+}
+
+void Sigmoid::apply(Span<const float> input, Span<float> output){
+    kernels::sigmoid(input.size(), input.data(), output.data()); 
+}
+
+void Sigmoid::derivative_from_output(Span<const float> /*input*/, Span<const float> output, Span<float> derivative){
+    for(size_t i = 0; i < output.size(); ++i)
+        derivative[i] = output[i] * (1 - output[i]); 
+}
+
 std::string Sigmoid::to_external_repr(){
-    return "Sigmoid"; 
+    return activation_function_repr(type(), 0); 
 }
 
 Sigmoid::Sigmoid(){}
@@ -0,0 +1,80 @@
+/**
+ * @file thread_pool.cpp
+ *
+ * @brief A fixed set of threads that run numbered tasks
+ * @version 0.1
+ * @date 2022-04-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef THREAD_POOL_CPP
+#define THREAD_POOL_CPP
+
+#include "../../include/ff/thread_pool.h"
+
+ThreadPool::ThreadPool(int num_threads)
+{
+    for (int i = 1; i < num_threads; ++i)
+        threads.emplace_back(&ThreadPool::worker, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+void ThreadPool::run(int num_tasks, const std::function<void(int)> &task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->num_tasks = num_tasks;
+        running = threads.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    // The calling thread is thread 0
+    for (int i = 0; i < num_tasks; i += size())
+        task(i);
+
+    // No thread can still be on this generation when the next call to run starts
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return running == 0; });
+}
+
+void ThreadPool::worker(int index)
+{
+    size_t seen = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]() { return stop || generation != seen; });
+        if (stop)
+            return;
+
+        seen = generation;
+        const std::function<void(int)> &current = *task;
+        int count = num_tasks;
+        lock.unlock();
+
+        for (int i = index; i < count; i += size())
+            current(i);
+
+        lock.lock();
+        if (--running == 0)
+            done.notify_one();
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file idx.cpp
+ *
+ * @brief Reads the IDX files the MNIST dataset is distributed in by mapping them into memory
+ * @version 0.1
+ * @date 2022-04-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef IDX_CPP
+#define IDX_CPP
+
+#include "../../include/mnist/idx.h"
+#include "../ff/mapped_file.cpp"
+#include <iostream>
+#include <stdexcept>
+
+// The type byte of an IDX file of unsigned bytes
+static const uint8_t IDX_UNSIGNED_BYTE = 0x08;
+
+IdxFile::IdxFile(const std::string &filename) : file(new MappedFile(filename))
+{
+    if (!file->is_open())
+        throw std::runtime_error("Could not open " + filename);
+
+    const uint8_t *contents = (const uint8_t *)file->data();
+    size_t length = file->size();
+    if (length < 4 || contents[0] || contents[1] || contents[2] != IDX_UNSIGNED_BYTE || !contents[3])
+        throw std::runtime_error(filename + " is not an IDX file of unsigned bytes");
+
+    size_t header = 4 + 4 * (size_t)contents[3];
+    if (length < header)
+        throw std::runtime_error(filename + " is shorter than its header");
+
+    // Checked one dimension at a time, so the product can not overflow
+    size_t available = length - header;
+    count = 1;
+    for (size_t d = 0; d < contents[3]; ++d)
+    {
+        const uint8_t *size = contents + 4 + 4 * d;
+        sizes.push_back((size_t)size[0] << 24 | (size_t)size[1] << 16 | (size_t)size[2] << 8 | size[3]);
+        if (sizes.back() && count > available / sizes.back())
+            throw std::runtime_error(filename + " is shorter than its header says");
+        count *= sizes.back();
+    }
+
+    first_value = contents + header;
+}
+
+MnistImages::MnistImages(const IdxFile &file)
+{
+    const std::vector<size_t> &sizes = file.dimensions();
+    if (sizes.size() != 3)
+        throw std::runtime_error("IDX image files have 3 dimensions");
+
+    pixels = file.values().data();
+    count = sizes[0];
+    rows = sizes[1];
+    columns = sizes[2];
+}
+
+/**
+ * @brief The path of a file in a directory
+ *
+ */
+static std::string idx_path(const std::string &directory, const char *filename)
+{
+    return directory.empty() || directory.back() == '/' ? directory + filename : directory + "/" + filename;
+}
+
+MappedMnistDataset::MappedMnistDataset(const std::string &directory)
+    : training_image_file(idx_path(directory, "train-images-idx3-ubyte")),
+      training_label_file(idx_path(directory, "train-labels-idx1-ubyte")),
+      test_image_file(idx_path(directory, "t10k-images-idx3-ubyte")),
+      test_label_file(idx_path(directory, "t10k-labels-idx1-ubyte")),
+      training_image_view(training_image_file),
+      test_image_view(test_image_file)
+{
+    if (training_label_file.dimensions().size() != 1 || test_label_file.dimensions().size() != 1)
+        throw std::runtime_error("IDX label files have 1 dimension");
+    if (training_image_view.size() != training_labels().size() || test_image_view.size() != test_labels().size())
+        throw std::runtime_error("The MNIST image and label files have different numbers of examples");
+}
+
+void display_image(Span<const uint8_t> image, size_t columns)
+{
+    std::string border(columns + 2, '_');
+    std::cout << border << "\n";
+    for (size_t row = 0; row + columns <= image.size(); row += columns)
+    {
+        std::cout << "|";
+        for (size_t i = row; i < row + columns; ++i)
+            std::cout << (image[i] ? '*' : ' ');
+        std::cout << "|\n";
+    }
+    std::cout << border << std::endl;
+}
+
+#endif
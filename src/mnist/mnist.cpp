@@ -13,12 +13,13 @@
 #define MNIST_READ_CPP
 
 #include "../../include/mnist/mnist.h"
+#include <utility>
 
 MNIST_DATASET * read_dataset(){
     mnist::MNIST_dataset<std::vector, std::vector<uint8_t>, uint8_t> dataset =
         mnist::read_dataset<std::vector, std::vector, uint8_t, uint8_t>("./data/");
 
-    return new MNIST_DATASET(dataset); // ineffient :)
+    return new MNIST_DATASET(std::move(dataset));
 }
 
 #endif 
\ No newline at end of file
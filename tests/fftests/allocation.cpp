@@ -0,0 +1,181 @@
+/**
+ * @file allocation.cpp
+ *
+ * @brief Checks that the steady state forward pass and training step do not touch the heap
+ * @version 0.1
+ * @date 2022-04-03
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note To compile:
+ *          g++ tests/fftests/allocation.cpp -g3 -o bin/allocation_tests
+ *       To run:
+ *          ./bin/allocation_tests
+ *
+ */
+
+#include "../unit_test_framework.h"
+#include "../../include/ff/ff.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Every call to the global operator new is counted while counting_allocations is set, and every
+// allocation made while counting that has not been deleted yet is live
+static bool counting_allocations = false;
+static size_t allocation_count = 0;
+static long live_allocations = 0;
+
+void *operator new(size_t size)
+{
+    if (counting_allocations)
+    {
+        ++allocation_count;
+        ++live_allocations;
+    }
+
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (counting_allocations && ptr)
+        --live_allocations;
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    if (counting_allocations && ptr)
+        --live_allocations;
+    std::free(ptr);
+}
+
+/**
+ * @brief Count the number of allocations made by func
+ *
+ */
+template <typename Func>
+size_t count_allocations(Func func)
+{
+    allocation_count = 0;
+    counting_allocations = true;
+    func();
+    counting_allocations = false;
+    return allocation_count;
+}
+
+/**
+ * @brief The number of allocations made by func that it did not free
+ *
+ */
+template <typename Func>
+long count_leaks(Func func)
+{
+    live_allocations = 0;
+    counting_allocations = true;
+    func();
+    counting_allocations = false;
+    return live_allocations;
+}
+
+TEST(forward_pass_does_not_allocate){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {784, 100, 10};
+    NeuralNetworkFF net(num_layers, neuron_counts);
+
+    std::vector<double> input(784, 0.5);
+    std::vector<double> output;
+
+    // Warm up, this is allowed to size the output vector
+    net.forwardPass(input, output);
+
+    size_t allocations = count_allocations([&]() {
+        for (int i = 0; i < 100; ++i)
+            net.forwardPass(input, output);
+    });
+
+    ASSERT_EQUAL(allocations, 0);
+    ASSERT_EQUAL(output.size(), 10);
+}
+
+TEST(forward_pass_output_is_replaced){
+    int num_layers = 2;
+    std::vector<int> neuron_counts = {2, 1};
+    std::vector<std::vector<std::vector< double >>> weights = {{}, {{ 20, 20 }}};
+    std::vector<std::vector< double >> bias = { {}, {-10} };
+    NeuralNetworkFF net(num_layers, neuron_counts, weights, bias);
+
+    std::vector<double> input = {1, 1};
+    std::vector<double> output;
+
+    net.forwardPass(input, output);
+    net.forwardPass(input, output);
+
+    ASSERT_EQUAL(output.size(), 1);
+    ASSERT_EQUAL(output[0], net.forwardPass(input)[0]);
+}
+
+TEST(train_on_example_does_not_allocate){
+    int num_layers = 4;
+    std::vector<int> neuron_counts = {784, 100, 30, 10};
+    NeuralNetworkFF net(num_layers, neuron_counts);
+
+    std::vector<double> input(784, 0.5);
+    std::vector<double> expected(10, 0);
+    expected[3] = 1;
+
+    net.train_on_example(input, expected);
+    net.update_weights(0.1);
+
+    size_t allocations = count_allocations([&]() {
+        for (int i = 0; i < 10; ++i)
+            net.train_on_example(input, expected);
+        net.update_weights(0.1);
+    });
+
+    ASSERT_EQUAL(allocations, 0);
+}
+
+TEST(networks_free_everything_they_allocate){
+    // Every neuron has an activation function with a parameter, which used to be allocated for each neuron
+    std::string text = "def layer\nneurons 2\nend layer\ndef layer\nneurons 3\n";
+    for (int i = 0; i < 3; ++i)
+        text += "neuron " + std::to_string(i) + " weights 0.5 -0.5\nneuron " + std::to_string(i) + " activation leaky_relu 0.1\n";
+    text += "end layer\ndef layer\nneurons 1\nneuron 0 activation linear 2\nend layer\n";
+
+    std::vector<std::vector<double>> examples = {{0, 1}, {1, 0}};
+    std::vector<std::vector<double>> expected = {{1}, {0}};
+    auto compare = [](const std::vector<double> &, const std::vector<double> &) { return true; };
+
+    auto use_networks = [&]() {
+        std::stringstream ss(text);
+        NeuralNetworkFF net(ss);
+        NeuralNetworkFF copy(net);
+        copy = net;
+
+        LeakyReLU leaky_relu(0.25);
+        copy.set_activation_function(1, &leaky_relu);
+
+        // Without a config, train and test use their defaults
+        net.train(examples.begin(), examples.end(), expected.begin(), expected.end());
+        net.test(examples.begin(), examples.end(), expected.begin(), expected.end(), compare);
+
+        net.save_binary("allocation_test_model");
+        NeuralNetworkFF loaded("allocation_test_model");
+        std::remove("allocation_test_model");
+    };
+
+    // The first time round creates the shared activation functions, which live as long as the program
+    use_networks();
+
+    ASSERT_EQUAL(count_leaks(use_networks), 0);
+}
+
+TEST_MAIN()
@@ -18,6 +18,8 @@
 #include "../unit_test_framework.h"
 #include <vector>
 #include <iostream>
+#include <cmath>
+#include <stdexcept>
 
 using namespace std;
 
@@ -195,16 +197,567 @@ TEST(batch_size_3_test){
     net.train_on_example( sample_input_2, sample_output_2 ); 
     net.train_on_example( sample_input_3, sample_output_3 ); 
 
-    ASSERT_EQUAL(net.neurons[1][0].num_examples_dBias, 3);
-    ASSERT_EQUAL(net.neurons[1][0].num_examples_dWeight, 3); 
+    ASSERT_EQUAL(net.num_examples, 3);
 
     net.update_weights(1, true); 
     
     ASSERT_ALMOST_EQUAL( net.neurons[1][0].getWeights()[0], 0.5 - (-0.0104972717839 + 0.00493545474415 + 0.00899427909599) / 3, 0.00000001); 
 
-    ASSERT_EQUAL(net.neurons[1][0].num_examples_dBias, 0);
-    ASSERT_EQUAL(net.neurons[1][0].num_examples_dWeight, 0); 
+    ASSERT_EQUAL(net.num_examples, 0);
 
 }
 
+TEST(train_batch_matches_train_on_example){
+    int num_layers = 4;
+    std::vector<int> neuron_counts = {3, 5, 4, 2};
+    NeuralNetworkFF net(num_layers, neuron_counts);
+    NeuralNetworkFF batch_net(net);
+
+    // 6 examples, so the batched code has a block of 4 and 2 left over
+    Matrix inputs(6, 3);
+    Matrix expected(6, 2);
+    for(int e = 0; e < 6; ++e){
+        for(int i = 0; i < 3; ++i)
+            inputs(e, i) = (e + 1) * 0.1 - i * 0.2;
+        expected(e, e % 2) = 1;
+    }
+
+    for(int e = 0; e < 6; ++e){
+        std::vector< double > input(inputs.row(e), inputs.row(e) + 3);
+        std::vector< double > output(expected.row(e), expected.row(e) + 2);
+        net.train_on_example(input, output);
+    }
+    batch_net.trainBatch(inputs, expected);
+
+    ASSERT_EQUAL(batch_net.num_examples, 6);
+    for(int i = 0; i < net.gradient_sums.size(); ++i)
+        ASSERT_ALMOST_EQUAL(batch_net.gradient_sums[i], net.gradient_sums[i], 0.000000000001);
+
+    net.update_weights(0.5, true);
+    batch_net.update_weights(0.5, true);
+
+    for(int i = 0; i < net.parameters.size(); ++i)
+        ASSERT_ALMOST_EQUAL(batch_net.parameters[i], net.parameters[i], 0.000000000001);
+}
+
+TEST(backprop_matches_finite_differences){
+    // Deep enough that the deltas are carried back through two hidden layers. Each loss is checked with the
+    // output activation it is meant for, so the fused gradients are checked too.
+    std::vector<int> neuron_counts = {3, 5, 4, 3, 2};
+    vector<double> input = {0.5, -0.25, 1};
+    vector<double> expected = {1, 0};
+
+    MeanSquaredError mean_squared_error;
+    BinaryCrossEntropy binary_cross_entropy;
+    SoftmaxCrossEntropy softmax_cross_entropy;
+    Linear identity(1);
+    std::vector<std::pair<const LossFunction *, ActivationBase *>> cases = {
+        {&mean_squared_error, default_activation_function()},
+        {&binary_cross_entropy, default_activation_function()},
+        {&softmax_cross_entropy, &identity}};
+
+    for(auto &loss_and_activation : cases){
+        NeuralNetworkFF net(5, neuron_counts);
+        net.set_loss_function(loss_and_activation.first);
+        net.set_activation_function(4, loss_and_activation.second);
+
+        net.train_on_example(input, expected);
+
+        auto loss = [&](){
+            return net.get_loss_function().loss(net.forwardPass(input), expected);
+        };
+
+        const double h = 1e-6;
+        for(int i = 0; i < net.parameters.size(); ++i){
+            double parameter = net.parameters[i];
+            net.parameters[i] = parameter + h;
+            double above = loss();
+            net.parameters[i] = parameter - h;
+            double below = loss();
+            net.parameters[i] = parameter;
+
+            ASSERT_ALMOST_EQUAL(net.gradient_sums[i], (above - below) / (2 * h), 0.000001);
+        }
+    }
+}
+
+TEST(every_activation_backprops_correctly){
+    std::vector<int> neuron_counts = {3, 5, 4, 3};
+    vector<double> input = {0.5, -0.25, 1};
+    vector<double> expected = {0, 1, 0};
+
+    ReLU relu;
+    LeakyReLU leaky_relu(0.1);
+    ELU elu(0.5);
+    GELU gelu;
+    Tanh tanh_activation;
+    Softmax softmax;
+    MeanSquaredError mean_squared_error;
+    CategoricalCrossEntropy categorical_cross_entropy;
+
+    // The hidden layers use each function, and the softmax output layer is checked both through its Jacobian
+    // (squared error) and fused with the cross-entropy
+    std::vector<ActivationBase *> hidden = {&relu, &leaky_relu, &elu, &gelu, &tanh_activation, &softmax};
+    for(ActivationBase *activation_function : hidden){
+        for(const LossFunction *loss : {(const LossFunction *)&mean_squared_error, (const LossFunction *)&categorical_cross_entropy}){
+            NeuralNetworkFF net(4, neuron_counts);
+            net.set_activation_function(1, activation_function);
+            net.set_activation_function(2, activation_function);
+            net.set_activation_function(3, &softmax);
+            net.set_loss_function(loss);
+
+            net.train_on_example(input, expected);
+
+            auto loss_at = [&](){
+                return loss->loss(net.forwardPass(input), expected);
+            };
+
+            const double h = 1e-6;
+            for(int i = 0; i < net.parameters.size(); ++i){
+                double parameter = net.parameters[i];
+                net.parameters[i] = parameter + h;
+                double above = loss_at();
+                net.parameters[i] = parameter - h;
+                double below = loss_at();
+                net.parameters[i] = parameter;
+
+                ASSERT_ALMOST_EQUAL(net.gradient_sums[i], (above - below) / (2 * h), 0.000001);
+            }
+
+            // The batched code applies the softmax to each example on its own
+            NeuralNetworkFF batch_net(net);
+            batch_net.gradient_sums.assign(batch_net.gradient_sums.size(), 0);
+            batch_net.num_examples = 0;
+            net.train_on_example({-1, 0.5, 0.25}, {1, 0, 0});
+
+            Matrix inputs(2, 3), batch_expected(2, 3);
+            for(int i = 0; i < 3; ++i){
+                inputs(0, i) = input[i];
+                batch_expected(0, i) = expected[i];
+            }
+            inputs(1, 0) = -1;
+            inputs(1, 1) = 0.5;
+            inputs(1, 2) = 0.25;
+            batch_expected(1, 0) = 1;
+            batch_net.trainBatch(inputs, batch_expected);
+
+            for(int i = 0; i < net.gradient_sums.size(); ++i)
+                ASSERT_ALMOST_EQUAL(batch_net.gradient_sums[i], net.gradient_sums[i], 0.000000000001);
+        }
+    }
+}
+
+TEST(loss_functions){
+    vector<double> output = {0.2, 0.7, 0.1};
+    vector<double> expected = {0, 1, 0};
+    vector<double> gradient(3);
+
+    MeanSquaredError mean_squared_error;
+    ASSERT_ALMOST_EQUAL(mean_squared_error.loss(output, expected), 0.04 + 0.09 + 0.01, 0.000000000000001);
+
+    BinaryCrossEntropy binary_cross_entropy;
+    ASSERT_ALMOST_EQUAL(binary_cross_entropy.loss(output, expected), -log(0.8) - log(0.7) - log(0.9), 0.000000000000001);
+
+    // Cross-entropy after a sigmoid is output - expected, with or without fusing
+    ASSERT_TRUE(binary_cross_entropy.fused_gradient(ActivationFunctions::Sigmoid, output, expected, gradient));
+    for(int i = 0; i < 3; ++i)
+        ASSERT_ALMOST_EQUAL(gradient[i], output[i] - expected[i], 0.000000000000001);
+    ASSERT_FALSE(binary_cross_entropy.fused_gradient(ActivationFunctions::Linear, output, expected, gradient));
+    binary_cross_entropy.gradient(output, expected, gradient);
+    for(int i = 0; i < 3; ++i)
+        ASSERT_ALMOST_EQUAL(gradient[i] * output[i] * (1 - output[i]), output[i] - expected[i], 0.000000000000001);
+
+    // The softmax cross-entropy is the log of the probability of the expected class
+    SoftmaxCrossEntropy softmax_cross_entropy;
+    vector<double> logits = {1, 3, -2};
+    vector<double> probabilities(3);
+    SoftmaxCrossEntropy::softmax(logits, probabilities);
+    double exp_sum = exp(1) + exp(3) + exp(-2);
+    for(int i = 0; i < 3; ++i)
+        ASSERT_ALMOST_EQUAL(probabilities[i], exp(logits[i]) / exp_sum, 0.000000000000001);
+    ASSERT_ALMOST_EQUAL(softmax_cross_entropy.loss(logits, expected), -log(probabilities[1]), 0.000000000000001);
+    softmax_cross_entropy.gradient(logits, expected, gradient);
+    for(int i = 0; i < 3; ++i)
+        ASSERT_ALMOST_EQUAL(gradient[i], probabilities[i] - expected[i], 0.000000000000001);
+
+    // Logits far too large for exp on their own
+    vector<double> large_logits = {1000, 1002, 990};
+    double large_loss = softmax_cross_entropy.loss(large_logits, expected);
+    ASSERT_TRUE(std::isfinite(large_loss));
+    ASSERT_ALMOST_EQUAL(large_loss, softmax_cross_entropy.loss(vector<double>{-2, 0, -12}, expected), 0.000000000001);
+    softmax_cross_entropy.gradient(large_logits, expected, gradient);
+    for(int i = 0; i < 3; ++i)
+        ASSERT_TRUE(std::isfinite(gradient[i]));
+}
+
+TEST(train_batch_matches_train_on_example_for_every_loss){
+    std::vector<int> neuron_counts = {3, 5, 3};
+    Matrix inputs(6, 3);
+    Matrix expected(6, 3);
+    for(int e = 0; e < 6; ++e){
+        for(int i = 0; i < 3; ++i)
+            inputs(e, i) = (e + 1) * 0.1 - i * 0.2;
+        expected(e, e % 3) = 1;
+    }
+
+    BinaryCrossEntropy binary_cross_entropy;
+    SoftmaxCrossEntropy softmax_cross_entropy;
+    Linear identity(1);
+
+    for(const LossFunction *loss : {(const LossFunction *)&binary_cross_entropy, (const LossFunction *)&softmax_cross_entropy}){
+        NeuralNetworkFF net(3, neuron_counts);
+        net.set_loss_function(loss);
+        if(loss == &softmax_cross_entropy)
+            net.set_activation_function(2, &identity);
+        NeuralNetworkFF batch_net(net);
+
+        for(int e = 0; e < 6; ++e){
+            std::vector< double > input(inputs.row(e), inputs.row(e) + 3);
+            std::vector< double > output(expected.row(e), expected.row(e) + 3);
+            net.train_on_example(input, output);
+        }
+        batch_net.trainBatch(inputs, expected);
+
+        for(int i = 0; i < net.gradient_sums.size(); ++i)
+            ASSERT_ALMOST_EQUAL(batch_net.gradient_sums[i], net.gradient_sums[i], 0.000000000001);
+    }
+}
+
+TEST(gradients_are_summed_and_scaled_at_the_update){
+    std::vector<int> neuron_counts = {3, 4, 2};
+    NeuralNetworkFF net(3, neuron_counts);
+    vector<double> input = {0.5, -0.25, 1};
+    vector<double> expected = {1, 0};
+
+    NeuralNetworkFF once(net);
+    once.train_on_example(input, expected);
+
+    NeuralNetworkFF three_times(net);
+    for(int i = 0; i < 3; ++i)
+        three_times.train_on_example(input, expected);
+
+    // Sums, not averages, until the update
+    for(int i = 0; i < net.gradient_sums.size(); ++i)
+        ASSERT_ALMOST_EQUAL(three_times.gradient_sums[i], 3 * once.gradient_sums[i], 0.000000000000001);
+
+    // Keeping the gradients through an optimizer update leaves the sums exactly as they were
+    vector<double> sums = three_times.gradient_sums;
+    NeuralNetworkFF kept(three_times);
+    Adam adam;
+    kept.update_weights(adam, 0.1, false);
+    ASSERT_EQUAL(kept.num_examples, 3);
+    for(int i = 0; i < sums.size(); ++i)
+        ASSERT_EQUAL(kept.gradient_sums[i], sums[i]);
+
+    // The update uses the average, which is the same as the gradient of the one example
+    once.update_weights(0.5, true);
+    three_times.update_weights(0.5, true);
+    for(int i = 0; i < net.parameters.size(); ++i)
+        ASSERT_ALMOST_EQUAL(three_times.parameters[i], once.parameters[i], 0.000000000000001);
+    ASSERT_EQUAL(three_times.num_examples, 0);
+}
+
+TEST(parallel_train_batch_matches_train_batch){
+    int num_layers = 4;
+    std::vector<int> neuron_counts = {7, 9, 5, 3};
+    NeuralNetworkFF net(num_layers, neuron_counts);
+
+    Matrix inputs(21, 7);
+    Matrix expected(21, 3);
+    for(int e = 0; e < 21; ++e){
+        for(int i = 0; i < 7; ++i)
+            inputs(e, i) = sin(e * 7 + i);
+        expected(e, e % 3) = 1;
+    }
+
+    // Two batches, so the second one is folded into existing averages
+    NeuralNetworkFF batch_net(net);
+    batch_net.trainBatch(inputs, expected);
+    batch_net.trainBatch(inputs, expected);
+
+    // Includes more threads than the 2 examples in the last shard and more threads than examples
+    for(int num_threads : {1, 2, 3, 4, 7, 32}){
+        ParallelTrainer trainer(num_threads);
+        NeuralNetworkFF parallel_net(net);
+        trainer.trainBatch(parallel_net, inputs, expected);
+        trainer.trainBatch(parallel_net, inputs, expected);
+
+        ASSERT_EQUAL(parallel_net.num_examples, 42);
+        for(int i = 0; i < net.gradient_sums.size(); ++i)
+            ASSERT_ALMOST_EQUAL(parallel_net.gradient_sums[i], batch_net.gradient_sums[i], 0.000000000001);
+
+        // The same number of threads always gives exactly the same result
+        NeuralNetworkFF repeat_net(net);
+        trainer.trainBatch(repeat_net, inputs, expected);
+        trainer.trainBatch(repeat_net, inputs, expected);
+        for(int i = 0; i < net.gradient_sums.size(); ++i)
+            ASSERT_EQUAL(repeat_net.gradient_sums[i], parallel_net.gradient_sums[i]);
+    }
+}
+
+/**
+ * @brief The sum of squared errors of a network over some examples
+ *
+ */
+double squared_error(const NeuralNetworkFF &net, const vector<vector<double>> &inputs, const vector<vector<double>> &expected){
+    double error = 0;
+    for(int e = 0; e < inputs.size(); ++e){
+        vector<double> output = net.forwardPass(inputs[e]);
+        for(int i = 0; i < output.size(); ++i)
+            error += (output[i] - expected[e][i]) * (output[i] - expected[e][i]);
+    }
+    return error;
+}
+
+TEST(train_uses_the_configured_optimizer){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {2, 3, 1};
+    std::vector<std::vector<std::vector< double >>> weights = {{}, {{0.3, -0.2}, {-0.4, 0.5}, {0.1, 0.2}}, {{0.3, -0.6, 0.2}}};
+    std::vector< std::vector< double >> bias = {{}, {0.1, -0.1, 0.05}, {0.2}};
+    NeuralNetworkFF initial(num_layers, neuron_counts, weights, bias);
+
+    // XOR, repeated for a number of epochs
+    vector<vector<double>> inputs, expected;
+    for(int epoch = 0; epoch < 300; ++epoch){
+        inputs.insert(inputs.end(), {{0, 0}, {0, 1}, {1, 0}, {1, 1}});
+        expected.insert(expected.end(), {{0}, {1}, {1}, {0}});
+    }
+
+    ConstantLearningFunction rate(0.05);
+    NeuralNetworkFF::TrainConfig config;
+    config.batch_size = 4;
+    config.learning_function = &rate;
+
+    NeuralNetworkFF sgd_net(initial);
+    sgd_net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &config);
+
+    // Momentum with no momentum is plain SGD
+    Momentum no_momentum(0);
+    config.optimizer = &no_momentum;
+    NeuralNetworkFF no_momentum_net(initial);
+    no_momentum_net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &config);
+    for(int i = 0; i < sgd_net.parameters.size(); ++i)
+        ASSERT_EQUAL(no_momentum_net.parameters[i], sgd_net.parameters[i]);
+
+    double initial_error = squared_error(initial, inputs, expected);
+    double sgd_error = squared_error(sgd_net, inputs, expected);
+    ASSERT_TRUE(sgd_error < initial_error);
+
+    // The adaptive and momentum methods get further than SGD in the same number of steps
+    Momentum momentum;
+    Nesterov nesterov;
+    Adam adam;
+    RMSProp rmsprop;
+    for(Optimizer *optimizer : std::vector<Optimizer *>{&momentum, &nesterov, &adam, &rmsprop}){
+        config.optimizer = optimizer;
+        NeuralNetworkFF net(initial);
+        net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &config);
+        ASSERT_TRUE(squared_error(net, inputs, expected) < sgd_error);
+    }
+}
+
+TEST(float_network_trains_like_double){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {2, 3, 1};
+    std::vector<std::vector<std::vector< double >>> weights = {{}, {{0.3, -0.2}, {-0.4, 0.5}, {0.1, 0.2}}, {{0.3, -0.6, 0.2}}};
+    std::vector< std::vector< double >> bias = {{}, {0.1, -0.1, 0.05}, {0.2}};
+    std::vector<std::vector<std::vector< float >>> float_weights = {{}, {{0.3f, -0.2f}, {-0.4f, 0.5f}, {0.1f, 0.2f}}, {{0.3f, -0.6f, 0.2f}}};
+    std::vector< std::vector< float >> float_bias = {{}, {0.1f, -0.1f, 0.05f}, {0.2f}};
+
+    vector<vector<double>> inputs, expected;
+    for(int epoch = 0; epoch < 300; ++epoch){
+        inputs.insert(inputs.end(), {{0, 0}, {0, 1}, {1, 0}, {1, 1}});
+        expected.insert(expected.end(), {{0}, {1}, {1}, {0}});
+    }
+
+    // Training on double examples, one at a time and in batches, on one thread and on several
+    ConstantLearningFunction rate(0.05);
+    for(int batch_size : {1, 4}){
+        for(int num_threads : {1, 3}){
+            Adam adam;
+            NeuralNetworkFF::TrainConfig config;
+            config.batch_size = batch_size;
+            config.num_threads = num_threads;
+            config.learning_function = &rate;
+            config.optimizer = &adam;
+            NeuralNetworkFF net(num_layers, neuron_counts, weights, bias);
+            net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &config);
+
+            BasicAdam<float> float_adam;
+            NeuralNetworkFF32::TrainConfig float_config;
+            float_config.batch_size = batch_size;
+            float_config.num_threads = num_threads;
+            float_config.learning_function = &rate;
+            float_config.optimizer = &float_adam;
+            NeuralNetworkFF32 float_net(num_layers, neuron_counts, float_weights, float_bias);
+            float_net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &float_config);
+
+            for(int i = 0; i < net.parameters.size(); ++i)
+                ASSERT_ALMOST_EQUAL(float_net.parameters[i], net.parameters[i], 0.001);
+        }
+    }
+
+    // Float examples train a float network without any conversion
+    vector<vector<float>> float_inputs, float_expected;
+    for(int e = 0; e < 4; ++e){
+        float_inputs.emplace_back(inputs[e].begin(), inputs[e].end());
+        float_expected.emplace_back(expected[e].begin(), expected[e].end());
+    }
+    NeuralNetworkFF32 float_net(num_layers, neuron_counts, float_weights, float_bias);
+    NeuralNetworkFF32 initial(float_net);
+    NeuralNetworkFF32::TrainConfig float_config;
+    float_config.learning_function = &rate;
+    float_config.epochs = 100;
+    float_net.train(float_inputs.begin(), float_inputs.end(), float_expected.begin(), float_expected.end(), &float_config);
+
+    float initial_error = 0, error = 0;
+    for(int e = 0; e < 4; ++e){
+        float initial_output = initial.forwardPass(float_inputs[e])[0];
+        float output = float_net.forwardPass(float_inputs[e])[0];
+        initial_error += (initial_output - float_expected[e][0]) * (initial_output - float_expected[e][0]);
+        error += (output - float_expected[e][0]) * (output - float_expected[e][0]);
+    }
+    ASSERT_TRUE(error < initial_error);
+}
+
+/**
+ * @brief The learning rate a function gives at a step and epoch
+ *
+ */
+double rate_at(LearningRateFunctionBase &function, long step, int epoch = 0, double loss = NAN){
+    LearningRateContext context;
+    context.step = step;
+    context.epoch = epoch;
+    context.loss = loss;
+    return function.get_learning_rate(context);
+}
+
+/**
+ * @brief Whether constructing something throws std::invalid_argument
+ *
+ */
+template <typename Construct>
+bool rejects(Construct construct){
+    try{
+        construct();
+    }
+    catch(const std::invalid_argument &){
+        return true;
+    }
+    return false;
+}
+
+TEST(learning_rate_schedules){
+    StepDecayLearningFunction step_decay(0.1, 0.5, 3);
+    ASSERT_ALMOST_EQUAL(rate_at(step_decay, 100, 2), 0.1, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(step_decay, 100, 3), 0.05, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(step_decay, 100, 7), 0.025, 1e-15);
+
+    ExponentialDecayLearningFunction exponential(0.1, 0.5, 10);
+    ASSERT_ALMOST_EQUAL(rate_at(exponential, 0), 0.1, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(exponential, 5), 0.1 / sqrt(2), 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(exponential, 20), 0.025, 1e-15);
+
+    // Periods of 10, 20 and 40 steps
+    CosineAnnealingLearningFunction cosine(1, 0.1, 10, 2);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine, 0), 1, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine, 5), 0.55, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine, 10), 1, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine, 20), 0.55, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine, 30), 1, 1e-15);
+
+    CosineAnnealingLearningFunction cosine_fixed(1, 0, 4);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine_fixed, 2), 0.5, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(cosine_fixed, 6), 0.5, 1e-15);
+
+    ConstantLearningFunction constant(0.2);
+    WarmupLearningFunction warmup(constant, 4);
+    ASSERT_ALMOST_EQUAL(rate_at(warmup, 0), 0.05, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(warmup, 3), 0.2, 1e-15);
+    ASSERT_ALMOST_EQUAL(rate_at(warmup, 50), 0.2, 1e-15);
+
+    // Two epochs without improvement drop the rate, repeated steps in an epoch count once
+    ReduceOnPlateauLearningFunction plateau(1, 0.5, 2, 0.01);
+    ASSERT_EQUAL(rate_at(plateau, 0), 1.0);
+    ASSERT_EQUAL(rate_at(plateau, 1, 1, 10), 1.0);
+    ASSERT_EQUAL(rate_at(plateau, 2, 2, 9), 1.0);
+    ASSERT_EQUAL(rate_at(plateau, 3, 3, 8.95), 1.0);
+    ASSERT_EQUAL(rate_at(plateau, 4, 3, 8.95), 1.0);
+    ASSERT_EQUAL(rate_at(plateau, 5, 4, 9.5), 0.5);
+    ASSERT_EQUAL(rate_at(plateau, 6, 4, 9.5), 0.5);
+    ASSERT_EQUAL(rate_at(plateau, 7, 5, 5), 0.5);
+
+    // Periods that are not positive, or that shrink
+    ASSERT_TRUE(rejects([]{ StepDecayLearningFunction(0.1, 0.5, 0); }));
+    ASSERT_TRUE(rejects([]{ StepDecayLearningFunction(0.1, 0.5, -3); }));
+    ASSERT_TRUE(rejects([]{ ExponentialDecayLearningFunction(0.1, 0.5, 0); }));
+    ASSERT_TRUE(rejects([]{ ExponentialDecayLearningFunction(0.1, 0.5, -10); }));
+    ASSERT_TRUE(rejects([]{ CosineAnnealingLearningFunction(1, 0.1, 0); }));
+    ASSERT_TRUE(rejects([]{ CosineAnnealingLearningFunction(1, 0.1, -10); }));
+    ASSERT_TRUE(rejects([]{ CosineAnnealingLearningFunction(1, 0.1, 10, 0.5); }));
+    ASSERT_TRUE(rejects([]{ CosineAnnealingLearningFunction(1, 0.1, 10, NAN); }));
+
+    ASSERT_FALSE(rejects([]{ StepDecayLearningFunction(0.1, 0.5, 1); }));
+    ASSERT_FALSE(rejects([]{ ExponentialDecayLearningFunction(0.1, 0.5); }));
+    ASSERT_FALSE(rejects([]{ CosineAnnealingLearningFunction(1, 0.1, 1, 1); }));
+}
+
+/**
+ * @brief Remembers the context of every call, and returns a constant rate
+ *
+ */
+class RecordingLearningFunction : public LearningRateFunctionBase{
+public:
+    double get_learning_rate(const LearningRateContext &context) override{
+        contexts.push_back(context);
+        return 0.1;
+    }
+
+    vector<LearningRateContext> contexts;
+};
+
+TEST(train_reports_progress_to_the_learning_function){
+    std::vector<int> neuron_counts = {2, 3, 1};
+    NeuralNetworkFF net(3, neuron_counts);
+
+    vector<vector<double>> inputs = {{0, 0}, {0, 1}, {1, 0}, {1, 1}, {0.5, 0.5}};
+    vector<vector<double>> expected = {{0}, {1}, {1}, {0}, {0.5}};
+
+    RecordingLearningFunction recorder;
+    NeuralNetworkFF::TrainConfig config;
+    config.batch_size = 2;
+    config.epochs = 3;
+    config.learning_function = &recorder;
+
+    int validations = 0;
+    config.validation_loss = [&](const NeuralNetworkFF &trained){
+        ASSERT_TRUE(&trained == &net);
+        return 10.0 - validations++;
+    };
+
+    net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &config);
+
+    // Two full batches in each of the three epochs
+    ASSERT_EQUAL(recorder.contexts.size(), 6ul);
+    for(int i = 0; i < 6; ++i){
+        ASSERT_EQUAL(recorder.contexts[i].step, (long)i);
+        ASSERT_EQUAL(recorder.contexts[i].epoch, i / 2);
+    }
+    ASSERT_TRUE(std::isnan(recorder.contexts[0].loss));
+    ASSERT_EQUAL(recorder.contexts[2].loss, 10.0);
+    ASSERT_EQUAL(recorder.contexts[4].loss, 9.0);
+
+    ASSERT_EQUAL(validations, 3);
+    ASSERT_EQUAL(config.progress.step, 6l);
+    ASSERT_EQUAL(config.progress.epoch, 3);
+    ASSERT_EQUAL(config.progress.loss, 8.0);
+
+    // Training again with the same config carries on where it left off
+    config.epochs = 1;
+    net.train(inputs.begin(), inputs.end(), expected.begin(), expected.end(), &config);
+    ASSERT_EQUAL(recorder.contexts.back().step, 7l);
+    ASSERT_EQUAL(recorder.contexts.back().epoch, 3);
+    ASSERT_EQUAL(config.progress.epoch, 4);
+}
+
 TEST_MAIN()
\ No newline at end of file
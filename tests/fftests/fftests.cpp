@@ -19,6 +19,11 @@
 #include "../../include/ff/ff.h"
 #include <vector> 
 #include <cmath> 
+#include <cstdio> 
+#include <sstream> 
+#include <thread> 
+#include <stdexcept> 
+#include <utility> 
 
 double sigmoid(double x){
     return 1 / (1 + exp(-x)); 
@@ -155,4 +160,311 @@ TEST(mega_net){
 
 }
 
+TEST(forward_batch){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {5, 7, 3};
+    NeuralNetworkFF net(num_layers, neuron_counts);
+
+    Matrix inputs(6, 5);
+    for(int e = 0; e < 6; ++e){
+        for(int i = 0; i < 5; ++i){
+            inputs(e, i) = sin(e * 5 + i);
+        }
+    }
+
+    Matrix outputs = net.forwardBatch(inputs);
+    ASSERT_EQUAL(outputs.rows, 6);
+    ASSERT_EQUAL(outputs.cols, 3);
+
+    for(int e = 0; e < 6; ++e){
+        std::vector<double> input(inputs.row(e), inputs.row(e) + 5);
+        std::vector<double> output = net.forwardPass(input);
+
+        for(int i = 0; i < 3; ++i){
+            ASSERT_ALMOST_EQUAL(outputs(e, i), output[i], 0.000000000001);
+        }
+    }
+}
+
+TEST(mixed_activation_functions){
+    // Neuron 1 of the hidden layer is linear, so that layer falls back to applying each neuron's own function
+    std::stringstream ss(
+        "def layer\nneurons 2\nend layer\n"
+        "def layer\nneurons 3\n"
+        "neuron 0 weights 0.5 -1\nneuron 0 bias 0.25\n"
+        "neuron 1 weights 2 1\nneuron 1 bias -1\nneuron 1 activation linear 3\n"
+        "neuron 2 weights -0.5 0.5\nneuron 2 bias 0\n"
+        "end layer\n"
+        "def layer\nneurons 1\nneuron 0 weights 1 0.1 -1\nneuron 0 bias 0.5\nend layer\n");
+    NeuralNetworkFF net(ss);
+
+    std::vector<double> input = {0.3, -0.7};
+    double hidden[3] = {sigmoid(0.5 * 0.3 + 0.7 + 0.25), 3 * (2 * 0.3 - 0.7 - 1), sigmoid(-0.5 * 0.3 - 0.35)};
+    double expected = sigmoid(hidden[0] + 0.1 * hidden[1] - hidden[2] + 0.5);
+
+    ASSERT_ALMOST_EQUAL(net.forwardPass(input)[0], expected, 0.000000000001);
+
+    Matrix inputs(3, 2);
+    for(int e = 0; e < 3; ++e){
+        inputs(e, 0) = input[0];
+        inputs(e, 1) = input[1];
+    }
+    Matrix outputs = net.forwardBatch(inputs);
+    for(int e = 0; e < 3; ++e){
+        ASSERT_ALMOST_EQUAL(outputs(e, 0), expected, 0.000000000001);
+    }
+}
+
+TEST(concurrent_inference_on_shared_network){
+    int num_layers = 4;
+    std::vector<int> neuron_counts = {20, 30, 15, 4};
+    const NeuralNetworkFF net(num_layers, neuron_counts);
+
+    std::vector<std::vector<double>> inputs(64, std::vector<double>(20));
+    std::vector<std::vector<double>> expected(64);
+    Matrix batch(64, 20);
+    for(int e = 0; e < 64; ++e){
+        for(int i = 0; i < 20; ++i){
+            inputs[e][i] = batch(e, i) = sin(e * 20 + i);
+        }
+        expected[e] = net.forwardPass(inputs[e]);
+    }
+
+    // Every thread runs the whole set through the shared network with each of the entry points
+    std::vector<int> mismatches(8, 0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; ++t){
+        threads.emplace_back([&, t](){
+            InferenceWorkspace workspace;
+            std::vector<double> output;
+            for(int round = 0; round < 50; ++round){
+                for(int e = 0; e < 64; ++e){
+                    net.forwardPass(inputs[e], output, workspace);
+                    mismatches[t] += output != expected[e];
+                    net.forwardPass(inputs[e], output);
+                    mismatches[t] += output != expected[e];
+                }
+
+                Matrix outputs = net.forwardBatch(batch);
+                for(int e = 0; e < 64; ++e){
+                    for(int i = 0; i < 4; ++i){
+                        mismatches[t] += std::abs(outputs(e, i) - expected[e][i]) > 0.000000000001;
+                    }
+                }
+            }
+        });
+    }
+
+    for(auto & thread : threads){
+        thread.join();
+    }
+
+    for(int t = 0; t < 8; ++t){
+        ASSERT_EQUAL(mismatches[t], 0);
+    }
+}
+
+TEST(move_and_clone){
+    static SoftmaxCrossEntropy cross_entropy;
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {4, 6, 2};
+    NeuralNetworkFF net(num_layers, neuron_counts);
+    net.set_loss_function(&cross_entropy);
+
+    std::vector<double> input = {0.1, -0.4, 0.8, 0.3};
+    std::vector<double> expected = {1, 0};
+    std::vector<double> output = net.forwardPass(input);
+    net.train_on_example(input, expected);
+
+    // The clone starts without the example that was trained on, so one example trains it to the same place
+    NeuralNetworkFF clone = net.clone();
+    ASSERT_TRUE(clone.forwardPass(input) == output);
+    ASSERT_TRUE(&clone.get_loss_function() == &cross_entropy);
+    ASSERT_TRUE(clone.get_parameters().data() != net.get_parameters().data());
+    clone.train_on_example(input, expected);
+
+    // The moved network keeps the buffers, and the layers still point at them
+    const double *parameters = net.get_parameters().data();
+    NeuralNetworkFF moved(std::move(net));
+    ASSERT_TRUE(moved.get_parameters().data() == parameters);
+    ASSERT_TRUE(moved.forwardPass(input) == output);
+
+    NeuralNetworkFF assigned(num_layers, neuron_counts);
+    assigned = std::move(moved);
+    ASSERT_TRUE(assigned.get_parameters().data() == parameters);
+
+    assigned.update_weights(0.5);
+    clone.update_weights(0.5);
+    ASSERT_TRUE(assigned.forwardPass(input) == clone.forwardPass(input));
+    ASSERT_FALSE(assigned.forwardPass(input) == output);
+}
+
+TEST(copy_parameters_from){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {4, 6, 2};
+    NeuralNetworkFF source(num_layers, neuron_counts);
+    NeuralNetworkFF net(num_layers, neuron_counts);
+
+    std::vector<double> input = {0.1, -0.4, 0.8, 0.3};
+    const double *parameters = net.get_parameters().data();
+    net.copy_parameters_from(source);
+    ASSERT_TRUE(net.get_parameters().data() == parameters);
+    ASSERT_TRUE(net.forwardPass(input) == source.forwardPass(input));
+
+    std::vector<int> other_counts = {4, 5, 2};
+    NeuralNetworkFF other(num_layers, other_counts);
+    bool threw = false;
+    try{
+        net.copy_parameters_from(other);
+    }catch(const std::invalid_argument &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST(evolution_trainer){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {2, 3, 1};
+    NeuralNetworkFF prototype(num_layers, neuron_counts);
+
+    // The fitness peaks when every parameter is 0.5
+    auto fitness = [](const NeuralNetworkFF &network){
+        double distance = 0;
+        for(double parameter : network.get_parameters()){
+            distance += (parameter - 0.5) * (parameter - 0.5);
+        }
+        return -distance;
+    };
+
+    EvolutionTrainer::Config config;
+    config.population_size = 40;
+    config.mutation_rate = 0.3;
+    config.mutation_size = 0.1;
+    config.seed = 7;
+
+    std::vector<std::vector<double>> best;
+    for(auto crossover : {EvolutionTrainer::Crossover::Uniform, EvolutionTrainer::Crossover::Average, EvolutionTrainer::Crossover::SinglePoint}){
+        for(int num_threads : {1, 4, 4}){
+            config.crossover = crossover;
+            config.num_threads = num_threads;
+            EvolutionTrainer trainer(prototype, config);
+            ASSERT_EQUAL(trainer.num_threads(), num_threads);
+
+            double first = trainer.step(fitness);
+            double last = trainer.evolve(fitness, 60);
+            ASSERT_EQUAL(trainer.generation(), 61);
+            ASSERT_TRUE(last > first);
+            ASSERT_TRUE(last > -0.1);
+            ASSERT_EQUAL(trainer.best_fitness(), last);
+            ASSERT_EQUAL(fitness(trainer.best()), last);
+
+            Span<const double> parameters = trainer.best().get_parameters();
+            best.emplace_back(parameters.begin(), parameters.end());
+        }
+
+        // The same seed and number of threads evolve the same population
+        ASSERT_TRUE(best[best.size() - 1] == best[best.size() - 2]);
+    }
+
+    config.selection = EvolutionTrainer::Selection::Truncation;
+    config.selection_size = 5;
+    EvolutionTrainer trainer(prototype, config);
+    ASSERT_TRUE(trainer.evolve(fitness, 60) > -0.1);
+
+    // An exception thrown by the fitness reaches the caller
+    bool threw = false;
+    try{
+        trainer.step([](const NeuralNetworkFF &) -> double { throw std::runtime_error("fitness"); });
+    }catch(const std::runtime_error &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_EQUAL(trainer.generation(), 60);
+
+    threw = false;
+    config.elite_count = 41;
+    try{
+        EvolutionTrainer invalid(prototype, config);
+    }catch(const std::invalid_argument &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST(fixed_network){
+    static Tanh tanh_activation;
+    static LeakyReLU leaky_relu(0.1);
+    static Softmax softmax;
+
+    std::vector<int> neuron_counts = {3, 8, 5, 4};
+    NeuralNetworkFF net(4, neuron_counts, 21);
+    for(double &parameter : net.get_parameters())
+        parameter *= 20;
+    net.set_activation_function(1, &tanh_activation);
+    net.set_activation_function(2, &leaky_relu);
+    net.set_activation_function(3, &softmax);
+
+    FixedNetwork<3, 8, 5, 4> fixed(net);
+    static_assert(FixedNetwork<3, 8, 5, 4>::num_parameters == 8 * 4 + 5 * 9 + 4 * 6, "");
+    ASSERT_EQUAL(fixed.get_parameters().size(), net.get_parameters().size());
+
+    FixedNetwork32<3, 8, 5, 4> fixed32(net);
+    for(int e = 0; e < 50; ++e){
+        std::vector<double> input = {sin(e * 1.3), cos(e * 0.7), e * 0.05 - 1};
+        std::vector<double> expected = net.forwardPass(input);
+
+        std::array<double, 4> output = fixed.forwardPass({input[0], input[1], input[2]});
+        std::array<float, 4> output32 = fixed32.forwardPass({(float)input[0], (float)input[1], (float)input[2]});
+        for(int i = 0; i < 4; ++i){
+            ASSERT_ALMOST_EQUAL(output[i], expected[i], 1e-12);
+            ASSERT_ALMOST_EQUAL(output32[i], expected[i], 1e-4);
+        }
+    }
+
+    // Back to a network, and through a model file
+    NeuralNetworkFF converted = fixed.to_network();
+    std::vector<double> input = {0.5, -0.25, 2};
+    ASSERT_TRUE(converted.forwardPass(input) == net.forwardPass(input));
+
+    fixed.save_to_file("fixed_network_test.net");
+    FixedNetwork<3, 8, 5, 4> loaded("fixed_network_test.net");
+    ASSERT_TRUE(loaded.forwardPass({0.5, -0.25, 2}) == fixed.forwardPass({0.5, -0.25, 2}));
+    std::remove("fixed_network_test.net");
+
+    // The float network keeps the activation parameters exactly
+    NeuralNetworkFF converted32 = fixed32.to_network<double>();
+    ASSERT_TRUE(converted32.get_layers()[2].layer_activation->parameter() == 0.1);
+    ASSERT_TRUE(converted32.get_layers()[2].layer_activation == net.get_layers()[2].layer_activation);
+    NeuralNetworkFF32 float_converted = fixed32.to_network();
+    ASSERT_TRUE(float_converted.get_layers()[2].layer_activation->parameter() == 0.1);
+    std::stringstream float_text;
+    float_converted.to_external_repr(float_text);
+    ASSERT_TRUE(float_text.str().find("activation leaky_relu 0.1\n") != std::string::npos);
+
+    // Only networks of the same shape with one built in function per layer can be converted
+    bool threw = false;
+    try{
+        FixedNetwork<3, 8, 4> wrong_shape(net);
+    }catch(const std::invalid_argument &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    std::stringstream ss;
+    net.to_external_repr(ss);
+    std::string text = ss.str();
+    std::string leaky = "neuron 2 activation leaky_relu 0.1";
+    text.replace(text.find(leaky), leaky.size(), "neuron 2 activation relu");
+    std::stringstream mixed_text(text);
+    NeuralNetworkFF mixed(mixed_text);
+
+    threw = false;
+    try{
+        FixedNetwork<3, 8, 5, 4> wrong_activation(mixed);
+    }catch(const std::invalid_argument &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
 TEST_MAIN(); 
\ No newline at end of file
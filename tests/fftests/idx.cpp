@@ -0,0 +1,140 @@
+/**
+ * @file idx.cpp
+ *
+ * @brief Mapping MNIST IDX files
+ * @version 0.1
+ * @date 2022-04-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note To compile:
+ *          g++ tests/fftests/idx.cpp -g3 -o bin/idx_tests
+ *       To run:
+ *          ./bin/idx_tests
+ *
+ */
+
+#include "../unit_test_framework.h"
+#include "../../include/mnist/idx.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *images_file = "idx_test_images";
+static const char *labels_file = "idx_test_labels";
+
+/**
+ * @brief Write an IDX file of unsigned bytes
+ *
+ */
+void write_idx(const std::string &filename, const std::vector<uint32_t> &sizes, const std::vector<uint8_t> &values){
+    std::ofstream file(filename, std::ios::binary);
+    file.put(0).put(0).put(0x08).put((char)sizes.size());
+    for(uint32_t size : sizes)
+        file.put(size >> 24).put(size >> 16).put(size >> 8).put(size);
+    file.write((const char *)values.data(), values.size());
+}
+
+/**
+ * @brief Whether mapping a file as images throws std::runtime_error
+ *
+ */
+bool mapping_throws(const std::string &filename){
+    try{
+        IdxFile file(filename);
+        MnistImages images(file);
+    }catch(const std::runtime_error &){
+        return true;
+    }
+    return false;
+}
+
+TEST(images_are_views_of_the_file){
+    // 3 images of 2 x 4 pixels
+    std::vector<uint8_t> pixels(24);
+    for(int i = 0; i < 24; ++i)
+        pixels[i] = i * 10;
+    write_idx(images_file, {3, 2, 4}, pixels);
+    write_idx(labels_file, {3}, {7, 0, 9});
+
+    IdxFile image_file(images_file);
+    MnistImages images(image_file);
+    ASSERT_EQUAL(image_file.dimensions().size(), 3);
+    ASSERT_EQUAL(images.size(), 3);
+    ASSERT_EQUAL(images.image_rows(), 2);
+    ASSERT_EQUAL(images.image_columns(), 4);
+    ASSERT_EQUAL(images.image_size(), 8);
+
+    // One contiguous matrix, an image per row
+    ASSERT_TRUE(images[1].data() == images.data() + 8);
+    ASSERT_TRUE(images[2].data() == image_file.values().data() + 16);
+    for(int e = 0; e < 3; ++e){
+        ASSERT_EQUAL(images[e].size(), 8);
+        for(int i = 0; i < 8; ++i)
+            ASSERT_EQUAL(images[e][i], pixels[e * 8 + i]);
+    }
+
+    IdxFile label_file(labels_file);
+    ASSERT_EQUAL(label_file.values().size(), 3);
+    ASSERT_EQUAL(label_file.values()[2], 9);
+
+    std::remove(images_file);
+    std::remove(labels_file);
+}
+
+TEST(invalid_files_throw){
+    ASSERT_TRUE(mapping_throws("idx_test_missing"));
+
+    // Not unsigned bytes
+    std::ofstream(images_file, std::ios::binary).write("\0\0\x0d\x01\0\0\0\0", 8);
+    ASSERT_TRUE(mapping_throws(images_file));
+
+    // Fewer values than the sizes say
+    write_idx(images_file, {3, 2, 4}, std::vector<uint8_t>(23));
+    ASSERT_TRUE(mapping_throws(images_file));
+
+    // Sizes whose product overflows
+    write_idx(images_file, {0xffffffff, 0xffffffff, 0xffffffff}, std::vector<uint8_t>(8));
+    ASSERT_TRUE(mapping_throws(images_file));
+
+    // Labels are not images
+    write_idx(labels_file, {3}, {1, 2, 3});
+    ASSERT_TRUE(mapping_throws(labels_file));
+
+    std::remove(images_file);
+    std::remove(labels_file);
+}
+
+TEST(dataset_reads_all_four_files){
+    std::string directory = "idx_test_data";
+    std::filesystem::create_directory(directory);
+    write_idx(directory + "/train-images-idx3-ubyte", {2, 28, 28}, std::vector<uint8_t>(2 * 784, 1));
+    write_idx(directory + "/train-labels-idx1-ubyte", {2}, {4, 5});
+    write_idx(directory + "/t10k-images-idx3-ubyte", {1, 28, 28}, std::vector<uint8_t>(784, 2));
+    write_idx(directory + "/t10k-labels-idx1-ubyte", {1}, {6});
+
+    {
+        MappedMnistDataset dataset(directory);
+        ASSERT_EQUAL(dataset.training_images().size(), 2);
+        ASSERT_EQUAL(dataset.training_labels()[1], 5);
+        ASSERT_EQUAL(dataset.test_images()[0][783], 2);
+        ASSERT_EQUAL(dataset.test_labels().size(), 1);
+    }
+
+    // A label for every image
+    write_idx(directory + "/t10k-labels-idx1-ubyte", {2}, {6, 7});
+    bool threw = false;
+    try{
+        MappedMnistDataset dataset(directory + "/");
+    }catch(const std::runtime_error &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_MAIN()
@@ -0,0 +1,429 @@
+/**
+ * @file kernels.cpp
+ *
+ * @brief Checks every instruction set of the linear algebra kernels against the textbook loops
+ * @version 0.1
+ * @date 2022-04-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note To compile:
+ *          g++ tests/fftests/kernels.cpp -g3 -o bin/kernels_tests
+ *       To run:
+ *          ./bin/kernels_tests
+ *
+ */
+
+#include "../unit_test_framework.h"
+#include "../../include/ff/ff.h"
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+static const kernels::Isa all_isas[] = {kernels::Isa::Scalar, kernels::Isa::AVX2, kernels::Isa::AVX512};
+
+/**
+ * @brief A matrix of rows x cols deterministic values in [-1, 1]
+ *
+ */
+std::vector<double> test_matrix(int rows, int cols, int seed){
+    std::vector<double> values((size_t)rows * cols);
+    for(int i = 0; i < values.size(); ++i){
+        values[i] = sin(seed * 7919 + i * 0.37);
+    }
+    return values;
+}
+
+TEST(gemm_nt_matches_reference){
+    // Shapes chosen to hit the register blocks, the left over rows/columns and the K blocking
+    int shapes[][3] = {{1, 10, 784}, {1, 7, 3}, {4, 4, 8}, {5, 3, 2}, {64, 100, 784}, {7, 13, 300}};
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        for(auto & shape : shapes){
+            int m = shape[0], n = shape[1], k = shape[2];
+            std::vector<double> A = test_matrix(m, k, 1);
+            std::vector<double> B = test_matrix(n, k, 2);
+            std::vector<double> bias = test_matrix(1, n, 3);
+            std::vector<double> C((size_t)m * n);
+
+            kernels::gemm_nt(m, n, k, A.data(), k, B.data(), k, bias.data(), C.data(), n);
+
+            for(int i = 0; i < m; ++i){
+                for(int j = 0; j < n; ++j){
+                    double expected = bias[j];
+                    for(int p = 0; p < k; ++p)
+                        expected += A[i * k + p] * B[j * k + p];
+                    ASSERT_ALMOST_EQUAL(C[i * n + j], expected, 0.000000001);
+                }
+            }
+        }
+    }
+}
+
+TEST(gemm_nn_matches_reference){
+    int shapes[][3] = {{1, 784, 100}, {4, 32, 64}, {5, 37, 3}, {100, 784, 64}, {3, 2, 300}, {6, 9, 1}};
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        for(auto & shape : shapes){
+            int m = shape[0], n = shape[1], k = shape[2];
+
+            // A is stored transposed (k x m) to check the strided access
+            std::vector<double> A = test_matrix(k, m, 4);
+            std::vector<double> B = test_matrix(k, n, 5);
+            std::vector<double> C = test_matrix(m, n, 6);
+            std::vector<double> original = C;
+
+            kernels::gemm_nn(m, n, k, 0.5, A.data(), 1, m, B.data(), n, C.data(), n, true);
+
+            for(int i = 0; i < m; ++i){
+                for(int j = 0; j < n; ++j){
+                    double sum = 0;
+                    for(int p = 0; p < k; ++p)
+                        sum += A[p * m + i] * B[p * n + j];
+                    ASSERT_ALMOST_EQUAL(C[i * n + j], original[i * n + j] + 0.5 * sum, 0.000000001);
+                }
+            }
+        }
+    }
+}
+
+TEST(vector_kernels_match_reference){
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        int n = 37;
+        std::vector<double> x = test_matrix(1, n, 7);
+        std::vector<double> y = test_matrix(1, n, 8);
+        std::vector<double> axpy_result = y;
+        std::vector<double> axpby_result = y;
+
+        kernels::axpy(n, -0.25, x.data(), axpy_result.data());
+        kernels::axpby(n, 0.5, x.data(), 2, axpby_result.data());
+
+        for(int i = 0; i < n; ++i){
+            ASSERT_ALMOST_EQUAL(axpy_result[i], y[i] - 0.25 * x[i], 0.000000000001);
+            ASSERT_ALMOST_EQUAL(axpby_result[i], 0.5 * x[i] + 2 * y[i], 0.000000000001);
+        }
+
+        // gemv_t and ger are gemm_nn in disguise, check the strides line up
+        int rows = 5, cols = 11;
+        std::vector<double> A = test_matrix(rows, cols, 9);
+        std::vector<double> gemv_t_result(cols, 1);
+        kernels::gemv_t(rows, cols, 2, A.data(), x.data(), gemv_t_result.data(), true);
+
+        std::vector<double> ger_result = A;
+        kernels::ger(rows, cols, 3, x.data(), y.data(), ger_result.data());
+
+        for(int j = 0; j < cols; ++j){
+            double sum = 0;
+            for(int i = 0; i < rows; ++i){
+                sum += A[i * cols + j] * x[i];
+                ASSERT_ALMOST_EQUAL(ger_result[i * cols + j], A[i * cols + j] + 3 * x[i] * y[j], 0.000000000001);
+            }
+            ASSERT_ALMOST_EQUAL(gemv_t_result[j], 1 + 2 * sum, 0.000000000001);
+        }
+    }
+}
+
+TEST(exp_and_sigmoid_match_std){
+    // 4099 values so every instruction set also has a partial vector at the end
+    int n = 4099;
+    std::vector<double> x(n);
+    for(int i = 0; i < n; ++i){
+        x[i] = -700 + 1400.0 * i / (n - 1);
+    }
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        std::vector<double> exp_result(n), sigmoid_result = x;
+        kernels::exp(n, x.data(), exp_result.data());
+        kernels::sigmoid(n, sigmoid_result.data(), sigmoid_result.data()); // in place
+
+        for(int i = 0; i < n; ++i){
+            double expected_exp = std::exp(x[i]);
+            double expected_sigmoid = 1 / (1 + std::exp(-x[i]));
+            ASSERT_ALMOST_EQUAL(exp_result[i] / expected_exp, 1, 0.000000000000001);
+            ASSERT_ALMOST_EQUAL(sigmoid_result[i] / expected_sigmoid, 1, 0.000000000000001);
+        }
+
+        // Saturation and NaN
+        double special[4] = {-1000, 1000, NAN, 0};
+        kernels::sigmoid(4, special, special);
+        ASSERT_ALMOST_EQUAL(special[0], 0, 0.000000000000001);
+        ASSERT_EQUAL(special[1], 1);
+        ASSERT_TRUE(std::isnan(special[2]));
+        ASSERT_EQUAL(special[3], 0.5);
+    }
+}
+
+TEST(activation_kernels_match_std){
+    int n = 4099;
+    std::vector<double> x(n);
+    for(int i = 0; i < n; ++i){
+        x[i] = -30 + 60.0 * i / (n - 1);
+    }
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        std::vector<double> relu(n), leaky(n), elu(n), tanh_result(n), gelu = x;
+        kernels::leaky_relu(n, 0, x.data(), relu.data());
+        kernels::leaky_relu(n, 0.1, x.data(), leaky.data());
+        kernels::elu(n, 0.5, x.data(), elu.data());
+        kernels::tanh(n, x.data(), tanh_result.data());
+        kernels::gelu(n, gelu.data(), gelu.data()); // in place
+
+        for(int i = 0; i < n; ++i){
+            double expected_gelu = 0.5 * x[i] * (1 + std::tanh(0.7978845608028654 * (x[i] + 0.044715 * x[i] * x[i] * x[i])));
+            ASSERT_EQUAL(relu[i], x[i] > 0 ? x[i] : 0);
+            ASSERT_EQUAL(leaky[i], x[i] > 0 ? x[i] : 0.1 * x[i]);
+            ASSERT_ALMOST_EQUAL(elu[i], x[i] > 0 ? x[i] : 0.5 * std::expm1(x[i]), 0.000000000000001);
+            ASSERT_ALMOST_EQUAL(tanh_result[i], std::tanh(x[i]), 0.000000000000001);
+            ASSERT_ALMOST_EQUAL(gelu[i], expected_gelu, 0.00000000000001);
+        }
+
+        // Saturation and NaN
+        double special[4] = {-1000, 1000, NAN, 0};
+        double special_result[4];
+        kernels::tanh(4, special, special_result);
+        ASSERT_EQUAL(special_result[0], -1);
+        ASSERT_EQUAL(special_result[1], 1);
+        ASSERT_TRUE(std::isnan(special_result[2]));
+        ASSERT_EQUAL(special_result[3], 0);
+        kernels::gelu(4, special, special_result);
+        ASSERT_ALMOST_EQUAL(special_result[0], 0, 0.000000000000001);
+        ASSERT_EQUAL(special_result[1], 1000);
+        ASSERT_TRUE(std::isnan(special_result[2]));
+        kernels::leaky_relu(4, 0.1, special, special_result);
+        ASSERT_TRUE(std::isnan(special_result[2]));
+        kernels::elu(4, 1, special, special_result);
+        ASSERT_EQUAL(special_result[0], -1);
+        ASSERT_TRUE(std::isnan(special_result[2]));
+    }
+}
+
+TEST(optimizers_match_textbook_updates){
+    // 37 parameters so every instruction set also has a partial vector at the end
+    int n = 37, steps = 3;
+    double rate = 0.01;
+    std::vector<double> initial = test_matrix(1, n, 10);
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        SGD sgd;
+        Momentum momentum(0.8);
+        Nesterov nesterov(0.8);
+        Adam adam(0.9, 0.99, 1e-6);
+        RMSProp rmsprop(0.95, 1e-6);
+
+        std::vector<double> sgd_p = initial, momentum_p = initial, nesterov_p = initial, adam_p = initial, rmsprop_p = initial;
+        std::vector<double> expected_sgd = initial, expected_momentum = initial, expected_nesterov = initial, expected_adam = initial, expected_rmsprop = initial;
+        std::vector<double> velocity(n), nesterov_velocity(n), m(n), v(n), mean_square(n);
+
+        for(int t = 1; t <= steps; ++t){
+            std::vector<double> g = test_matrix(1, n, 10 + t);
+
+            // Every other step is given the sum of 3 copies of the gradient, scaled back down
+            double scale = t % 2 ? 1 : 1.0 / 3;
+            std::vector<double> sums = g;
+            for(double &sum : sums)
+                sum /= scale;
+
+            sgd.step(sgd_p, sums, rate, scale);
+            momentum.step(momentum_p, sums, rate, scale);
+            nesterov.step(nesterov_p, sums, rate, scale);
+            adam.step(adam_p, sums, rate, scale);
+            rmsprop.step(rmsprop_p, sums, rate, scale);
+
+            for(int i = 0; i < n; ++i){
+                expected_sgd[i] -= rate * g[i];
+
+                velocity[i] = 0.8 * velocity[i] + g[i];
+                expected_momentum[i] -= rate * velocity[i];
+
+                nesterov_velocity[i] = 0.8 * nesterov_velocity[i] + g[i];
+                expected_nesterov[i] -= rate * (g[i] + 0.8 * nesterov_velocity[i]);
+
+                m[i] = 0.9 * m[i] + 0.1 * g[i];
+                v[i] = 0.99 * v[i] + 0.01 * g[i] * g[i];
+                double m_hat = m[i] / (1 - pow(0.9, t));
+                double v_hat = v[i] / (1 - pow(0.99, t));
+                expected_adam[i] -= rate * m_hat / (sqrt(v_hat) + 1e-6);
+
+                mean_square[i] = 0.95 * mean_square[i] + 0.05 * g[i] * g[i];
+                expected_rmsprop[i] -= rate * g[i] / (sqrt(mean_square[i]) + 1e-6);
+            }
+        }
+
+        for(int i = 0; i < n; ++i){
+            ASSERT_ALMOST_EQUAL(sgd_p[i], expected_sgd[i], 0.000000000001);
+            ASSERT_ALMOST_EQUAL(momentum_p[i], expected_momentum[i], 0.000000000001);
+            ASSERT_ALMOST_EQUAL(nesterov_p[i], expected_nesterov[i], 0.000000000001);
+            ASSERT_ALMOST_EQUAL(adam_p[i], expected_adam[i], 0.000000000001);
+            ASSERT_ALMOST_EQUAL(rmsprop_p[i], expected_rmsprop[i], 0.000000000001);
+        }
+    }
+}
+
+/**
+ * @brief Run 3 steps of each optimizer update over n parameters at once, and one parameter at a time, which
+ *        puts every parameter in the scalar tail of the SIMD kernels
+ *
+ * @return whether every parameter and its state came out exactly the same both ways
+ */
+template <typename Scalar>
+bool optimizer_updates_match_one_at_a_time(int n){
+    std::vector<double> values = test_matrix(3, n, 40);
+    std::vector<Scalar> gradients(values.begin(), values.end());
+    std::vector<Scalar> initial = gradients;
+    std::reverse(initial.begin(), initial.end());
+
+    for(int kernel = 0; kernel < 4; ++kernel){
+        std::vector<Scalar> together = initial, apart = initial;
+        std::vector<Scalar> state1(3 * n), state2(3 * n), apart_state1(3 * n), apart_state2(3 * n);
+
+        for(int t = 0; t < 3; ++t){
+            const Scalar *g = gradients.data() + t * n;
+            auto update = [&](long count, long offset, Scalar *parameters, Scalar *first, Scalar *second){
+                if(kernel < 2)
+                    kernels::momentum_update(count, (Scalar)0.01, (Scalar)0.9, kernel == 1, (Scalar)(1.0 / 3), g + offset, first + offset, parameters + offset);
+                else if(kernel == 2)
+                    kernels::adam_update(count, (Scalar)0.01, (Scalar)0.9, (Scalar)0.999, (Scalar)1e-8, (Scalar)(1.0 / 3), g + offset, first + offset, second + offset, parameters + offset);
+                else
+                    kernels::rmsprop_update(count, (Scalar)0.01, (Scalar)0.9, (Scalar)1e-8, (Scalar)(1.0 / 3), g + offset, first + offset, parameters + offset);
+            };
+            update(n, 0, together.data(), state1.data(), state2.data());
+            for(int i = 0; i < n; ++i)
+                update(1, i, apart.data(), apart_state1.data(), apart_state2.data());
+        }
+
+        if(together != apart || state1 != apart_state1 || state2 != apart_state2)
+            return false;
+    }
+    return true;
+}
+
+TEST(optimizer_updates_do_not_depend_on_the_vector_width){
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+        ASSERT_TRUE(optimizer_updates_match_one_at_a_time<double>(37));
+        ASSERT_TRUE(optimizer_updates_match_one_at_a_time<float>(37));
+    }
+}
+
+TEST(float_kernels_match_double){
+    // The float kernels have their own vector widths and exp polynomial, so check them against the double ones
+    int m = 7, n = 37, k = 300;
+    std::vector<double> A = test_matrix(m, k, 20), B = test_matrix(n, k, 21), bias = test_matrix(1, n, 22);
+    std::vector<float> A32(A.begin(), A.end()), B32(B.begin(), B.end()), bias32(bias.begin(), bias.end());
+
+    int count = 4099;
+    std::vector<double> x(count);
+    for(int i = 0; i < count; ++i){
+        x[i] = -80 + 160.0 * i / (count - 1);
+    }
+    std::vector<float> x32(x.begin(), x.end());
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        std::vector<float> nt(m * n), nn(m * n), y(n);
+        kernels::gemm_nt(m, n, k, A32.data(), k, B32.data(), k, bias32.data(), nt.data(), n);
+        kernels::gemm_nn(m, n, k, 0.5f, A32.data(), k, 1, B32.data(), n, nn.data(), n, false); // B read as k x n
+        kernels::gemv(n, k, B32.data(), A32.data(), bias32.data(), y.data());
+
+        // The sums reach a few hundred, where a float ulp is about 1e-5
+        for(int i = 0; i < m; ++i){
+            for(int j = 0; j < n; ++j){
+                double expected_nt = bias[j], expected_nn = 0;
+                for(int p = 0; p < k; ++p){
+                    expected_nt += A[i * k + p] * B[j * k + p];
+                    expected_nn += A[i * k + p] * B[p * n + j];
+                }
+                ASSERT_ALMOST_EQUAL(nt[i * n + j], expected_nt, 0.001);
+                ASSERT_ALMOST_EQUAL(nn[i * n + j], 0.5 * expected_nn, 0.001);
+                if(i == 0)
+                    ASSERT_ALMOST_EQUAL(y[j], expected_nt, 0.001);
+            }
+        }
+
+        std::vector<float> exp_result(count), sigmoid_result(count), tanh_result(count), gelu_result(count), elu_result(count);
+        kernels::exp(count, x32.data(), exp_result.data());
+        kernels::sigmoid(count, x32.data(), sigmoid_result.data());
+        kernels::tanh(count, x32.data(), tanh_result.data());
+        kernels::gelu(count, x32.data(), gelu_result.data());
+        kernels::elu(count, 0.5f, x32.data(), elu_result.data());
+
+        for(int i = 0; i < count; ++i){
+            double v = x32[i];
+            double expected_gelu = 0.5 * v * (1 + std::tanh(0.7978845608028654 * (v + 0.044715 * v * v * v)));
+            ASSERT_ALMOST_EQUAL(exp_result[i] / std::exp(v), 1, 0.000001);
+            ASSERT_ALMOST_EQUAL(sigmoid_result[i], 1 / (1 + std::exp(-v)), 0.0000002);
+            ASSERT_ALMOST_EQUAL(tanh_result[i], std::tanh(v), 0.0000003);
+            ASSERT_ALMOST_EQUAL(gelu_result[i], expected_gelu, 0.00001);
+            ASSERT_ALMOST_EQUAL(elu_result[i], v > 0 ? v : 0.5 * std::expm1(v), 0.0000002);
+        }
+
+        // Beyond the float range exp is clamped rather than wrapping the exponent bits
+        float special[4] = {-1000, 1000, NAN, 0};
+        float special_result[4];
+        kernels::sigmoid(4, special, special_result);
+        ASSERT_ALMOST_EQUAL(special_result[0], 0, 0.0000000001);
+        ASSERT_EQUAL(special_result[1], 1);
+        ASSERT_TRUE(std::isnan(special_result[2]));
+        ASSERT_EQUAL(special_result[3], 0.5);
+
+        std::vector<float> parameters(n, 1), first_moment(n), second_moment(n);
+        kernels::adam_update(n, 0.01f, 0.9f, 0.999f, 1e-8f, 1.0f, bias32.data(), first_moment.data(), second_moment.data(), parameters.data());
+        for(int i = 0; i < n; ++i){
+            double m1 = 0.1 * bias32[i], m2 = 0.001 * bias32[i] * bias32[i];
+            ASSERT_ALMOST_EQUAL(parameters[i], 1 - 0.01 * m1 / (std::sqrt(m2) + 1e-8), 0.000001);
+        }
+    }
+}
+
+TEST(gemv_u8s8_matches_reference){
+    // The extremes of both types, where the 16 bit pair sums of the AVX2 version are closest to saturating
+    int shapes[][2] = {{1, 64}, {3, 128}, {4, 64}, {10, 832}, {101, 320}};
+
+    for(auto isa : all_isas){
+        if(!kernels::select(isa))
+            continue;
+
+        for(auto & shape : shapes){
+            int rows = shape[0], cols = shape[1];
+            std::vector<int8_t> A((size_t)rows * cols);
+            std::vector<uint8_t> x(cols);
+            std::vector<int32_t> y(rows);
+            for(size_t i = 0; i < A.size(); ++i)
+                A[i] = i % 5 == 0 ? -127 : i % 7 == 0 ? 127 : (int)(127 * sin(i * 0.37));
+            for(int i = 0; i < cols; ++i)
+                x[i] = i % 3 ? 127 : i % 128;
+
+            kernels::gemv_u8s8(rows, cols, A.data(), x.data(), y.data());
+
+            for(int r = 0; r < rows; ++r){
+                int32_t expected = 0;
+                for(int i = 0; i < cols; ++i)
+                    expected += (int32_t)x[i] * A[(size_t)r * cols + i];
+                ASSERT_EQUAL(y[r], expected);
+            }
+        }
+    }
+}
+
+TEST_MAIN()
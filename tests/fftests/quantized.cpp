@@ -0,0 +1,198 @@
+/**
+ * @file quantized.cpp
+ *
+ * @brief Quantizing networks to 8 bit weights, and saving and reading the quantized networks
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note To compile:
+ *          g++ tests/fftests/quantized.cpp -g3 -pthread -o bin/quantized_tests
+ *       To run:
+ *          ./bin/quantized_tests
+ *
+ */
+
+#include "../unit_test_framework.h"
+#include "../../include/ff/ff.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *model_file = "quantized_test_model";
+
+/**
+ * @brief Deterministic inputs in [-1, 2]
+ *
+ */
+std::vector<std::vector<double>> test_inputs(int count, int size){
+    std::vector<std::vector<double>> inputs(count, std::vector<double>(size));
+    for(int e = 0; e < count; ++e){
+        for(int i = 0; i < size; ++i)
+            inputs[e][i] = 0.5 + 1.5 * sin(e * 131 + i * 0.7);
+    }
+    return inputs;
+}
+
+/**
+ * @brief The index of the largest value
+ *
+ */
+template <typename T>
+int arg_max(const std::vector<T> &values){
+    int best = 0;
+    for(int i = 1; i < values.size(); ++i){
+        if(values[i] > values[best])
+            best = i;
+    }
+    return best;
+}
+
+TEST(quantized_outputs_are_close){
+    static Tanh tanh_activation;
+    static Softmax softmax;
+
+    // Inputs that do not fill a whole row of the kernels, layers of different functions, and a layer
+    // where the neurons use different functions
+    std::vector<int> neuron_counts = {70, 40, 33, 10};
+    NeuralNetworkFF random_net(4, neuron_counts, 11);
+    for(double &parameter : random_net.get_parameters())
+        parameter *= 10;
+    random_net.set_activation_function(1, &tanh_activation);
+    random_net.set_activation_function(3, &softmax);
+
+    std::stringstream ss;
+    random_net.to_external_repr(ss);
+    std::string text = ss.str();
+    size_t layer_2 = text.find("neurons 33\n");
+    for(int i = 0; i < 33; i += 2)
+        text.insert(layer_2 + 11, "neuron " + std::to_string(i) + " activation relu\n");
+    std::stringstream mixed(text);
+    NeuralNetworkFF net(mixed);
+
+    std::vector<std::vector<double>> inputs = test_inputs(300, 70);
+    QuantizedNetworkFF quantized(net, inputs.begin(), inputs.begin() + 100);
+    ASSERT_EQUAL(quantized.input_size(), 70);
+    ASSERT_EQUAL(quantized.output_size(), 10);
+    ASSERT_EQUAL(quantized.get_layers()[0].stride, 128);
+
+    // Including the examples that were not calibrated on
+    int agree = 0;
+    for(auto &input : inputs){
+        std::vector<double> expected = net.forwardPass(input);
+        std::vector<float> output = quantized.forwardPass(input);
+        for(int i = 0; i < 10; ++i)
+            ASSERT_ALMOST_EQUAL(output[i], expected[i], 0.03);
+        agree += arg_max(output) == arg_max(expected);
+    }
+    ASSERT_TRUE(agree >= 294);
+
+    // The inputs can be of any type
+    std::vector<float> output = quantized.forwardPass(inputs[0]);
+    std::vector<float> float_input(inputs[0].begin(), inputs[0].end());
+    ASSERT_TRUE(quantized.forwardPass(float_input) == output);
+
+    bool threw = false;
+    try{
+        QuantizedNetworkFF empty(net, inputs.begin(), inputs.begin());
+    }catch(const std::invalid_argument &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST(quantized_round_trip_is_exact){
+    std::vector<int> neuron_counts = {20, 64, 3};
+    NeuralNetworkFF32 net(3, neuron_counts, 5);
+    for(float &parameter : net.get_parameters())
+        parameter *= 10;
+
+    std::vector<std::vector<double>> inputs = test_inputs(50, 20);
+    QuantizedNetworkFF quantized(net, inputs.begin(), inputs.end());
+    quantized.save(model_file);
+
+    // A quarter of the size of the float parameters, plus the header and the scales
+    std::ifstream file(model_file, std::ios::binary | std::ios::ate);
+    ASSERT_TRUE((size_t)file.tellg() < 64 * 64 + 3 * 64 + 4 * 1024);
+
+    QuantizedNetworkFF loaded(model_file);
+    for(auto &input : inputs)
+        ASSERT_TRUE(loaded.forwardPass(input) == quantized.forwardPass(input));
+
+    // Flip one bit of a weight
+    std::string contents;
+    {
+        std::ifstream infile(model_file, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+    }
+    contents[contents.size() - 200] ^= 1;
+    {
+        std::ofstream outfile(model_file, std::ios::binary);
+        outfile.write(contents.data(), contents.size());
+    }
+
+    bool threw = false;
+    try{
+        QuantizedNetworkFF corrupt(model_file);
+    }catch(const ModelFileError &error){
+        threw = std::string(error.what()).find("checksum") != std::string::npos;
+    }
+    ASSERT_TRUE(threw);
+
+    // A binary model file is not a quantized one
+    net.save_binary(model_file);
+    threw = false;
+    try{
+        QuantizedNetworkFF wrong(model_file);
+    }catch(const ModelFileError &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    std::remove(model_file);
+}
+
+/**
+ * @brief y = 2x, which only the network it is set on knows about
+ *
+ */
+class Double : public ActivationBase{
+public:
+    double operator()(double x){ return compute(x); }
+    double compute(double x){ return 2 * x; }
+    double derivative(double){ return 2; }
+    std::string to_external_repr(){ return "double"; }
+};
+
+TEST(custom_activations_are_used_but_not_saved){
+    static Double doubled;
+    std::vector<int> neuron_counts = {3, 4, 2};
+    NeuralNetworkFF net(3, neuron_counts, 9);
+    net.set_activation_function(2, &doubled);
+
+    std::vector<std::vector<double>> inputs = test_inputs(20, 3);
+    QuantizedNetworkFF quantized(net, inputs.begin(), inputs.end());
+    for(auto &input : inputs){
+        std::vector<double> expected = net.forwardPass(input);
+        std::vector<float> output = quantized.forwardPass(input);
+        for(int i = 0; i < 2; ++i)
+            ASSERT_ALMOST_EQUAL(output[i], expected[i], 0.01);
+    }
+
+    bool threw = false;
+    try{
+        quantized.save(model_file);
+    }catch(const ModelFileError &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    std::remove(model_file);
+}
+
+TEST_MAIN()
@@ -0,0 +1,123 @@
+/**
+ * @file random.cpp
+ *
+ * @brief Checks the random number generator and that seeded networks are reproducible
+ * @version 0.1
+ * @date 2022-04-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note To compile:
+ *          g++ tests/fftests/random.cpp -g3 -pthread -o bin/random_tests
+ *       To run:
+ *          ./bin/random_tests
+ *
+ */
+
+#include "../unit_test_framework.h"
+#include "../../include/ff/ff.h"
+#include <vector>
+#include <cmath>
+#include <thread>
+
+TEST(streams_are_reproducible_and_independent){
+    Xoshiro256 a(42, 3), b(42, 3), other_stream(42, 4), other_seed(43, 3);
+
+    int same_stream = 0, same_seed = 0;
+    for(int i = 0; i < 1000; ++i){
+        uint64_t value = a();
+        ASSERT_EQUAL(value, b());
+        same_stream += value == other_stream();
+        same_seed += value == other_seed();
+    }
+
+    ASSERT_EQUAL(same_stream, 0);
+    ASSERT_EQUAL(same_seed, 0);
+}
+
+TEST(distributions){
+    Xoshiro256 random(7);
+    std::vector<double> values(100001);
+
+    random.fill_uniform(values, -2, 3);
+    double sum = 0;
+    for(double value : values){
+        ASSERT_TRUE(value >= -2 && value < 3);
+        sum += value;
+    }
+    ASSERT_ALMOST_EQUAL(sum / values.size(), 0.5, 0.02);
+
+    // An odd count also checks the value Box-Muller makes on its own
+    random.fill_normal(values, 1, 2);
+    double mean = 0, variance = 0;
+    for(double value : values){
+        mean += value;
+    }
+    mean /= values.size();
+    for(double value : values){
+        variance += (value - mean) * (value - mean);
+    }
+    variance /= values.size();
+    ASSERT_ALMOST_EQUAL(mean, 1, 0.03);
+    ASSERT_ALMOST_EQUAL(variance, 4, 0.1);
+    ASSERT_TRUE(std::isfinite(values.back()));
+
+    std::vector<double> noise(100000, 5);
+    random.add_normal(noise, 0.5);
+    mean = 0;
+    for(double value : noise){
+        mean += value;
+    }
+    ASSERT_ALMOST_EQUAL(mean / noise.size(), 5, 0.01);
+}
+
+TEST(seeded_networks_are_reproducible){
+    int num_layers = 3;
+    std::vector<int> neuron_counts = {30, 20, 5};
+
+    NeuralNetworkFF a(num_layers, neuron_counts, 1234), b(num_layers, neuron_counts, 1234), c(num_layers, neuron_counts, 1235);
+    Span<const double> pa = static_cast<const NeuralNetworkFF &>(a).get_parameters();
+    Span<const double> pb = static_cast<const NeuralNetworkFF &>(b).get_parameters();
+    Span<const double> pc = static_cast<const NeuralNetworkFF &>(c).get_parameters();
+
+    ASSERT_TRUE(std::vector<double>(pa.begin(), pa.end()) == std::vector<double>(pb.begin(), pb.end()));
+    ASSERT_FALSE(std::vector<double>(pa.begin(), pa.end()) == std::vector<double>(pc.begin(), pc.end()));
+
+    // The weights and bias' stay in the ranges the network has always been initialized with
+    for(double parameter : pa){
+        ASSERT_TRUE(std::abs(parameter) < 0.1);
+    }
+
+    // Networks made without a seed are reproducible after seed_random
+    seed_random(99);
+    NeuralNetworkFF d(num_layers, neuron_counts);
+    double first_draw = random_range(0, 1);
+    seed_random(99);
+    NeuralNetworkFF e(num_layers, neuron_counts);
+    ASSERT_EQUAL(random_range(0, 1), first_draw);
+
+    Span<double> pd = d.get_parameters(), pe = e.get_parameters();
+    ASSERT_TRUE(std::vector<double>(pd.begin(), pd.end()) == std::vector<double>(pe.begin(), pe.end()));
+}
+
+TEST(threads_draw_from_different_streams){
+    seed_random(5);
+    std::vector<uint64_t> first(4);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t){
+        threads.emplace_back([&, t](){
+            first[t] = thread_random()();
+        });
+    }
+    for(auto & thread : threads){
+        thread.join();
+    }
+
+    for(int t = 0; t < 4; ++t){
+        for(int u = t + 1; u < 4; ++u){
+            ASSERT_TRUE(first[t] != first[u]);
+        }
+    }
+}
+
+TEST_MAIN();
@@ -0,0 +1,481 @@
+/**
+ * @file serialization.cpp
+ *
+ * @brief Saving networks to files and reading them back
+ * @version 0.1
+ * @date 2022-04-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note To compile:
+ *          g++ tests/fftests/serialization.cpp -g3 -o bin/serialization_tests
+ *       To run:
+ *          ./bin/serialization_tests
+ *
+ */
+
+#include "../unit_test_framework.h"
+#include "../../include/ff/ff.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *model_file = "serialization_test_model";
+
+/**
+ * @brief A 4-6-3 network with random weights where neuron 2 of the hidden layer is linear
+ *
+ */
+NeuralNetworkFF mixed_network(){
+    std::vector<int> neuron_counts = {4, 6, 3};
+    NeuralNetworkFF random_net(3, neuron_counts);
+
+    std::stringstream ss;
+    random_net.to_external_repr(ss);
+    std::string text = ss.str();
+    text.insert(text.find("neuron 2 weights"), "neuron 2 activation linear 0.75\n");
+
+    std::stringstream mixed(text);
+    return NeuralNetworkFF(mixed);
+}
+
+std::vector<double> test_input(int i){
+    return {sin(i), cos(i), sin(2 * i), 0.5};
+}
+
+TEST(binary_round_trip_is_exact){
+    NeuralNetworkFF net = mixed_network();
+    net.save_binary(model_file);
+
+    NeuralNetworkFF loaded(model_file);
+    ASSERT_TRUE(loaded.parameters_are_mapped());
+
+    for(int i = 0; i < 10; ++i){
+        ASSERT_TRUE(loaded.forwardPass(test_input(i)) == net.forwardPass(test_input(i)));
+    }
+
+    std::remove(model_file);
+}
+
+TEST(binary_float32_round_trip){
+    NeuralNetworkFF net = mixed_network();
+    net.save_binary(model_file, BinaryPrecision::Float32);
+
+    std::ifstream file(model_file, std::ios::binary | std::ios::ate);
+    size_t num_parameters = 6 * 4 + 6 + 3 * 6 + 3;
+    ASSERT_TRUE((size_t)file.tellg() < 64 + 128 + num_parameters * sizeof(double));
+
+    NeuralNetworkFF loaded(model_file);
+    ASSERT_FALSE(loaded.parameters_are_mapped());
+
+    for(int i = 0; i < 10; ++i){
+        std::vector<double> expected = net.forwardPass(test_input(i));
+        std::vector<double> output = loaded.forwardPass(test_input(i));
+        for(int j = 0; j < 3; ++j)
+            ASSERT_ALMOST_EQUAL(output[j], expected[j], 0.000001);
+    }
+
+    std::remove(model_file);
+}
+
+TEST(training_a_mapped_network_leaves_the_file_alone){
+    NeuralNetworkFF net = mixed_network();
+    net.save_binary(model_file);
+
+    NeuralNetworkFF trained(model_file);
+    std::vector<double> expected = {1, 0, 0};
+    for(int i = 0; i < 5; ++i)
+        trained.train_on_example(test_input(i), expected);
+    trained.update_weights(1);
+
+    ASSERT_FALSE(trained.forwardPass(test_input(0)) == net.forwardPass(test_input(0)));
+
+    // Copies own their parameters
+    NeuralNetworkFF copy(trained);
+    ASSERT_FALSE(copy.parameters_are_mapped());
+    ASSERT_TRUE(copy.forwardPass(test_input(0)) == trained.forwardPass(test_input(0)));
+
+    NeuralNetworkFF reloaded(model_file);
+    ASSERT_TRUE(reloaded.forwardPass(test_input(0)) == net.forwardPass(test_input(0)));
+
+    std::remove(model_file);
+}
+
+TEST(float_networks_save_and_load){
+    NeuralNetworkFF net = mixed_network();
+    net.save_to_file(model_file);
+    NeuralNetworkFF32 float_net(model_file);
+
+    // A float network computes in float, so its outputs are close to the double network's
+    for(int i = 0; i < 10; ++i){
+        std::vector<double> expected = net.forwardPass(test_input(i));
+        std::vector<double> input = test_input(i);
+        std::vector<float> output = float_net.forwardPass(std::vector<float>(input.begin(), input.end()));
+        for(int j = 0; j < 3; ++j)
+            ASSERT_ALMOST_EQUAL(output[j], expected[j], 0.00001);
+    }
+
+    // Float networks save float32 binary files, which they map in place
+    float_net.save_binary(model_file);
+    NeuralNetworkFF32 mapped(model_file);
+    ASSERT_TRUE(mapped.parameters_are_mapped());
+    Span<const float> saved = static_cast<const NeuralNetworkFF32 &>(float_net).get_parameters();
+    Span<const float> loaded = static_cast<const NeuralNetworkFF32 &>(mapped).get_parameters();
+    ASSERT_TRUE(std::vector<float>(loaded.begin(), loaded.end()) == std::vector<float>(saved.begin(), saved.end()));
+
+    // A double network reads the float file, and a float network reads a float64 file
+    NeuralNetworkFF widened(model_file);
+    ASSERT_FALSE(widened.parameters_are_mapped());
+    Span<const double> widened_parameters = static_cast<const NeuralNetworkFF &>(widened).get_parameters();
+    for(size_t i = 0; i < saved.size(); ++i)
+        ASSERT_EQUAL(widened_parameters[i], (double)saved[i]);
+
+    widened.save_binary(model_file);
+    NeuralNetworkFF32 narrowed(model_file);
+    ASSERT_FALSE(narrowed.parameters_are_mapped());
+    Span<const float> narrowed_parameters = static_cast<const NeuralNetworkFF32 &>(narrowed).get_parameters();
+    ASSERT_TRUE(std::vector<float>(narrowed_parameters.begin(), narrowed_parameters.end()) == std::vector<float>(saved.begin(), saved.end()));
+
+    // Text files written by a float network read back exactly
+    float_net.save_to_file(model_file);
+    NeuralNetworkFF32 reloaded(model_file);
+    std::stringstream original, round_trip;
+    float_net.to_external_repr(original);
+    reloaded.to_external_repr(round_trip);
+    ASSERT_TRUE(original.str() == round_trip.str());
+    Span<const float> reloaded_parameters = static_cast<const NeuralNetworkFF32 &>(reloaded).get_parameters();
+    ASSERT_TRUE(std::vector<float>(reloaded_parameters.begin(), reloaded_parameters.end()) == std::vector<float>(saved.begin(), saved.end()));
+
+    std::remove(model_file);
+}
+
+std::string text_of(const NeuralNetworkFF &net, size_t chunk_size = 0){
+    std::stringstream ss;
+    net.to_external_repr(ss, chunk_size);
+    return ss.str();
+}
+
+TEST(text_round_trip_is_exact){
+    NeuralNetworkFF net = mixed_network();
+    net.save_to_file(model_file);
+
+    NeuralNetworkFF loaded(model_file);
+    for(int i = 0; i < 10; ++i){
+        ASSERT_TRUE(loaded.forwardPass(test_input(i)) == net.forwardPass(test_input(i)));
+    }
+
+    // Values that need all 17 digits, denormals, extremes and negative zero
+    std::vector<int> neuron_counts = {1, 4};
+    std::vector<std::vector<std::vector<double>>> weights = {{}, {{0.1}, {5e-324}, {-1.7976931348623157e308}, {1.0 / 3}}};
+    std::vector<std::vector<double>> bias = {{}, {-0.0, 2.2250738585072014e-308, 123456.789, 2.0 / 3}};
+    NeuralNetworkFF exact(2, neuron_counts, weights, bias);
+    exact.save_to_file(model_file);
+
+    NeuralNetworkFF reloaded(model_file);
+    std::string text = text_of(exact);
+    ASSERT_TRUE(text_of(reloaded) == text);
+    ASSERT_TRUE(text.find("weights 0.1 ") != std::string::npos);
+    ASSERT_TRUE(text.find("bias -0\n") != std::string::npos);
+
+    std::remove(model_file);
+}
+
+TEST(every_activation_round_trips){
+    // One layer for each built in function, with parameters that need every digit
+    std::vector<int> neuron_counts = {4, 5, 5, 5, 5, 5, 5, 5, 3};
+    NeuralNetworkFF net(9, neuron_counts);
+    ReLU relu;
+    LeakyReLU leaky_relu(0.1);
+    ELU elu(1.0 / 3);
+    GELU gelu;
+    Tanh tanh_activation;
+    Linear linear(-0.3);
+    Sigmoid sigmoid;
+    Softmax softmax;
+    std::vector<ActivationBase *> functions = {&relu, &leaky_relu, &elu, &gelu, &tanh_activation, &linear, &sigmoid, &softmax};
+    for(int i = 0; i < functions.size(); ++i)
+        net.set_activation_function(i + 1, functions[i]);
+
+    std::string text = text_of(net);
+    ASSERT_TRUE(text.find("activation relu\n") != std::string::npos);
+    ASSERT_TRUE(text.find("activation leaky_relu 0.1\n") != std::string::npos);
+    ASSERT_TRUE(text.find("activation elu 0.3333333333333333\n") != std::string::npos);
+    ASSERT_TRUE(text.find("activation linear -0.3\n") != std::string::npos);
+    ASSERT_TRUE(text.find("activation softmax\n") != std::string::npos);
+    ASSERT_TRUE(linear.to_external_repr() == "linear -0.3");
+
+    std::stringstream ss(text);
+    NeuralNetworkFF from_text(ss);
+    ASSERT_TRUE(text_of(from_text) == text);
+
+    net.save_binary(model_file);
+    NeuralNetworkFF from_binary(model_file);
+    ASSERT_TRUE(text_of(from_binary) == text);
+
+    for(int i = 0; i < 10; ++i){
+        std::vector<double> output = net.forwardPass(test_input(i));
+        ASSERT_TRUE(from_text.forwardPass(test_input(i)) == output);
+        ASSERT_TRUE(from_binary.forwardPass(test_input(i)) == output);
+        ASSERT_ALMOST_EQUAL(output[0] + output[1] + output[2], 1, 0.000000000000001);
+    }
+
+    std::remove(model_file);
+}
+
+/**
+ * @brief y = 2x, which the text format has no name for
+ *
+ */
+class Double : public ActivationBase{
+public:
+    double operator()(double x){ return compute(x); }
+    double compute(double x){ return 2 * x; }
+    double derivative(double){ return 2; }
+    std::string to_external_repr(){ return "double"; }
+};
+
+TEST(custom_activations_are_not_saved){
+    static Double doubled;
+    std::vector<int> neuron_counts = {3, 4, 2};
+    NeuralNetworkFF net(3, neuron_counts);
+    net.set_activation_function(1, &doubled);
+
+    std::remove(model_file);
+    bool threw = false;
+    try{
+        net.save_to_file(model_file);
+    }catch(const ModelFileError &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    // Nothing is created or written
+    ASSERT_FALSE(std::ifstream(model_file).good());
+    std::stringstream ss;
+    threw = false;
+    try{
+        net.to_external_repr(ss);
+    }catch(const ModelFileError &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_TRUE(ss.str().empty());
+}
+
+TEST(chunked_text_matches_single_write){
+    NeuralNetworkFF net = mixed_network();
+    std::string text = text_of(net);
+
+    for(size_t chunk_size : {1, 7, 64, 1000}){
+        ASSERT_TRUE(text_of(net, chunk_size) == text);
+    }
+
+    net.save_to_file(model_file, 16);
+    std::ifstream file(model_file, std::ios::binary);
+    std::string saved((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_TRUE(saved == text);
+
+    std::remove(model_file);
+}
+
+TEST(text_files_still_load_by_name){
+    std::vector<int> neuron_counts = {4, 6, 3};
+    NeuralNetworkFF net(3, neuron_counts);
+    net.save_to_file(model_file);
+
+    NeuralNetworkFF loaded(model_file);
+    ASSERT_FALSE(loaded.parameters_are_mapped());
+
+    std::vector<double> expected = net.forwardPass(test_input(3));
+    std::vector<double> output = loaded.forwardPass(test_input(3));
+    for(int j = 0; j < 3; ++j)
+        ASSERT_ALMOST_EQUAL(output[j], expected[j], 0.0001);
+
+    std::remove(model_file);
+}
+
+/**
+ * @brief The line number of the ModelFileError thrown when parsing text, or -1 if it parses
+ *
+ */
+int text_error_line(const std::string &text){
+    std::stringstream ss(text);
+    try{
+        NeuralNetworkFF net(ss);
+    }
+    catch(const ModelFileError &error){
+        return error.line();
+    }
+    return -1;
+}
+
+TEST(text_parser_reads_every_form){
+    std::string text =
+        "# a comment\n"
+        "\n"
+        "def layer\r\n"
+        "  neurons 2  # trailing comment\n"
+        "end layer\n"
+        "def layer\n"
+        "\tneurons 2\n"
+        "neuron 0 bias -0.5\n"
+        "neuron 0 weights 1.5 -2e-3\n"
+        "neuron 1 bias 0.25\n"
+        "neuron 1 weight 1 3\n"
+        "neuron 1 activation linear 2\n"
+        "end layer";
+
+    std::stringstream ss(text);
+    NeuralNetworkFF net(ss);
+
+    std::vector<double> output = net.forwardPass({1, 2});
+    ASSERT_ALMOST_EQUAL(output[0], 1 / (1 + exp(-(1.5 - 0.004 - 0.5))), 1e-12);
+    ASSERT_ALMOST_EQUAL(output[1], 2 * (6 + 0.25), 1e-12);
+}
+
+TEST(text_parser_numbers_are_exact){
+    std::vector<std::string> numbers = {"0.1", "-0.0279005", "0.00074843", "123456789012345", "1234567890.12345678",
+                                        "-7.2e-05", "1e+300", "4.9406564584124654e-324", "-0", "3.", ".5"};
+
+    // A linear 1-N network with no bias outputs its weights exactly for an input of 1
+    std::string text = "def layer\nneurons 1\nend layer\ndef layer\nneurons " + std::to_string(numbers.size()) + "\n";
+    for(int i = 0; i < numbers.size(); ++i){
+        text += "neuron " + std::to_string(i) + " weights " + numbers[i] + "\n";
+        text += "neuron " + std::to_string(i) + " activation linear 1\n";
+    }
+    text += "end layer\n";
+
+    std::stringstream ss(text);
+    NeuralNetworkFF net(ss);
+
+    std::vector<double> output = net.forwardPass({1});
+    for(int i = 0; i < numbers.size(); ++i)
+        ASSERT_TRUE(output[i] == strtod(numbers[i].c_str(), nullptr));
+}
+
+TEST(text_parse_errors_report_the_line){
+    std::string header = "def layer\nneurons 2\nend layer\ndef layer\nneurons 2\n";
+
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 weights 1 2\nend layer\n"), -1);
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 weights 1\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 weights 1 2 3\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 bias 1.5x\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "neuron 2 bias 1\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "\n# comment\nneuron 0 activation swish\nend layer\n"), 8);
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 weight 2 1\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "neurons 3\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "def layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header + "nueron 0 bias 1\nend layer\n"), 6);
+    ASSERT_EQUAL(text_error_line(header), 5);
+    ASSERT_EQUAL(text_error_line("def layers\n"), 1);
+    ASSERT_EQUAL(text_error_line("# nothing\n"), 1);
+}
+
+TEST(half_softmax_layers_are_rejected){
+    // The softmax applies to a whole layer, so it is checked once the layer is read
+    std::string header = "def layer\nneurons 2\nend layer\ndef layer\nneurons 2\n";
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 activation softmax\nend layer\n"), 7);
+    ASSERT_EQUAL(text_error_line(header + "neuron 0 activation softmax\nneuron 1 activation softmax\nend layer\n"), -1);
+
+    // Or when a neuron's function is set, which leaves the layer as it was
+    DenseLayer layer;
+    layer.resize(2, 2);
+    Softmax softmax;
+    bool threw = false;
+    try{
+        layer.set_activation_function(0, &softmax);
+    }
+    catch(const std::invalid_argument &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_TRUE(layer.activation_functions[0] == default_activation_function());
+    ASSERT_TRUE(layer.activation_type == ActivationFunctions::Sigmoid);
+}
+
+/**
+ * @brief The contents of a file
+ *
+ */
+std::string read_file(const char *filename){
+    std::ifstream infile(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+}
+
+void write_file(const char *filename, const std::string &contents){
+    std::ofstream outfile(filename, std::ios::binary);
+    outfile.write(contents.data(), contents.size());
+}
+
+/**
+ * @brief Whether loading a model file throws a ModelFileError whose message contains some text
+ *
+ */
+bool loading_fails_with(const char *filename, const std::string &message){
+    try{
+        NeuralNetworkFF net(filename);
+    }
+    catch(const ModelFileError &error){
+        return std::string(error.what()).find(message) != std::string::npos;
+    }
+    return false;
+}
+
+TEST(invalid_files_throw){
+    bool threw = false;
+    try{
+        NeuralNetworkFF net("this file does not exist");
+    }
+    catch(const ModelFileError &){
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    // Flip one bit of a parameter in a binary file
+    mixed_network().save_binary(model_file);
+    std::string contents = read_file(model_file);
+    std::string corrupted = contents;
+    corrupted[corrupted.size() - 3] ^= 1;
+    write_file(model_file, corrupted);
+    ASSERT_TRUE(loading_fails_with(model_file, "checksum"));
+
+    // Point the parameters past the end of the file
+    BinaryHeader header;
+    memcpy(&header, contents.data(), sizeof(BinaryHeader));
+    header.parameter_offset = (header.file_size / BINARY_ALIGNMENT + 2) * BINARY_ALIGNMENT;
+    corrupted = contents;
+    memcpy(&corrupted[0], &header, sizeof(BinaryHeader));
+    write_file(model_file, corrupted);
+    ASSERT_TRUE(loading_fails_with(model_file, "checksum"));
+
+    // The same header with a checksum that matches it
+    header.checksum = binary_file_checksum(corrupted.data(), corrupted.size());
+    memcpy(&corrupted[0], &header, sizeof(BinaryHeader));
+    write_file(model_file, corrupted);
+    ASSERT_TRUE(loading_fails_with(model_file, "parameter offset"));
+
+    // Make the first neuron of the hidden layer a softmax, with a checksum that matches
+    memcpy(&header, contents.data(), sizeof(BinaryHeader));
+    size_t record_offset = sizeof(BinaryHeader) + header.num_layers * sizeof(BinaryLayer);
+    BinaryLayer input_layer;
+    memcpy(&input_layer, contents.data() + sizeof(BinaryHeader), sizeof(BinaryLayer));
+    record_offset += input_layer.activation_count * sizeof(BinaryActivation);
+    corrupted = contents;
+    uint32_t softmax_type = (uint32_t)ActivationFunctions::Softmax;
+    memcpy(&corrupted[record_offset], &softmax_type, sizeof(softmax_type));
+    header.checksum = binary_file_checksum(corrupted.data(), corrupted.size());
+    memcpy(&corrupted[0], &header, sizeof(BinaryHeader));
+    write_file(model_file, corrupted);
+    ASSERT_TRUE(loading_fails_with(model_file, "softmax"));
+
+    std::remove(model_file);
+}
+
+TEST_MAIN()
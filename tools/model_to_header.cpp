@@ -0,0 +1,350 @@
+/**
+ * @file model_to_header.cpp
+ *
+ * @brief Generates a standalone C++ header from a model file. The header holds the weights and bias' as
+ *        constexpr arrays and a predict function specialised on the exact layer sizes, so a trained
+ *        network can be compiled into a program that needs neither this library nor the model file.
+ * @version 0.1
+ * @date 2022-04-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * @note
+ *      to compile:
+ *          g++ tools/model_to_header.cpp -O2 -pthread -o bin/model_to_header
+ *
+ *      to run:
+ *          ./bin/model_to_header examples/MNIST/trained2.net trained2.h [--float] [--namespace name]
+ *
+ *      The generated header needs C++17, and is used as
+ *
+ *          #include "trained2.h"
+ *          double output[trained2::output_size];
+ *          trained2::predict(input, output);
+ */
+
+#include "../include/crank.h"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The number of values written on each line of the weight arrays
+static const int VALUES_PER_LINE = 8;
+
+// The number of partial sums each neuron adds its inputs in, the final sum is written out for 8
+static const int PARTIAL_SUMS = 8;
+
+/**
+ * @brief What to generate
+ *
+ */
+struct Options
+{
+    std::string model;  // The model file to read
+    std::string header; // The header to write
+    std::string name;   // The namespace of the generated code, taken from the header name by default
+    bool single = false; // float instead of double
+};
+
+/**
+ * @brief A C++ identifier from the name of a file, without its directory and extension
+ *
+ */
+std::string identifier_from_path(const std::string &path)
+{
+    std::string name = path.substr(path.find_last_of("/\\") + 1);
+    name = name.substr(0, name.find('.'));
+
+    for (char &c : name)
+        if (!std::isalnum((unsigned char)c))
+            c = '_';
+    if (name.empty() || std::isdigit((unsigned char)name[0]))
+        name = "model_" + name;
+
+    return name;
+}
+
+/**
+ * @brief A floating point literal of the generated type that reads back as exactly the same value
+ *
+ */
+std::string literal(double value, bool single)
+{
+    if (!std::isfinite(value))
+        throw std::invalid_argument("The network has a parameter that is not finite");
+
+    // The shortest text that reads back as the same value
+    char buffer[64];
+    char *end = single ? std::to_chars(buffer, buffer + sizeof(buffer), (float)value).ptr
+                       : std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+
+    std::string text(buffer, end);
+    if (text.find_first_of(".e") == std::string::npos)
+        text += ".0";
+    return single ? text + "f" : text;
+}
+
+/**
+ * @brief The expression that applies a built in activation function to the variable x
+ *
+ * @throws std::invalid_argument for custom functions and softmax, which apply to a whole layer
+ */
+std::string activation_expression(ActivationBase *activation_function, bool single)
+{
+    std::string parameter = literal(activation_function->parameter(), single);
+    switch (activation_function->type())
+    {
+    case ActivationFunctions::Sigmoid:
+        return "1 / (1 + std::exp(-x))";
+    case ActivationFunctions::Linear:
+        return "x * " + parameter;
+    case ActivationFunctions::ReLU:
+        return "x > 0 ? x : 0";
+    case ActivationFunctions::LeakyReLU:
+        return "x > 0 ? x : " + parameter + " * x";
+    case ActivationFunctions::ELU:
+        return "x > 0 ? x : " + parameter + " * std::expm1(x)";
+    case ActivationFunctions::GELU:
+        return literal(0.5, single) + " * x * (1 + std::tanh(" + literal(0.7978845608028654, single) +
+               " * (x + " + literal(0.044715, single) + " * x * x * x)))";
+    case ActivationFunctions::Tanh:
+        return "std::tanh(x)";
+    case ActivationFunctions::Softmax:
+        throw std::invalid_argument("Softmax can only be generated for a whole layer");
+    default:
+        throw std::invalid_argument("Custom activation functions (" + activation_function->to_external_repr() +
+                                    ") can not be generated");
+    }
+}
+
+/**
+ * @brief Write the weights of a layer, outputs x inputs as in the network, then its bias'
+ *
+ */
+void write_parameters(std::ostream &os, int index, const DenseLayer &layer, const std::string &scalar, bool single)
+{
+    std::string name = "layer_" + std::to_string(index);
+
+    os << "alignas(64) inline constexpr " << scalar << " " << name << "_weights[" << layer.outputs << "]["
+       << layer.inputs << "] = {\n";
+    for (int o = 0; o < layer.outputs; ++o)
+    {
+        os << "    {";
+        for (int i = 0; i < layer.inputs; ++i)
+        {
+            if (i)
+                os << (i % VALUES_PER_LINE ? ", " : ",\n     ");
+            os << literal(layer.weights[(size_t)o * layer.inputs + i], single);
+        }
+        os << "},\n";
+    }
+    os << "};\n\n";
+
+    os << "alignas(64) inline constexpr " << scalar << " " << name << "_bias[" << layer.outputs << "] = {";
+    for (int o = 0; o < layer.outputs; ++o)
+    {
+        if (o)
+            os << ",";
+        os << (o % VALUES_PER_LINE ? " " : "\n    ") << literal(layer.bias[o], single);
+    }
+    os << "\n};\n\n";
+}
+
+/**
+ * @brief Write the statements of predict that compute a layer from the previous one. Each neuron sums
+ *        its inputs in PARTIAL_SUMS independent partial sums, a fixed reordering that lets the compiler
+ *        vectorize the sum without -ffast-math, then adds them pairwise.
+ *
+ */
+void write_layer(std::ostream &os, int index, const DenseLayer &layer, const std::string &previous,
+                 const std::string &scalar, bool single)
+{
+    std::string name = "layer_" + std::to_string(index);
+    std::string outputs = std::to_string(layer.outputs);
+    std::string lanes = std::to_string(PARTIAL_SUMS);
+    int full = layer.inputs / PARTIAL_SUMS * PARTIAL_SUMS;
+
+    os << "    // Layer " << index << ": " << layer.inputs << " -> " << layer.outputs;
+    if (layer.layer_activation)
+        os << ", " << layer.layer_activation->to_external_repr();
+    os << "\n";
+
+    os << "    alignas(64) " << scalar << " " << name << "[" << outputs << "];\n"
+       << "    for (int o = 0; o < " << outputs << "; ++o)\n"
+       << "    {\n"
+       << "        const " << scalar << " *weights = " << name << "_weights[o];\n";
+    if (!full)
+    {
+        // Too few inputs to be worth splitting
+        os << "        " << scalar << " sum = " << name << "_bias[o];\n"
+           << "        for (int i = 0; i < " << layer.inputs << "; ++i)\n"
+           << "            sum += weights[i] * " << previous << "[i];\n"
+           << "        " << name << "[o] = sum;\n";
+    }
+    else
+    {
+        os << "        " << scalar << " partial[" << lanes << "] = {};\n"
+           << "        for (int i = 0; i < " << full << "; i += " << lanes << ")\n"
+           << "            for (int k = 0; k < " << lanes << "; ++k)\n"
+           << "                partial[k] += weights[i + k] * " << previous << "[i + k];\n";
+        if (full < layer.inputs)
+        {
+            os << "        for (int i = " << full << "; i < " << layer.inputs << "; ++i)\n"
+               << "            partial[i - " << full << "] += weights[i] * " << previous << "[i];\n";
+        }
+        os << "        " << name << "[o] = " << name << "_bias[o] + (((partial[0] + partial[1]) + (partial[2] + partial[3])) +\n"
+           << "                " << std::string(name.size(), ' ') << "((partial[4] + partial[5]) + (partial[6] + partial[7])));\n";
+    }
+    os << "    }\n";
+
+    if (layer.layer_activation && layer.layer_activation->type() == ActivationFunctions::Softmax)
+    {
+        os << "    {\n"
+           << "        " << scalar << " largest = " << name << "[0];\n"
+           << "        for (int o = 1; o < " << outputs << "; ++o)\n"
+           << "            largest = " << name << "[o] > largest ? " << name << "[o] : largest;\n"
+           << "        double sum = 0;\n"
+           << "        for (int o = 0; o < " << outputs << "; ++o)\n"
+           << "        {\n"
+           << "            " << name << "[o] = std::exp(" << name << "[o] - largest);\n"
+           << "            sum += " << name << "[o];\n"
+           << "        }\n"
+           << "        for (int o = 0; o < " << outputs << "; ++o)\n"
+           << "            " << name << "[o] *= (" << scalar << ")(1 / sum);\n"
+           << "    }\n";
+    }
+    else if (layer.layer_activation)
+    {
+        os << "    for (int o = 0; o < " << outputs << "; ++o)\n"
+           << "    {\n"
+           << "        const " << scalar << " x = " << name << "[o];\n"
+           << "        " << name << "[o] = " << activation_expression(layer.layer_activation, single) << ";\n"
+           << "    }\n";
+    }
+    else
+    {
+        // The neurons use different functions
+        for (int o = 0; o < layer.outputs; ++o)
+        {
+            os << "    {\n"
+               << "        const " << scalar << " x = " << name << "[" << o << "];\n"
+               << "        " << name << "[" << o << "] = " << activation_expression(layer.activation_functions[o], single) << ";\n"
+               << "    }\n";
+        }
+    }
+    os << "\n";
+}
+
+/**
+ * @brief Write the whole header for a network
+ *
+ */
+void write_header(std::ostream &os, const NeuralNetworkFF &network, const Options &options)
+{
+    const std::vector<DenseLayer> &layers = network.get_layers();
+    std::string scalar = options.single ? "float" : "double";
+    std::string guard = options.name + "_H";
+    for (char &c : guard)
+        c = std::toupper((unsigned char)c);
+
+    os << "/**\n"
+       << " * @file " << options.header.substr(options.header.find_last_of("/\\") + 1) << "\n"
+       << " *\n"
+       << " * @brief The network in " << options.model << ", generated by tools/model_to_header.cpp. Do not edit.\n"
+       << " *        Topology";
+    for (const DenseLayer &layer : layers)
+        os << " " << layer.outputs;
+    os << ", " << scalar << " precision.\n"
+       << " *\n"
+       << " */\n\n"
+       << "#ifndef " << guard << "\n"
+       << "#define " << guard << "\n\n"
+       << "#include <cmath>\n\n"
+       << "namespace " << options.name << "\n"
+       << "{\n\n"
+       << "inline constexpr int input_size = " << layers.front().outputs << ";\n"
+       << "inline constexpr int output_size = " << layers.back().outputs << ";\n\n";
+
+    for (int l = 1; l < layers.size(); ++l)
+        write_parameters(os, l, layers[l], scalar, options.single);
+
+    os << "/**\n"
+       << " * @brief Compute the output of the network. Does not allocate, and is safe to call from any thread.\n"
+       << " *\n"
+       << " * @param input - input_size values\n"
+       << " * @param output - where the output_size values of the output layer are written\n"
+       << " */\n"
+       << "inline void predict(const " << scalar << " *input, " << scalar << " *output)\n"
+       << "{\n";
+
+    std::string previous = "input";
+    for (int l = 1; l < layers.size(); ++l)
+    {
+        write_layer(os, l, layers[l], previous, scalar, options.single);
+        previous = "layer_" + std::to_string(l);
+    }
+
+    os << "    for (int o = 0; o < output_size; ++o)\n"
+       << "        output[o] = " << previous << "[o];\n"
+       << "}\n\n"
+       << "} // namespace " << options.name << "\n\n"
+       << "#endif\n";
+}
+
+void usage()
+{
+    std::cerr << "usage: model_to_header <model file> <output header> [--float] [--namespace name]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    std::vector<std::string> files;
+    for (int a = 1; a < argc; ++a)
+    {
+        std::string arg = argv[a];
+        if (arg == "--float")
+            options.single = true;
+        else if (arg == "--namespace" && a + 1 < argc)
+            options.name = argv[++a];
+        else if (arg.rfind("--", 0) == 0)
+            return usage(), 1;
+        else
+            files.push_back(arg);
+    }
+    if (files.size() != 2)
+        return usage(), 1;
+
+    options.model = files[0];
+    options.header = files[1];
+    if (options.name.empty())
+        options.name = identifier_from_path(options.header);
+
+    try
+    {
+        NeuralNetworkFF network(options.model);
+
+        // Generate everything before creating the header, so a network that can not be generated
+        // leaves no half written file behind
+        std::ostringstream ss;
+        write_header(ss, network, options);
+
+        std::ofstream header(options.header);
+        header << ss.str();
+        if (!header)
+            throw std::runtime_error("Could not write " + options.header);
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << options.header << std::endl;
+}